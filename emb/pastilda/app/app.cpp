@@ -57,10 +57,11 @@ App::App()
 			fd::MakeDelegate(_fs, &FileSystem::format_to_FAT12)
 		}
 	};
-	_tildaLogic = new Logic::TildaLogic(_usb_composite->get_usb_deque(),
+	_tildaLogic = new Logic::TildaLogic(_usb_composite->get_usb_ring(),
 								 	 	specialMenuPoints);
 
 	_usb_host = new USB_host(host_keyboard_callback);
+	_tildaLogic->setUnlockYieldCallback(fd::MakeDelegate(this, &App::_unlock_yield));
 	// TODO: fix it
 	delay_ms(6000);  // wait usb device initializing
 	_usb_composite->init_hid_interrupt();
@@ -68,8 +69,24 @@ App::App()
 
 void App::process()
 {
-	_leds_api.toggle();
+	if (_tildaLogic->isUnlocking()) {
+		_leds_api.show_progress(_tildaLogic->getUnlockProgress());
+	}
+	else {
+		_leds_api.toggle();
+	}
+
+	_usb_host->poll();
+	_tildaLogic->poll();
+	_usb_composite->kick_keyboard();  // host's idle period is counted here
+}
+
+void App::_unlock_yield()
+{
+	_leds_api.show_progress(_tildaLogic->getUnlockProgress());
+
 	_usb_host->poll();
+	_usb_composite->kick_keyboard();
 }
 
 void App::host_keyboard_callback(uint8_t *data, uint8_t len)
@@ -54,6 +54,8 @@ namespace Application
 		USB_composite *_usb_composite;
 		USB_host *_usb_host;
 		Logic::TildaLogic* _tildaLogic;
+
+		void _unlock_yield();
 	};
 }
 #endif
@@ -31,7 +31,10 @@ Entry::Entry() :
 		_name(EMPTY_FIELD),
 		_login(EMPTY_FIELD),
 		_password(EMPTY_FIELD),
-		_type(EMPTY_FIELD)
+		_passwordProtected(false),
+		_passwordOffset(0),
+		_type(EMPTY_FIELD),
+		_sequence(EMPTY_FIELD)
 { }
 
 Entry::Entry(size_t index) :
@@ -39,7 +42,10 @@ Entry::Entry(size_t index) :
 		_name(EMPTY_FIELD),
 		_login(EMPTY_FIELD),
 		_password(EMPTY_FIELD),
-		_type(EMPTY_FIELD)
+		_passwordProtected(false),
+		_passwordOffset(0),
+		_type(EMPTY_FIELD),
+		_sequence(EMPTY_FIELD)
 { }
 
 Entry::~Entry()
@@ -51,7 +57,23 @@ Entry::Entry(const Entry& entry)
 	_name = entry.getName();
 	_login = entry.getLogin();
 	_password = entry.getPassword();
+	_passwordProtected = entry.isPasswordProtected();
+	_passwordOffset = entry.getPasswordOffset();
 	_type = entry.getType();
+	_sequence = entry.getSequence();
+}
+
+Entry& Entry::operator=(const Entry& entry)
+{
+	_index = entry.getIndex();
+	_name = entry.getName();
+	_login = entry.getLogin();
+	_password = entry.getPassword();
+	_passwordProtected = entry.isPasswordProtected();
+	_passwordOffset = entry.getPasswordOffset();
+	_type = entry.getType();
+	_sequence = entry.getSequence();
+	return (*this);
 }
 
 void Entry::setIndex(uint32_t index)
@@ -77,10 +99,22 @@ void Entry::setPassword(const uint8_t* password, size_t length)
 	_password.swap(passwordString);
 }
 
+void Entry::setPasswordProtection(bool isProtected, uint32_t offset)
+{
+	_passwordProtected = isProtected;
+	_passwordOffset = offset;
+}
+
 void Entry::setType(const uint8_t* type, size_t length)
 {
 	StringField typeString(type, length);
 	_type.swap(typeString);
 }
 
+void Entry::setSequence(const uint8_t* sequence, size_t length)
+{
+	StringField sequenceString(sequence, length);
+	_sequence.swap(sequenceString);
+}
+
 }
@@ -38,10 +38,10 @@ using StringField = basic_string_view<uint8_t>;
 using StringFieldChar = StringField::value_type;
 using StringFieldConst = const StringField;
 
-constexpr static const StringFieldChar* EMPTY_FIELD_CHAR =
+static const StringFieldChar* const EMPTY_FIELD_CHAR =
 		reinterpret_cast<const StringFieldChar*>("");
 
-constexpr static StringField EMPTY_FIELD(EMPTY_FIELD_CHAR, 1);
+static const StringField EMPTY_FIELD(EMPTY_FIELD_CHAR, 1);
 
 class Entry
 {
@@ -51,12 +51,15 @@ public:
 	~Entry();
 
 	Entry(const Entry& entry);
+	Entry& operator=(const Entry& entry);
 
 	void setIndex(uint32_t index);
 	void setName(const uint8_t* name, size_t length);
 	void setLogin(const uint8_t* login, size_t length);
 	void setPassword(const uint8_t* password, size_t length);
 	void setType(const uint8_t* type, size_t length);
+	void setSequence(const uint8_t* sequence, size_t length);
+	void setPasswordProtection(bool isProtected, uint32_t offset);
 
 	uint32_t getIndex() const {
 		return _index;
@@ -78,13 +81,31 @@ public:
 		return _type;
 	}
 
+	// Auto-Type sequence, empty if neither entry nor groups have it
+	StringFieldConst& getSequence() const {
+		return _sequence;
+	}
+
+	// Protected password is kept encoded and encrypted,
+	// offset is its position in the inner random stream
+	bool isPasswordProtected() const {
+		return _passwordProtected;
+	}
+
+	uint32_t getPasswordOffset() const {
+		return _passwordOffset;
+	}
+
 private:
 	uint32_t _index;
 	StringField _name;
 	StringField _login;
 	StringField _password;
+	bool _passwordProtected;
+	uint32_t _passwordOffset;
 
 	StringField _type;
+	StringField _sequence;
 };
 
 } // namespace DB
@@ -0,0 +1,330 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "EntryStore.h"
+
+namespace DB {
+
+constexpr EntryStore::NodeId EntryStore::NO_NODE;
+constexpr size_t EntryStore::MAX_NODES_COUNT;
+constexpr size_t EntryStore::MAX_STRINGS_COUNT;
+constexpr EntryStore::StringId EntryStore::EMPTY_STRING;
+
+namespace {
+	uint32_t hash(const StringField& text)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (StringFieldChar c : text) {
+			hash = (hash ^ c) * 16777619u;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	T* carve(uint8_t*& block, size_t count)
+	{
+		T* array = reinterpret_cast<T*>(block);
+		block += count * sizeof(T);
+		return array;
+	}
+}
+
+EntryStore::EntryStore() :
+	_block(nullptr),
+	_blockSize(0),
+	_nodesCount(0),
+	_stringsCount(0),
+	_arenaSize(0)
+{
+	clear();
+}
+
+EntryStore::~EntryStore()
+{
+	clear();
+}
+
+void EntryStore::clear()
+{
+	// Arena may keep protected values, it's wiped before freeing
+	if (_block != nullptr) {
+		volatile uint8_t* block = _block;
+		for (size_t i = 0; i < _blockSize; ++i) {
+			block[i] = 0;
+		}
+	}
+	std::free(_block);
+
+	_block = nullptr;
+	_blockSize = 0;
+	_nodesCount = 0;
+	_stringsCount = 0;
+	_arenaSize = 0;
+
+	_passwordOffset = nullptr;
+	_stringOffset = nullptr;
+	_parent = _firstChild = _next = _prev = nullptr;
+	_name = _login = _password = _type = _sequence = nullptr;
+	_stringLength = nullptr;
+	_flags = nullptr;
+	_arena = nullptr;
+}
+
+bool EntryStore::build(const XmlIndex& index)
+{
+	clear();
+
+	size_t nodesCount = index.getRecordsCount();
+	if (nodesCount == 0 || nodesCount > MAX_NODES_COUNT) {
+		return false;
+	}
+
+	// Only non-empty fields take strings, the store is allocated
+	// for all of them being unique and shrunk after deduplication
+	size_t fieldsCount = 0;
+	size_t textSize = 0;
+	for (size_t i = 0; i < nodesCount; ++i) {
+		const XmlIndex::Record& record = index.getRecord(i);
+		const XmlIndex::Field* fields[] = {
+			&record.name, &record.login, &record.password,
+			&record.type, &record.sequence
+		};
+
+		for (const XmlIndex::Field* field : fields) {
+			if (field->length > UINT16_MAX) {
+				return false;
+			}
+			if (field->length != 0) {
+				fieldsCount++;
+				textSize += field->length;
+			}
+		}
+	}
+
+	size_t stringsCount = fieldsCount + 1;
+	if (stringsCount > MAX_STRINGS_COUNT) {
+		stringsCount = MAX_STRINGS_COUNT;
+	}
+
+	// Open addressing table of string ids, zero id marks a free slot
+	size_t slotsCount = 2;
+	while (slotsCount < stringsCount * 2) {
+		slotsCount <<= 1;
+	}
+	StringId* slots = static_cast<StringId*>(std::calloc(slotsCount, sizeof(StringId)));
+
+	bool result = (slots != nullptr &&
+				   _allocate(nodesCount, stringsCount, textSize));
+
+	if (result) {
+		// Empty string always has zero id
+		_stringOffset[0] = 0;
+		_stringLength[0] = 0;
+		_stringsCount = 1;
+		_arenaSize = 0;
+	}
+
+	// Record ids fit into node ids, NO_RECORD becomes NO_NODE.
+	// Protected passwords are left unique, they are revealed by offset.
+	for (size_t i = 0; i < nodesCount && result; ++i) {
+		const XmlIndex::Record& record = index.getRecord(i);
+
+		_parent[i] = (NodeId)record.parent;
+		_firstChild[i] = (NodeId)record.firstChild;
+		_next[i] = (NodeId)record.next;
+		_prev[i] = (NodeId)record.prev;
+
+		_passwordOffset[i] = record.passwordOffset;
+		_flags[i] = 0;
+		if (record.kind == XmlIndex::Kind::ENTRY) {
+			_flags[i] |= ENTRY_FLAG;
+		}
+		if (record.isPasswordProtected) {
+			_flags[i] |= PROTECTED_FLAG;
+		}
+
+		result = _addString(index.getField(record.name), true, slots, slotsCount, &_name[i]) &&
+				 _addString(index.getField(record.login), true, slots, slotsCount, &_login[i]) &&
+				 _addString(index.getField(record.password), !record.isPasswordProtected,
+							slots, slotsCount, &_password[i]) &&
+				 _addString(index.getField(record.type), true, slots, slotsCount, &_type[i]) &&
+				 _addString(index.getField(record.sequence), true, slots, slotsCount, &_sequence[i]);
+	}
+
+	std::free(slots);
+
+	if (result) {
+		_shrink();
+	}
+	else {
+		clear();
+	}
+
+	return result;
+}
+
+StringField EntryStore::findSequence(NodeId node) const
+{
+	// Entry without own sequence takes the nearest group's one
+	while (node != NO_NODE && _sequence[node] == EMPTY_STRING) {
+		node = _parent[node];
+	}
+
+	return ((node == NO_NODE) ? StringField() : _getString(_sequence[node]));
+}
+
+bool EntryStore::_allocate(size_t nodesCount,
+						   size_t stringsCount,
+						   size_t arenaSize)
+{
+	size_t blockSize = _carve(nullptr, nodesCount, stringsCount, arenaSize);
+
+	_block = static_cast<uint8_t*>(std::malloc(blockSize));
+	if (_block == nullptr) {
+		return false;
+	}
+
+	_blockSize = blockSize;
+	_nodesCount = nodesCount;
+	_stringsCount = stringsCount;
+	_arenaSize = arenaSize;
+	_carve(_block, nodesCount, stringsCount, arenaSize);
+
+	return true;
+}
+
+size_t EntryStore::_carve(uint8_t* block,
+						  size_t nodesCount,
+						  size_t stringsCount,
+						  size_t arenaSize)
+{
+	// Arrays are placed from the widest type to keep them aligned
+	size_t blockSize =
+			(nodesCount + stringsCount) * sizeof(uint32_t) +
+			nodesCount * 9 * sizeof(uint16_t) +
+			stringsCount * sizeof(uint16_t) +
+			nodesCount * sizeof(uint8_t) +
+			arenaSize;
+
+	if (block != nullptr) {
+		_passwordOffset = carve<uint32_t>(block, nodesCount);
+		_stringOffset = carve<uint32_t>(block, stringsCount);
+		_parent = carve<NodeId>(block, nodesCount);
+		_firstChild = carve<NodeId>(block, nodesCount);
+		_next = carve<NodeId>(block, nodesCount);
+		_prev = carve<NodeId>(block, nodesCount);
+		_name = carve<StringId>(block, nodesCount);
+		_login = carve<StringId>(block, nodesCount);
+		_password = carve<StringId>(block, nodesCount);
+		_type = carve<StringId>(block, nodesCount);
+		_sequence = carve<StringId>(block, nodesCount);
+		_stringLength = carve<uint16_t>(block, stringsCount);
+		_flags = carve<uint8_t>(block, nodesCount);
+		_arena = carve<uint8_t>(block, arenaSize);
+	}
+
+	return blockSize;
+}
+
+void EntryStore::_shrink()
+{
+	size_t blockSize = _carve(nullptr, _nodesCount, _stringsCount, _arenaSize);
+	if (blockSize == _blockSize) {
+		return;
+	}
+
+	// Arrays after the string offsets only move down: node arrays,
+	// string lengths, then flags with the arena are moved in order
+	uint8_t* nodeArrays = reinterpret_cast<uint8_t*>(_parent);
+	uint8_t* stringLength = reinterpret_cast<uint8_t*>(_stringLength);
+	uint8_t* flags = _flags;
+
+	_carve(_block, _nodesCount, _stringsCount, _arenaSize);
+
+	std::memmove(_parent, nodeArrays, _nodesCount * 9 * sizeof(uint16_t));
+	std::memmove(_stringLength, stringLength, _stringsCount * sizeof(uint16_t));
+	std::memmove(_flags, flags, _nodesCount * sizeof(uint8_t) + _arenaSize);
+
+	// Tail may keep protected values, it's wiped before it's given back
+	volatile uint8_t* tail = _block;
+	for (size_t i = blockSize; i < _blockSize; ++i) {
+		tail[i] = 0;
+	}
+
+	uint8_t* block = static_cast<uint8_t*>(std::realloc(_block, blockSize));
+	if (block != nullptr) {
+		_block = block;
+		_carve(_block, _nodesCount, _stringsCount, _arenaSize);
+	}
+	_blockSize = blockSize;
+}
+
+bool EntryStore::_addString(const StringField& text,
+							bool isShared,
+							StringId* slots,
+							size_t slotsCount,
+							StringId* id)
+{
+	if (text.empty()) {
+		*id = EMPTY_STRING;
+		return true;
+	}
+
+	size_t mask = slotsCount - 1;
+	StringId* slot = nullptr;
+
+	if (isShared) {
+		for (slot = &slots[hash(text) & mask];
+			 *slot != EMPTY_STRING;
+			 slot = &slots[(slot - slots + 1) & mask])
+		{
+			if (_getString(*slot) == text) {
+				*id = *slot;
+				return true;
+			}
+		}
+	}
+
+	if (_stringsCount == MAX_STRINGS_COUNT) {
+		return false;
+	}
+
+	*id = _stringsCount++;
+	std::memcpy(&_arena[_arenaSize], text.data(), text.length());
+	_stringOffset[*id] = _arenaSize;
+	_stringLength[*id] = text.length();
+	_arenaSize += text.length();
+
+	if (slot != nullptr) {
+		*slot = *id;
+	}
+
+	return true;
+}
+
+}
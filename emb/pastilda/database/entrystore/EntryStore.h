@@ -0,0 +1,155 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_ENTRYSTORE_ENTRYSTORE_H_
+#define DATABASE_ENTRYSTORE_ENTRYSTORE_H_
+
+#include <DbEntry.h>
+#include <database/xmlindex/XmlIndex.h>
+
+namespace DB {
+
+// Immutable store of groups and entries made from XmlIndex after parsing.
+// Nodes are kept in index-linked arrays and all strings are kept
+// in one deduplicated arena, so the index can be freed.
+class EntryStore {
+public:
+	using NodeId = uint16_t;
+	using StringId = uint16_t;
+
+	static constexpr NodeId NO_NODE = UINT16_MAX;
+	static constexpr size_t MAX_NODES_COUNT = UINT16_MAX;
+	static constexpr size_t MAX_STRINGS_COUNT = UINT16_MAX + 1;
+	static constexpr StringId EMPTY_STRING = 0;
+
+	EntryStore();
+	~EntryStore();
+
+	bool build(const XmlIndex& index);
+	void clear();
+
+	size_t getNodesCount() const {
+		return _nodesCount;
+	}
+
+	size_t getStringsCount() const {
+		return _stringsCount;
+	}
+
+	size_t getUsedMemory() const {
+		return _blockSize;
+	}
+
+	NodeId getParent(NodeId node) const {
+		return _parent[node];
+	}
+
+	NodeId getFirstChild(NodeId node) const {
+		return _firstChild[node];
+	}
+
+	NodeId getNext(NodeId node) const {
+		return _next[node];
+	}
+
+	NodeId getPrev(NodeId node) const {
+		return _prev[node];
+	}
+
+	bool isEntry(NodeId node) const {
+		return ((_flags[node] & ENTRY_FLAG) != 0);
+	}
+
+	bool isPasswordProtected(NodeId node) const {
+		return ((_flags[node] & PROTECTED_FLAG) != 0);
+	}
+
+	uint32_t getPasswordOffset(NodeId node) const {
+		return _passwordOffset[node];
+	}
+
+	StringField getName(NodeId node) const {
+		return _getString(_name[node]);
+	}
+
+	StringField getLogin(NodeId node) const {
+		return _getString(_login[node]);
+	}
+
+	StringField getPassword(NodeId node) const {
+		return _getString(_password[node]);
+	}
+
+	StringField getType(NodeId node) const {
+		return _getString(_type[node]);
+	}
+
+	StringField getSequence(NodeId node) const {
+		return _getString(_sequence[node]);
+	}
+
+	StringField findSequence(NodeId node) const;
+
+private:
+	static constexpr uint8_t ENTRY_FLAG = (1 << 0);
+	static constexpr uint8_t PROTECTED_FLAG = (1 << 1);
+
+	// All arrays are parts of one allocated block
+	uint8_t* _block;
+	size_t _blockSize;
+	size_t _nodesCount;
+	size_t _stringsCount;
+	size_t _arenaSize;
+
+	uint32_t* _passwordOffset;
+	uint32_t* _stringOffset;
+	NodeId* _parent;
+	NodeId* _firstChild;
+	NodeId* _next;
+	NodeId* _prev;
+	StringId* _name;
+	StringId* _login;
+	StringId* _password;
+	StringId* _type;
+	StringId* _sequence;
+	uint16_t* _stringLength;
+	uint8_t* _flags;
+	uint8_t* _arena;
+
+	EntryStore(const EntryStore&);
+
+	bool _allocate(size_t nodesCount, size_t stringsCount, size_t arenaSize);
+	size_t _carve(uint8_t* block, size_t nodesCount, size_t stringsCount, size_t arenaSize);
+	void _shrink();
+	bool _addString(const StringField& text, bool isShared,
+					StringId* slots, size_t slotsCount, StringId* id);
+
+	StringField _getString(StringId id) const {
+		return StringField(&_arena[_stringOffset[id]], _stringLength[id]);
+	}
+};
+
+}
+
+#endif /* DATABASE_ENTRYSTORE_ENTRYSTORE_H_ */
@@ -0,0 +1,336 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include "FuzzyMatcher.h"
+
+namespace DB {
+
+constexpr size_t FuzzyMatcher::MAX_QUERY_LENGTH;
+constexpr size_t FuzzyMatcher::MAX_RESULTS_COUNT;
+constexpr size_t FuzzyMatcher::MAX_HAYSTACK_LENGTH;
+constexpr int16_t FuzzyMatcher::SCORE_MATCH;
+constexpr int16_t FuzzyMatcher::BONUS_BOUNDARY;
+constexpr int16_t FuzzyMatcher::BONUS_CONSECUTIVE;
+constexpr int16_t FuzzyMatcher::BONUS_FIRST_CHAR;
+constexpr int16_t FuzzyMatcher::PENALTY_GAP;
+constexpr uint8_t FuzzyMatcher::SEPARATOR;
+
+namespace {
+	inline bool isLower(uint8_t symbol) {
+		return (symbol >= 'a' && symbol <= 'z');
+	}
+
+	inline bool isUpper(uint8_t symbol) {
+		return (symbol >= 'A' && symbol <= 'Z');
+	}
+
+	inline bool isDigit(uint8_t symbol) {
+		return (symbol >= '0' && symbol <= '9');
+	}
+
+	inline uint8_t fold(uint8_t symbol) {
+		return (isUpper(symbol) ? symbol + ('a' - 'A') : symbol);
+	}
+}
+
+FuzzyMatcher::FuzzyMatcher() :
+	_store(nullptr),
+	_candidates(nullptr),
+	_entriesCount(0),
+	_queryLength(0),
+	_resultsCount(0),
+	_haystackLength(0)
+{
+	reset();
+}
+
+FuzzyMatcher::~FuzzyMatcher()
+{
+	clear();
+}
+
+bool FuzzyMatcher::build(const EntryStore* store)
+{
+	clear();
+
+	if (store == nullptr) {
+		return false;
+	}
+
+	size_t nodesCount = store->getNodesCount();
+	_candidates = static_cast<NodeId*>(std::malloc(nodesCount * sizeof(NodeId)));
+	if (_candidates == nullptr) {
+		return false;
+	}
+
+	_store = store;
+
+	for (size_t node = 0; node < nodesCount; ++node) {
+		if (store->isEntry(node)) {
+			_candidates[_entriesCount++] = node;
+		}
+	}
+
+	reset();
+	return true;
+}
+
+void FuzzyMatcher::clear()
+{
+	std::free(_candidates);
+
+	_store = nullptr;
+	_candidates = nullptr;
+	_entriesCount = 0;
+
+	reset();
+}
+
+void FuzzyMatcher::reset()
+{
+	_queryLength = 0;
+	_survivors[0] = _entriesCount;
+	_resultsCount = 0;
+}
+
+size_t FuzzyMatcher::search(const uint8_t* query, size_t length)
+{
+	// Spaces only split words of query
+	size_t common = 0;
+	size_t pos = 0;
+	for (; pos < length; ++pos) {
+		if (query[pos] == ' ') {
+			continue;
+		}
+		if (common == _queryLength || fold(query[pos]) != _query[common]) {
+			break;
+		}
+		common++;
+	}
+
+	bool isChanged = (common != _queryLength);
+	_queryLength = common;
+
+	for (; pos < length && _queryLength < MAX_QUERY_LENGTH; ++pos) {
+		if (query[pos] == ' ') {
+			continue;
+		}
+
+		_query[_queryLength] = fold(query[pos]);
+		_survivors[_queryLength + 1] = _survivors[_queryLength];
+		_queryLength++;
+
+		_filter();
+		isChanged = false;
+	}
+
+	// Shorter query takes stored survivors, they are only ranked again
+	if (isChanged) {
+		_rank();
+	}
+
+	return _resultsCount;
+}
+
+void FuzzyMatcher::_filter()
+{
+	size_t& count = _survivors[_queryLength];
+	_resultsCount = 0;
+
+	for (size_t i = 0; i < count; ) {
+		NodeId node = _candidates[i];
+		int16_t score;
+
+		_fillHaystack(node);
+		if (_score(&score)) {
+			_addResult(node, score);
+			++i;
+		}
+		else {
+			// Lost candidate is kept for shorter queries
+			count--;
+			_candidates[i] = _candidates[count];
+			_candidates[count] = node;
+		}
+	}
+}
+
+void FuzzyMatcher::_rank()
+{
+	_resultsCount = 0;
+
+	if (_queryLength == 0) {
+		return;
+	}
+
+	for (size_t i = 0; i < _survivors[_queryLength]; ++i) {
+		int16_t score;
+
+		_fillHaystack(_candidates[i]);
+		if (_score(&score)) {
+			_addResult(_candidates[i], score);
+		}
+	}
+}
+
+void FuzzyMatcher::_fillHaystack(NodeId node)
+{
+	// Group path from the top, root group isn't a part of it
+	NodeId path[XmlIndex::MAX_GROUP_DEPTH];
+	size_t depth = 0;
+
+	NodeId parent = _store->getParent(node);
+	while (parent != EntryStore::NO_NODE && depth < XmlIndex::MAX_GROUP_DEPTH) {
+		path[depth++] = parent;
+		parent = _store->getParent(parent);
+	}
+
+	_haystackLength = 0;
+	for (size_t level = (depth > 0) ? depth - 1 : 0; level > 0; --level) {
+		_appendHaystack(_store->getName(path[level - 1]));
+	}
+
+	_appendHaystack(_store->getName(node));
+	_appendHaystack(_store->getLogin(node));
+}
+
+void FuzzyMatcher::_appendHaystack(const StringField& string)
+{
+	if (_haystackLength > 0 && _haystackLength < MAX_HAYSTACK_LENGTH) {
+		_haystack[_haystackLength++] = SEPARATOR;
+	}
+
+	size_t length = string.length();
+	if (length > MAX_HAYSTACK_LENGTH - _haystackLength) {
+		length = MAX_HAYSTACK_LENGTH - _haystackLength;
+	}
+
+	std::memcpy(&_haystack[_haystackLength], string.data(), length);
+	_haystackLength += length;
+}
+
+bool FuzzyMatcher::_isBoundary(size_t pos) const
+{
+	if (pos == 0) {
+		return true;
+	}
+
+	uint8_t previous = _haystack[pos - 1];
+	uint8_t current = _haystack[pos];
+
+	if (isLower(previous) || isDigit(previous)) {
+		return (isUpper(current));  // camelCase
+	}
+
+	return (isUpper(previous) == false);
+}
+
+bool FuzzyMatcher::_score(int16_t* score) const
+{
+	// The first full match gives the end,
+	// backward pass from the end gives the shortest window
+	size_t end = 0;
+	size_t matched = 0;
+	for (; end < _haystackLength && matched < _queryLength; ++end) {
+		if (fold(_haystack[end]) == _query[matched]) {
+			matched++;
+		}
+	}
+
+	if (matched < _queryLength) {
+		return false;
+	}
+
+	size_t start = end;
+	while (matched > 0) {
+		start--;
+		if (fold(_haystack[start]) == _query[matched - 1]) {
+			matched--;
+		}
+	}
+
+	int16_t result = 0;
+	size_t lastMatch = start;
+	for (size_t pos = start; pos < end && matched < _queryLength; ++pos) {
+		if (fold(_haystack[pos]) != _query[matched]) {
+			result -= PENALTY_GAP;
+			continue;
+		}
+
+		result += SCORE_MATCH;
+		if (_isBoundary(pos)) {
+			result += BONUS_BOUNDARY;
+			if (matched == 0) {
+				result += BONUS_FIRST_CHAR;
+			}
+		}
+		if (matched > 0 && pos == lastMatch + 1) {
+			result += BONUS_CONSECUTIVE;
+		}
+
+		lastMatch = pos;
+		matched++;
+	}
+
+	*score = result;
+	return true;
+}
+
+void FuzzyMatcher::_addResult(NodeId node, int16_t score)
+{
+	Result result = {node, score, static_cast<uint16_t>(_haystackLength)};
+
+	auto isBetter = [](const Result& lhs, const Result& rhs) -> bool {
+		if (lhs.score != rhs.score) {
+			return (lhs.score > rhs.score);
+		}
+		if (lhs.length != rhs.length) {
+			return (lhs.length < rhs.length);
+		}
+		return (lhs.node < rhs.node);
+	};
+
+	size_t pos = _resultsCount;
+	if (_resultsCount < MAX_RESULTS_COUNT) {
+		_resultsCount++;
+	}
+	else if (isBetter(result, _results[pos - 1])) {
+		pos--;
+	}
+	else {
+		return;
+	}
+
+	// Results are kept sorted, best is first
+	while (pos > 0 && isBetter(result, _results[pos - 1])) {
+		_results[pos] = _results[pos - 1];
+		pos--;
+	}
+	_results[pos] = result;
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_SEARCHINDEX_FUZZYMATCHER_H_
+#define DATABASE_SEARCHINDEX_FUZZYMATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <DbEntry.h>
+#include <database/entrystore/EntryStore.h>
+
+using std::size_t;
+
+namespace DB {
+
+// Fuzzy search over group path, title and username of all entries.
+// Query chars must be found in this order, matches on word
+// boundaries and contiguous matches are ranked higher.
+// Each new char filters only survivors of the previous query,
+// only the best MAX_RESULTS_COUNT entries are kept.
+// Search mode asks it only when SearchIndex has no prefix match.
+class FuzzyMatcher {
+public:
+	using NodeId = EntryStore::NodeId;
+
+	static constexpr size_t MAX_QUERY_LENGTH = 32;
+	static constexpr size_t MAX_RESULTS_COUNT = 8;
+	static constexpr size_t MAX_HAYSTACK_LENGTH = 128;
+
+	FuzzyMatcher();
+	~FuzzyMatcher();
+
+	bool build(const EntryStore* store);
+	void clear();
+
+	// Query is compared with the last one,
+	// only changed tail filters survivors
+	size_t search(const uint8_t* query, size_t length);
+	void reset();
+
+	size_t getResultsCount() const {
+		return _resultsCount;
+	}
+
+	NodeId getResult(size_t num) const {
+		return ((num < _resultsCount) ? _results[num].node : EntryStore::NO_NODE);
+	}
+
+	size_t getSurvivorsCount() const {
+		return _survivors[_queryLength];
+	}
+
+	size_t getUsedMemory() const {
+		return (_entriesCount * sizeof(NodeId));
+	}
+
+private:
+	static constexpr int16_t SCORE_MATCH = 16;
+	static constexpr int16_t BONUS_BOUNDARY = 8;
+	static constexpr int16_t BONUS_CONSECUTIVE = 8;
+	static constexpr int16_t BONUS_FIRST_CHAR = 8;
+	static constexpr int16_t PENALTY_GAP = 1;
+	static constexpr uint8_t SEPARATOR = 0;
+
+	struct Result {
+		NodeId node;
+		int16_t score;
+		uint16_t length;
+	};
+
+	const EntryStore* _store;
+
+	// Survivors of query of each length are first _survivors[length]
+	// candidates, the rest are moved behind them
+	NodeId* _candidates;
+	size_t _entriesCount;
+	size_t _survivors[MAX_QUERY_LENGTH + 1];
+
+	uint8_t _query[MAX_QUERY_LENGTH];
+	size_t _queryLength;
+
+	Result _results[MAX_RESULTS_COUNT];
+	size_t _resultsCount;
+
+	uint8_t _haystack[MAX_HAYSTACK_LENGTH];
+	size_t _haystackLength;
+
+	FuzzyMatcher(const FuzzyMatcher&);
+
+	void _filter();
+	void _rank();
+
+	void _fillHaystack(NodeId node);
+	void _appendHaystack(const StringField& string);
+	bool _isBoundary(size_t pos) const;
+	bool _score(int16_t* score) const;
+	void _addResult(NodeId node, int16_t score);
+};
+
+}
+
+#endif /* DATABASE_SEARCHINDEX_FUZZYMATCHER_H_ */
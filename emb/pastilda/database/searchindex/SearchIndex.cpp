@@ -0,0 +1,258 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "SearchIndex.h"
+
+namespace DB {
+
+constexpr size_t SearchIndex::MAX_PREFIX_LENGTH;
+constexpr SearchIndex::Key SearchIndex::LOGIN_FIELD;
+constexpr SearchIndex::Key SearchIndex::NODE_MASK;
+constexpr unsigned SearchIndex::SHARED_SHIFT;
+constexpr uint32_t SearchIndex::NOT_COUNTED;
+
+namespace {
+	inline uint8_t fold(uint8_t symbol) {
+		return ((symbol >= 'A' && symbol <= 'Z') ? symbol + ('a' - 'A') : symbol);
+	}
+}
+
+SearchIndex::SearchIndex() :
+	_store(nullptr),
+	_keys(nullptr),
+	_keysCount(0),
+	_prefixLength(0)
+{
+	clear();
+}
+
+SearchIndex::~SearchIndex()
+{
+	clear();
+}
+
+bool SearchIndex::build(const EntryStore* store)
+{
+	clear();
+
+	if (store == nullptr) {
+		return false;
+	}
+
+	size_t maxCount = store->getNodesCount() * 2;
+	_keys = static_cast<Key*>(std::malloc(maxCount * sizeof(Key)));
+	if (_keys == nullptr) {
+		return false;
+	}
+
+	_store = store;
+
+	for (size_t node = 0; node < store->getNodesCount(); ++node) {
+		if (store->isEntry(node) == false) {
+			continue;
+		}
+
+		Key key = node << 1;
+		StringField title = store->getName(node);
+		StringField login = store->getLogin(node);
+		if (title.empty() == false) {
+			_keys[_keysCount++] = key;
+		}
+		if (login.empty() == false) {
+			_keys[_keysCount++] = key | LOGIN_FIELD | _shared(title, login);
+		}
+	}
+
+	std::sort(_keys, _keys + _keysCount, [this](Key lhs, Key rhs) {
+		return _less(lhs, rhs);
+	});
+
+	reset();
+	_ranges[0].last = static_cast<uint32_t>(_keysCount);
+	_ranges[0].count = NOT_COUNTED;
+	return true;
+}
+
+void SearchIndex::clear()
+{
+	std::free(_keys);
+
+	_store = nullptr;
+	_keys = nullptr;
+	_keysCount = 0;
+
+	reset();
+	_ranges[0] = {0, 0, 0};
+}
+
+void SearchIndex::reset()
+{
+	// Range of the empty prefix is set by build()
+	_prefixLength = 0;
+}
+
+bool SearchIndex::search(const uint8_t* prefix, size_t length)
+{
+	if (length > MAX_PREFIX_LENGTH) {
+		length = MAX_PREFIX_LENGTH;
+	}
+
+	// Ranges of common part are still valid
+	size_t common = 0;
+	while (common < length && common < _prefixLength &&
+		   fold(prefix[common]) == _prefix[common])
+	{
+		common++;
+	}
+	_prefixLength = common;
+
+	while (_prefixLength < length) {
+		_narrow(fold(prefix[_prefixLength]));
+	}
+
+	// Login key is skipped only with its title in the range
+	const Range& range = _ranges[_prefixLength];
+	return (range.first != range.last);
+}
+
+size_t SearchIndex::getMatchesCount() const
+{
+	const Range& range = _ranges[_prefixLength];
+	if (range.count == NOT_COUNTED) {
+		range.count = _countNodes(range.first, range.last);
+	}
+
+	return (range.count);
+}
+
+SearchIndex::NodeId SearchIndex::getMatch(size_t num) const
+{
+	if (num >= getMatchesCount()) {
+		return EntryStore::NO_NODE;
+	}
+
+	// Logins of nodes found by title are skipped
+	const Range& range = _ranges[_prefixLength];
+	for (uint32_t i = range.first; i < range.last; ++i) {
+		if (_isDuplicate(_keys[i])) {
+			continue;
+		}
+		if (num-- == 0) {
+			return ((_keys[i] & NODE_MASK) >> 1);
+		}
+	}
+
+	return EntryStore::NO_NODE;
+}
+
+void SearchIndex::_narrow(uint8_t symbol)
+{
+	const Range& range = _ranges[_prefixLength];
+	size_t pos = _prefixLength;
+
+	// All keys of range have the same first pos chars,
+	// so they are sorted by char at pos
+	Key* first = std::lower_bound(_keys + range.first, _keys + range.last,
+			symbol, [this, pos](Key key, int value) {
+				return (_getChar(key, pos) < value);
+			});
+	Key* last = std::upper_bound(first, _keys + range.last,
+			symbol, [this, pos](int value, Key key) {
+				return (value < _getChar(key, pos));
+			});
+
+	_prefix[_prefixLength++] = symbol;
+
+	Range& narrowed = _ranges[_prefixLength];
+	narrowed.first = static_cast<uint32_t>(first - _keys);
+	narrowed.last = static_cast<uint32_t>(last - _keys);
+	narrowed.count = NOT_COUNTED;
+}
+
+uint32_t SearchIndex::_countNodes(uint32_t first, uint32_t last) const
+{
+	uint32_t count = 0;
+	for (uint32_t i = first; i < last; ++i) {
+		count += (_isDuplicate(_keys[i]) ? 0 : 1);
+	}
+
+	return (count);
+}
+
+SearchIndex::Key SearchIndex::_shared(StringField title, StringField login)
+{
+	if (title.empty()) {
+		return 0;
+	}
+
+	// Longer prefixes are never searched
+	size_t length = std::min(std::min(title.length(), login.length()), MAX_PREFIX_LENGTH);
+	Key shared = 0;
+	while (shared < length && fold(title[shared]) == fold(login[shared])) {
+		shared++;
+	}
+
+	return ((shared + 1) << SHARED_SHIFT);
+}
+
+StringField SearchIndex::_getString(Key key) const
+{
+	NodeId node = (key & NODE_MASK) >> 1;
+	return ((key & LOGIN_FIELD) ? _store->getLogin(node) : _store->getName(node));
+}
+
+int SearchIndex::_getChar(Key key, size_t pos) const
+{
+	StringField string = _getString(key);
+
+	// End of string is less than any char
+	return ((pos < string.length()) ? fold(string[pos]) : -1);
+}
+
+bool SearchIndex::_less(Key lhs, Key rhs) const
+{
+	StringField lhsString = _getString(lhs);
+	StringField rhsString = _getString(rhs);
+	size_t length = std::min(lhsString.length(), rhsString.length());
+
+	for (size_t i = 0; i < length; ++i) {
+		uint8_t lhsChar = fold(lhsString[i]);
+		uint8_t rhsChar = fold(rhsString[i]);
+		if (lhsChar != rhsChar) {
+			return (lhsChar < rhsChar);
+		}
+	}
+
+	// Equal keys are kept in store order, titles first
+	if (lhsString.length() != rhsString.length()) {
+		return (lhsString.length() < rhsString.length());
+	}
+	return ((lhs & NODE_MASK) < (rhs & NODE_MASK));
+}
+
+}
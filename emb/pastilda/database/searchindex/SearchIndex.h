@@ -0,0 +1,119 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_SEARCHINDEX_SEARCHINDEX_H_
+#define DATABASE_SEARCHINDEX_SEARCHINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <DbEntry.h>
+#include <database/entrystore/EntryStore.h>
+
+using std::size_t;
+
+namespace DB {
+
+// Prefix search over titles and usernames of all entries.
+// Keys are sorted once by case-folded string, every typed char
+// narrows the range of the previous char by binary search.
+class SearchIndex {
+public:
+	using NodeId = EntryStore::NodeId;
+
+	static constexpr size_t MAX_PREFIX_LENGTH = 64;
+
+	SearchIndex();
+	~SearchIndex();
+
+	bool build(const EntryStore* store);
+	void clear();
+
+	// Prefix is compared with the last one,
+	// only changed tail is searched.
+	// True if any entry matches.
+	bool search(const uint8_t* prefix, size_t length);
+	void reset();
+
+	// Entries are counted on the first call for the prefix
+	size_t getMatchesCount() const;
+
+	NodeId getMatch(size_t num) const;
+
+	NodeId getBestMatch() const {
+		return (getMatch(0));
+	}
+
+	size_t getKeysCount() const {
+		return _keysCount;
+	}
+
+	size_t getUsedMemory() const {
+		return (_keysCount * sizeof(Key));
+	}
+
+private:
+	// Node id and field of node, login keys also keep the length
+	// of prefix shared with the title plus one (0 without title):
+	// while the title matches too, the login key is skipped
+	using Key = uint32_t;
+
+	static constexpr Key LOGIN_FIELD = 1;
+	static constexpr Key NODE_MASK = 0x1FFFF;
+	static constexpr unsigned SHARED_SHIFT = 17;
+
+	static constexpr uint32_t NOT_COUNTED = UINT32_MAX;
+
+	struct Range {
+		uint32_t first;
+		uint32_t last;
+		mutable uint32_t count;  // distinct nodes
+	};
+
+	const EntryStore* _store;
+	Key* _keys;
+	size_t _keysCount;
+
+	uint8_t _prefix[MAX_PREFIX_LENGTH];
+	Range _ranges[MAX_PREFIX_LENGTH + 1];
+	size_t _prefixLength;
+
+	SearchIndex(const SearchIndex&);
+
+	StringField _getString(Key key) const;
+	int _getChar(Key key, size_t pos) const;
+	bool _less(Key lhs, Key rhs) const;
+	void _narrow(uint8_t symbol);
+	uint32_t _countNodes(uint32_t first, uint32_t last) const;
+
+	bool _isDuplicate(Key key) const {
+		return (_prefixLength < (key >> SHARED_SHIFT));
+	}
+
+	static Key _shared(StringField title, StringField login);
+};
+
+}
+
+#endif /* DATABASE_SEARCHINDEX_SEARCHINDEX_H_ */
@@ -0,0 +1,370 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+
+#include <lib/crypto/base64.h>
+
+#include "XmlIndex.h"
+
+namespace DB {
+
+constexpr XmlIndex::RecordId XmlIndex::NO_RECORD;
+constexpr size_t XmlIndex::MAX_GROUP_DEPTH;
+
+XmlIndex::XmlIndex():
+	_records(nullptr),
+	_recordsCount(0),
+	_recordsCapacity(0),
+	_arena(nullptr),
+	_arenaSize(0),
+	_arenaCapacity(0)
+{
+	clear();
+}
+
+XmlIndex::~XmlIndex()
+{
+	clear();
+}
+
+void XmlIndex::clear()
+{
+	std::free(_records);
+	_records = nullptr;
+	_recordsCount = 0;
+	_recordsCapacity = 0;
+
+	// Arena may keep protected values, it's wiped before freeing
+	if (_arena != nullptr) {
+		volatile uint8_t* arena = _arena;
+		for (size_t i = 0; i < _arenaCapacity; ++i) {
+			arena[i] = 0;
+		}
+	}
+	std::free(_arena);
+	_arena = nullptr;
+	_arenaSize = 0;
+	_arenaCapacity = 0;
+
+	_stackSize = 0;
+	_depth = 0;
+	_protectedDepth = 0;
+	_streamOffset = 0;
+	_capture = Capture::NONE;
+	_entryChild = XmlWord::UNKNOWN;
+	_key = XmlWord::UNKNOWN;
+	_complete = false;
+	_failed = false;
+}
+
+StringField XmlIndex::getField(const Field& field) const
+{
+	if (field.length == 0) {
+		return StringField();
+	}
+
+	return StringField(&_arena[field.offset], field.length);
+}
+
+mxml_type_t XmlIndex::typeCallback(mxml_node_t* parent)
+{
+	// Elements which text is needed were marked when opened,
+	// mxml doesn't allocate nodes for other text and whitespaces
+	if (mxmlGetUserData(parent) != NULL) {
+		return (MXML_OPAQUE);
+	}
+
+	return (MXML_IGNORE);
+}
+
+void XmlIndex::saxCallback(mxml_node_t* node,
+						   mxml_sax_event_t event,
+						   void* data)
+{
+	XmlIndex* index = static_cast<XmlIndex*>(data);
+
+	switch (event) {
+		case MXML_SAX_ELEMENT_OPEN:
+			index->_openElement(node);
+		break;
+
+		case MXML_SAX_ELEMENT_CLOSE:
+			index->_closeElement();
+		break;
+
+		case MXML_SAX_DATA:
+			index->_addData(node);
+		break;
+
+		default:
+		break;
+	}
+}
+
+void XmlIndex::_openElement(mxml_node_t* node)
+{
+	XmlWord tag = XmlVocabulary::find(mxmlGetElement(node));
+	bool isProtected = _isProtected(node);
+
+	_depth++;
+	_capture = Capture::NONE;
+
+	// Protected values are encrypted by one inner stream in document
+	// order, so all of them move the stream offset, wherever they are
+	if (isProtected) {
+		_protectedDepth = _depth;
+	}
+
+	if (_stackSize > 0 && _top().kind == Kind::ENTRY) {
+		// <Entry><String><Key/><Value/></String></Entry>,
+		// <Entry><AutoType><DefaultSequence/></AutoType></Entry>,
+		// history entries are skipped
+		size_t entryDepth = _stackDepth[_stackSize - 1];
+
+		if (_depth == entryDepth + 1) {
+			_entryChild = tag;
+			_key = XmlWord::UNKNOWN;
+		}
+		else if (_depth == entryDepth + 2) {
+			if (_entryChild == XmlWord::STRING && tag == XmlWord::KEY) {
+				_capture = Capture::KEY;
+			}
+			else if (_entryChild == XmlWord::STRING && tag == XmlWord::VALUE) {
+				_capture = Capture::VALUE;
+			}
+			else if (_entryChild == XmlWord::AUTO_TYPE &&
+					 tag == XmlWord::DEFAULT_SEQUENCE)
+			{
+				_capture = Capture::SEQUENCE;
+			}
+		}
+	}
+	else if (tag == XmlWord::GROUP) {
+		_pushRecord(Kind::GROUP);
+	}
+	else if (_stackSize > 0) {
+		if (tag == XmlWord::ENTRY) {
+			_pushRecord(Kind::ENTRY);
+		}
+		else if (_depth == _stackDepth[_stackSize - 1] + 1) {
+			if (tag == XmlWord::NAME) {
+				_capture = Capture::NAME;
+			}
+			else if (tag == XmlWord::DEFAULT_AUTO_TYPE_SEQUENCE) {
+				_capture = Capture::SEQUENCE;
+			}
+		}
+	}
+
+	// Node lives only until it's closed, so typeCallback()
+	// gets the result of lookup through user data
+	bool isTextNeeded = (_capture != Capture::NONE || isProtected);
+	mxmlSetUserData(node, isTextNeeded ? node : NULL);
+}
+
+void XmlIndex::_closeElement()
+{
+	if (_protectedDepth == _depth) {
+		_protectedDepth = 0;
+	}
+	_capture = Capture::NONE;
+
+	if (_stackSize > 0 && _stackDepth[_stackSize - 1] == _depth) {
+		_stackSize--;
+	}
+
+	_depth--;
+	if (_depth == 0) {
+		_complete = true;
+		_shrink();
+	}
+}
+
+void XmlIndex::_addData(mxml_node_t* node)
+{
+	const char* text = mxmlGetOpaque(node);
+	if (text == NULL) {
+		return;
+	}
+
+	size_t length = std::strlen(text);
+	uint32_t streamOffset = _streamOffset;
+	bool isProtected = (_protectedDepth == _depth && length > 0);
+
+	if (isProtected) {
+		_streamOffset += Base64::DecodedLength(text, length);
+	}
+
+	if (_capture == Capture::KEY) {
+		_key = XmlVocabulary::find(text);
+	}
+	else if (_capture == Capture::NAME) {
+		_top().name = _store(text, length);
+	}
+	else if (_capture == Capture::SEQUENCE) {
+		_top().sequence = _store(text, length);
+	}
+	else if (_capture == Capture::VALUE) {
+		switch (_key) {
+			case XmlWord::TITLE:
+				_top().name = _store(text, length);
+			break;
+
+			case XmlWord::USER_NAME:
+				_top().login = _store(text, length);
+			break;
+
+			case XmlWord::TYPE:
+				_top().type = _store(text, length);
+			break;
+
+			case XmlWord::PASSWORD:
+				// Protected password is stored encoded and encrypted,
+				// it's decrypted in place only when it's typed
+				_top().password = _store(text, length);
+				_top().isPasswordProtected = isProtected;
+				_top().passwordOffset = streamOffset;
+			break;
+
+			default:
+			break;
+		}
+	}
+}
+
+void XmlIndex::_pushRecord(Kind kind)
+{
+	if (_stackSize == MAX_GROUP_DEPTH) {
+		_failed = true;
+		return;
+	}
+
+	if (_recordsCount == _recordsCapacity) {
+		size_t capacity = (_recordsCapacity == 0) ?
+				INITIAL_RECORDS_CAPACITY : _recordsCapacity * 2;
+		Record* records = static_cast<Record*>(
+				std::realloc(_records, capacity * sizeof(Record)));
+
+		if (records == nullptr) {
+			_failed = true;
+			return;
+		}
+
+		_records = records;
+		_recordsCapacity = capacity;
+	}
+
+	RecordId id = _recordsCount++;
+	Record& record = _records[id];
+
+	record.parent = NO_RECORD;
+	record.firstChild = NO_RECORD;
+	record.prev = NO_RECORD;
+	record.next = NO_RECORD;
+	record.name = record.login = record.password = record.type = {0, 0};
+	record.sequence = {0, 0};
+	record.passwordOffset = 0;
+	record.kind = kind;
+	record.isPasswordProtected = false;
+
+	if (_stackSize > 0) {
+		RecordId parent = _stack[_stackSize - 1];
+		RecordId last = _lastChild[_stackSize - 1];
+
+		record.parent = parent;
+		if (last == NO_RECORD) {
+			_records[parent].firstChild = id;
+		}
+		else {
+			_records[last].next = id;
+			record.prev = last;
+		}
+		_lastChild[_stackSize - 1] = id;
+	}
+
+	_stack[_stackSize] = id;
+	_lastChild[_stackSize] = NO_RECORD;
+	_stackDepth[_stackSize] = _depth;
+	_stackSize++;
+}
+
+auto XmlIndex::_store(const char* text, size_t length) -> Field
+{
+	if (_arenaSize + length > _arenaCapacity) {
+		size_t capacity = (_arenaCapacity == 0) ?
+				INITIAL_ARENA_CAPACITY : _arenaCapacity;
+		while (capacity < _arenaSize + length) {
+			capacity *= 2;
+		}
+
+		uint8_t* arena = static_cast<uint8_t*>(std::realloc(_arena, capacity));
+		if (arena == nullptr) {
+			_failed = true;
+			return {0, 0};
+		}
+
+		_arena = arena;
+		_arenaCapacity = capacity;
+	}
+
+	Field field = {(uint32_t)_arenaSize, (uint32_t)length};
+	std::memcpy(&_arena[_arenaSize], text, length);
+	_arenaSize += length;
+
+	return field;
+}
+
+void XmlIndex::_shrink()
+{
+	// Parsing is done, the index doesn't grow anymore
+	if (_recordsCount > 0 && _recordsCount < _recordsCapacity) {
+		Record* records = static_cast<Record*>(
+				std::realloc(_records, _recordsCount * sizeof(Record)));
+		if (records != nullptr) {
+			_records = records;
+			_recordsCapacity = _recordsCount;
+		}
+	}
+
+	if (_arenaSize > 0 && _arenaSize < _arenaCapacity) {
+		uint8_t* arena = static_cast<uint8_t*>(std::realloc(_arena, _arenaSize));
+		if (arena != nullptr) {
+			_arena = arena;
+			_arenaCapacity = _arenaSize;
+		}
+	}
+}
+
+bool XmlIndex::_isProtected(mxml_node_t* node)
+{
+	const char* protectedAttr =
+			mxmlElementGetAttr(node, AttrStrings::PROTECTED);
+
+	return (protectedAttr != NULL &&
+			std::strcmp(protectedAttr, StringBool::TRUE) == 0);
+}
+
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_XMLINDEX_XMLINDEX_H_
+#define DATABASE_XMLINDEX_XMLINDEX_H_
+
+extern "C" {
+#include <mxml.h>
+}
+
+#include <DbEntry.h>
+#include <database/xmlindex/XmlVocabulary.h>
+
+namespace DB {
+
+struct StringBool
+{
+	using BoolType = const char*;
+
+	static constexpr BoolType TRUE = "True";
+	static constexpr BoolType FALSE = "False";
+};
+
+struct AttrStrings
+{
+	static constexpr const char* PROTECTED = "Protected";
+};
+
+// Flat index of groups and entries, it's filled by SAX events
+// while the xml is decrypted. Only the fields used by the menu
+// are copied into the string arena, the rest of xml is dropped.
+class XmlIndex {
+public:
+	using RecordId = uint32_t;
+
+	static constexpr RecordId NO_RECORD = UINT32_MAX;
+	static constexpr size_t MAX_GROUP_DEPTH = 32;
+
+	enum class Kind : uint8_t {
+		GROUP,
+		ENTRY
+	};
+
+	struct Field {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct Record {
+		RecordId parent;
+		RecordId firstChild;
+		RecordId prev;
+		RecordId next;
+		Field name;
+		Field login;
+		Field password;
+		Field type;
+		Field sequence;  // Auto-Type sequence of entry or group
+		uint32_t passwordOffset;
+		Kind kind;
+		bool isPasswordProtected;
+	};
+
+	XmlIndex();
+	~XmlIndex();
+
+	void clear();
+
+	// Adapters for mxmlSAXLoadStream()
+	static mxml_type_t typeCallback(mxml_node_t* parent);
+	static void saxCallback(mxml_node_t* node,
+							mxml_sax_event_t event,
+							void* data);
+
+	bool isComplete() const {
+		return (_complete && !_failed && _recordsCount > 0);
+	}
+
+	size_t getRecordsCount() const {
+		return _recordsCount;
+	}
+
+	const Record& getRecord(RecordId id) const {
+		return _records[id];
+	}
+
+	StringField getField(const Field& field) const;
+
+	size_t getArenaSize() const {
+		return _arenaSize;
+	}
+
+	size_t getUsedMemory() const {
+		return (_recordsCapacity * sizeof(Record) + _arenaCapacity);
+	}
+
+private:
+	static constexpr size_t INITIAL_RECORDS_CAPACITY = 16;
+	static constexpr size_t INITIAL_ARENA_CAPACITY = 512;
+
+	enum class Capture : uint8_t {
+		NONE,
+		NAME,
+		KEY,
+		VALUE,
+		SEQUENCE
+	};
+
+	Record* _records;
+	size_t _recordsCount;
+	size_t _recordsCapacity;
+
+	uint8_t* _arena;
+	size_t _arenaSize;
+	size_t _arenaCapacity;
+
+	// Open groups and entry, innermost is the last one
+	RecordId _stack[MAX_GROUP_DEPTH];
+	RecordId _lastChild[MAX_GROUP_DEPTH];
+	size_t _stackDepth[MAX_GROUP_DEPTH];
+	size_t _stackSize;
+
+	size_t _depth;
+	size_t _protectedDepth;
+	uint32_t _streamOffset;
+	Capture _capture;
+	XmlWord _entryChild;
+	XmlWord _key;
+	bool _complete;
+	bool _failed;
+
+	XmlIndex(const XmlIndex&);
+
+	void _openElement(mxml_node_t* node);
+	void _closeElement();
+	void _addData(mxml_node_t* node);
+
+	void _pushRecord(Kind kind);
+	Record& _top() {
+		return _records[_stack[_stackSize - 1]];
+	}
+
+	Field _store(const char* text, size_t length);
+	void _shrink();
+
+	static bool _isProtected(mxml_node_t* node);
+};
+
+}
+
+#endif /* DATABASE_XMLINDEX_XMLINDEX_H_ */
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "XmlVocabulary.h"
+
+namespace DB {
+
+constexpr size_t XmlVocabulary::SLOTS_COUNT;
+
+namespace {
+	struct Slot {
+		const char* text;
+		size_t length;
+		XmlWord word;
+	};
+
+	template<size_t N>
+	constexpr Slot word(const char (&text)[N], XmlWord word)
+	{
+		return {text, N - 1, word};
+	}
+
+	constexpr Slot EMPTY_SLOT = {"", 0, XmlWord::UNKNOWN};
+
+	// Every word is placed in the slot of its hash
+	constexpr Slot SLOTS[XmlVocabulary::SLOTS_COUNT] = {
+		word("Type", XmlWord::TYPE),
+		word("Title", XmlWord::TITLE),
+		word("AutoType", XmlWord::AUTO_TYPE),
+		word("DefaultAutoTypeSequence", XmlWord::DEFAULT_AUTO_TYPE_SEQUENCE),
+		word("String", XmlWord::STRING),
+		EMPTY_SLOT,
+		EMPTY_SLOT,
+		word("Entry", XmlWord::ENTRY),
+		word("Password", XmlWord::PASSWORD),
+		word("Key", XmlWord::KEY),
+		word("UserName", XmlWord::USER_NAME),
+		word("DefaultSequence", XmlWord::DEFAULT_SEQUENCE),
+		word("Name", XmlWord::NAME),
+		word("Value", XmlWord::VALUE),
+		EMPTY_SLOT,
+		word("Group", XmlWord::GROUP)
+	};
+
+	constexpr bool isPerfect()
+	{
+		for (size_t i = 0; i < XmlVocabulary::SLOTS_COUNT; ++i) {
+			if (SLOTS[i].length > 0 &&
+				XmlVocabulary::hash(SLOTS[i].text, SLOTS[i].length) != i)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(isPerfect(), "XmlVocabulary slots don't match the hash");
+}
+
+XmlWord XmlVocabulary::find(const char* text)
+{
+	size_t length = std::strlen(text);
+	if (length == 0) {
+		return XmlWord::UNKNOWN;
+	}
+
+	const Slot& slot = SLOTS[hash(text, length)];
+	if (slot.length == length && std::memcmp(slot.text, text, length) == 0) {
+		return slot.word;
+	}
+
+	return XmlWord::UNKNOWN;
+}
+
+}
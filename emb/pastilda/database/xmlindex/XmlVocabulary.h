@@ -0,0 +1,69 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASE_XMLINDEX_XMLVOCABULARY_H_
+#define DATABASE_XMLINDEX_XMLVOCABULARY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DB {
+
+enum class XmlWord : uint8_t {
+	UNKNOWN,
+	// Tags
+	GROUP,
+	ENTRY,
+	STRING,
+	KEY,
+	VALUE,
+	NAME,
+	AUTO_TYPE,
+	DEFAULT_SEQUENCE,
+	DEFAULT_AUTO_TYPE_SEQUENCE,
+	// Keys of entry strings
+	TITLE,
+	USER_NAME,
+	PASSWORD,
+	TYPE
+};
+
+// Tag and key names are interned to XmlWord by a perfect hash
+// of the KeePass words used by the index, one compare per lookup
+class XmlVocabulary {
+public:
+	static constexpr size_t SLOTS_COUNT = 16;
+
+	static XmlWord find(const char* text);
+
+	static constexpr size_t hash(const char* text, size_t length) {
+		return ((length +
+				 static_cast<uint8_t>(text[0]) * 6 +
+				 static_cast<uint8_t>(text[length - 1]) * 4) & (SLOTS_COUNT - 1));
+	}
+};
+
+}
+
+#endif /* DATABASE_XMLINDEX_XMLVOCABULARY_H_ */
@@ -24,9 +24,6 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
-
-#include <etl/string.h>
 
 #include "XmlTree.h"
 
@@ -41,69 +38,75 @@ XmlTree::XmlTree(RawTree tree)
 
 XmlTree::XmlTree():
 	_rawTree(nullptr),
-	_currentNode(nullptr)
+	_rootNode(EntryStore::NO_NODE),
+	_currentNode(EntryStore::NO_NODE),
+	_infoNode(EntryStore::NO_NODE)
 { }
 
 void XmlTree::init(RawTree tree)
 {
-	// Finding the top Group tag (it should be in file)
-	RawNode topNode =
-			mxmlFindElement(tree, tree,
-						    _castInChar(TagStrings::GROUP), NULL, NULL,
-							MXML_DESCEND);
+	// The top Group is the first node of store
+	constexpr RawNode topNode = 0;
+
+	_rawTree = tree;
+	_rootNode = _currentNode = _infoNode = EntryStore::NO_NODE;
+
+	if (tree == nullptr || tree->getNodesCount() == 0) {
+		return;
+	}
 
+	_rootNode = topNode;
 	_currentNode = topNode;
-	_rawTree = topNode;
 
 	moveInto();  // avoid top group
-	_updateNodeInfo();
 }
 
 XmlTree::~XmlTree() { }
 
 void XmlTree::moveInto()
 {
+	// Children are linked in document order
 	if (isMostBottom() == false) {
-		RawNode entryNode = _findElement(_currentNode, TagStrings::ENTRY);
-		RawNode groupNode = _findElement(_currentNode, TagStrings::GROUP);
-
-		// Entry nodes are always first in keepass xml file
-		if (entryNode != NULL) {
-			_currentNode = entryNode;
-		}
-		else if (groupNode != NULL) {
-			_currentNode = groupNode;
-		}
+		_currentNode = _rawTree->getFirstChild(_currentNode);
 	}
 }
 
 void XmlTree::moveOut()
 {
 	if (isMostTop() == false) {
-		_currentNode = mxmlGetParent(_currentNode);
+		_currentNode = _rawTree->getParent(_currentNode);
 	}
 }
 
 void XmlTree::moveLeft()
 {
 	if (isMostLeft() == false) {
-		_currentNode = _getPrev();
+		_currentNode = _rawTree->getPrev(_currentNode);
 	}
 }
 
 void XmlTree::moveRight()
 {
 	if (isMostRight() == false) {
-		_currentNode = _getNext();
+		_currentNode = _rawTree->getNext(_currentNode);
 	}
 }
 
 void XmlTree::moveInHead()
 {
-	_currentNode = _rawTree;
+	_currentNode = _rootNode;
 	moveInto();  // avoid top group
 }
 
+void XmlTree::moveTo(RawNode node)
+{
+	if (_rootNode != EntryStore::NO_NODE && node != _rootNode &&
+		node < _rawTree->getNodesCount())
+	{
+		_currentNode = node;
+	}
+}
+
 void XmlTree::moveMostLeft()
 {
 	while (isMostLeft() == false) {
@@ -120,21 +123,27 @@ void XmlTree::moveMostRight()
 
 bool XmlTree::isEndNode()
 {
-	_updateNodeInfo();
-	return !_currentNodeStruct.isExpanded;
+	return _rawTree->isEntry(_currentNode);
+}
+
+bool XmlTree::isEmpty()
+{
+	if (_rootNode == EntryStore::NO_NODE) {
+		return true;
+	}
+
+	return (_rawTree->getFirstChild(_rootNode) == EntryStore::NO_NODE);
 }
 
 bool XmlTree::isMostTop()
 {
-	return (mxmlGetParent(_currentNode) == _rawTree);
+	return (_rawTree->getParent(_currentNode) == _rootNode);
 }
 
 bool XmlTree::isMostBottom()
 {
 	if (isEndNode() == false) {
-		RawNode entryNode = _findElement(_currentNode, TagStrings::ENTRY);
-		RawNode groupNode = _findElement(_currentNode, TagStrings::GROUP);
-		return (entryNode == NULL && groupNode == NULL);
+		return (_rawTree->getFirstChild(_currentNode) == EntryStore::NO_NODE);
 	}
 
 	return true;
@@ -142,127 +151,44 @@ bool XmlTree::isMostBottom()
 
 bool XmlTree::isMostLeft()
 {
-	return (_getPrev() == NULL);
+	return (_rawTree->getPrev(_currentNode) == EntryStore::NO_NODE);
 }
 
 bool XmlTree::isMostRight()
 {
-	return (_getNext() == NULL);
-}
-
-auto XmlTree::_getNext() -> RawNode
-{
-	// We should to mxmlWalkNext() twice,
-	// because min-xml lib working so.
-	RawNode node =
-		mxmlWalkNext(_currentNode, mxmlGetParent(_currentNode), MXML_NO_DESCEND);
-	node =
-		mxmlWalkNext(node, mxmlGetParent(_currentNode), MXML_NO_DESCEND);
-
-	return node;
-}
-
-auto XmlTree::_getPrev() -> RawNode
-{
-	// We should to mxmlWalkPrev() twice,
-	// because min-xml lib working so.
-	RawNode node =
-		mxmlWalkPrev(_currentNode, mxmlGetParent(_currentNode), MXML_NO_DESCEND);
-	node =
-		mxmlWalkPrev(node, mxmlGetParent(_currentNode), MXML_NO_DESCEND);
-
-	// Check if it's Entry or Group
-	const char* tagName = node->value.element.name;
-	if (std::strcmp(tagName, _castInChar(TagStrings::ENTRY)) == 0 ||
-		std::strcmp(tagName, _castInChar(TagStrings::GROUP)) == 0)
-	{
-		return node;
-	}
-
-	return NULL;
+	return (_rawTree->getNext(_currentNode) == EntryStore::NO_NODE);
 }
 
 void XmlTree::_updateNodeInfo()
 {
-	StringField fieldIsExpanded = _getTextByTag(TagStrings::IS_EXPANDED);
+	// Node info is filled once per node, not on every request
+	_infoNode = _currentNode;
 
-	bool isExpanded = (fieldIsExpanded == StringBool::TRUE);
+	bool isExpanded = (_rawTree->isEntry(_currentNode) == false);
 	_currentNodeStruct.isExpanded = isExpanded;
+	_currentNodeStruct.name = _rawTree->getName(_currentNode);
 
 	if (isExpanded) {  // if <Group>
-		_currentNodeStruct.name = _getTextByTag(TagStrings::NAME);
 		_currentNodeStruct.login =
 		_currentNodeStruct.password =
-		_currentNodeStruct.type = DB::EMPTY_FIELD;
+		_currentNodeStruct.type =
+		_currentNodeStruct.sequence = DB::EMPTY_FIELD;
+		_currentNodeStruct.isPasswordProtected = false;
+		_currentNodeStruct.passwordOffset = 0;
 	}
 	else {  // if <Entry>
-		_currentNodeStruct.name = _getKey(KeyStrings::TITLE);
-		_currentNodeStruct.login = _getKey(KeyStrings::USER_NAME);
-		_currentNodeStruct.password = _getKey(KeyStrings::PASSWORD);
-		_currentNodeStruct.type = _getKey(KeyStrings::TYPE);
-	}
-}
-
-StringField XmlTree::_getTextByTag(TagStrings::StringType tagName)
-{
-	RawNode nameNode = _findElement(_currentNode, tagName);
-	if (nameNode == nullptr) {
-		return DB::EMPTY_FIELD;
+		_currentNodeStruct.login = _rawTree->getLogin(_currentNode);
+		_currentNodeStruct.type = _rawTree->getType(_currentNode);
+		_currentNodeStruct.sequence = _rawTree->findSequence(_currentNode);
+
+		// Protected password is left encrypted until it's typed,
+		// the store keeps its inner stream offset
+		_currentNodeStruct.password = _rawTree->getPassword(_currentNode);
+		_currentNodeStruct.isPasswordProtected =
+				_rawTree->isPasswordProtected(_currentNode);
+		_currentNodeStruct.passwordOffset =
+				_rawTree->getPasswordOffset(_currentNode);
 	}
-
-	return _getText(nameNode);
-}
-
-auto XmlTree::_findElement(RawNode startNode,
-						   TagStrings::StringType elemName) -> RawNode
-{
-	if (startNode == _currentNode) {
-		startNode = _currentNode->child;
-	}
-	return mxmlFindElement(startNode, _currentNode,
-						   _castInChar(elemName), NULL, NULL,
-						   MXML_NO_DESCEND);
-}
-
-auto XmlTree::_findElementInto(RawNode parentNode,
-							   RawNode startNode,
-							   TagStrings::StringType elemName) -> RawNode
-{
-	if (startNode == NULL) {
-		startNode = parentNode->child;
-	}
-	return mxmlFindElement(startNode, parentNode,
-						   _castInChar(elemName), NULL, NULL,
-						   MXML_NO_DESCEND);
-}
-
-StringField XmlTree::_getText(RawNode node)
-{
-	const char* text = mxmlGetOpaque(node);
-	size_t length = etl::strlen(text);
-
-	return StringField(
-			reinterpret_cast<const StringFieldChar*>(text),
-			length
-		);
-}
-
-StringField XmlTree::_getKey(KeyStrings::StringType keyName)
-{
-    for (RawNode stringNode = _findElement(_currentNode, TagStrings::STRING);
-         stringNode != NULL;
-         stringNode = _findElement(stringNode, TagStrings::STRING))
-    {
-    	RawNode keyNode = _findElementInto(stringNode, NULL, TagStrings::KEY);
-    	StringField keyText = _getText(keyNode);
-    	if (keyText == keyName) {
-    		RawNode valueNode =
-    				_findElementInto(stringNode, keyNode, TagStrings::VALUE);
-    		return _getText(valueNode);
-    	}
-    }
-
-    return StringField();
 }
 
 }
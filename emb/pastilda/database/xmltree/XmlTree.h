@@ -25,33 +25,25 @@
 #ifndef DATABASE_XMLTREE_XMLTREE_H_
 #define DATABASE_XMLTREE_XMLTREE_H_
 
-extern "C" {
-#include <mxml.h>
-}
-
 #include <DbEntry.h>
+#include <database/entrystore/EntryStore.h>
 
 namespace DB {
 
-struct StringBool
-{
-	using BoolType = const StringFieldChar*;
-
-	static constexpr BoolType TRUE = reinterpret_cast<BoolType>("True");
-	static constexpr BoolType FALSE = reinterpret_cast<BoolType>("False");
-};
-
 class XmlTree {
 public:
-	using RawTree = mxml_node_t*;
-	using RawNode = mxml_node_t*;
+	using RawTree = const EntryStore*;
+	using RawNode = EntryStore::NodeId;
 
 	struct NodeStruct {
 		StringField name;
 		StringField login;
 		StringField password;
 		StringField type;
+		StringField sequence;
 		bool isExpanded;
+		bool isPasswordProtected;
+		uint32_t passwordOffset;
 	};
 
 	XmlTree();
@@ -61,7 +53,9 @@ public:
 	void init(RawTree tree);
 
 	const NodeStruct& getCurrentNodeInfo() {
-		_updateNodeInfo();
+		if (_infoNode != _currentNode) {
+			_updateNodeInfo();
+		}
 		return _currentNodeStruct;
 	}
 
@@ -75,6 +69,7 @@ public:
 	void moveOut();
 
 	void moveInHead();
+	void moveTo(RawNode node);
 	void moveMostRight();
 	void moveMostLeft();
 
@@ -83,71 +78,16 @@ public:
 	bool isMostTop();
 	bool isMostBottom();
 	bool isEndNode();
+	bool isEmpty();
 
 private:
-	struct TagStrings {
-		using StringType = const StringFieldChar*;
-
-		static constexpr StringType IS_EXPANDED =
-				reinterpret_cast<StringType>("IsExpanded");
-
-		static constexpr StringType NAME =
-				reinterpret_cast<StringType>("Name");
-
-		static constexpr StringType STRING =
-				reinterpret_cast<StringType>("String");
-
-		static constexpr StringType KEY =
-				reinterpret_cast<StringType>("Key");
-
-		static constexpr StringType VALUE =
-				reinterpret_cast<StringType>("Value");
-
-		static constexpr StringType ENTRY =
-				reinterpret_cast<StringType>("Entry");
-
-		static constexpr StringType GROUP =
-				reinterpret_cast<StringType>("Group");
-	};
-
-	struct KeyStrings {
-		using StringType = const StringFieldChar*;
-
-		static constexpr StringType TITLE =
-				reinterpret_cast<StringType>("Title");
-
-		static constexpr StringType USER_NAME =
-				reinterpret_cast<StringType>("UserName");
-
-		static constexpr StringType PASSWORD =
-				reinterpret_cast<StringType>("Password");
-
-		static constexpr StringType TYPE =
-				reinterpret_cast<StringType>("Type");
-	};
-
 	RawTree _rawTree;
+	RawNode _rootNode;
 	RawNode _currentNode;
+	RawNode _infoNode;  // node described by _currentNodeStruct
 	NodeStruct _currentNodeStruct;
 
 	void _updateNodeInfo();
-
-	RawNode _getNext();
-	RawNode _getPrev();
-
-	StringField _getKey(KeyStrings::StringType keyName);
-	StringField _getTextByTag(TagStrings::StringType tagName);
-	StringField _getText(RawNode node);
-
-	RawNode _findElement(RawNode startNode, TagStrings::StringType elemName);
-	RawNode _findElementInto(RawNode parentNode,
-							 RawNode startNode,
-							 TagStrings::StringType elemName);
-
-	template<typename T>
-	const char* _castInChar(T str) {
-		return reinterpret_cast<const char*>(str);
-	}
 };
 
 }
@@ -25,6 +25,7 @@
 #include <fs/file_system.h>
 
 FileSystem *fs_pointer;
+volatile uint32_t FileSystem::_write_count = 0;
 
 FileSystem::FileSystem()
 {
@@ -52,6 +53,7 @@ int FileSystem::access_memory(MemoryCommand cmd, uint32_t sector, uint32_t count
 			}
 			break;
 		case WRITE:
+			_write_count++;
 			for(int i = 0; i < count; i++) {
 				fs_pointer->_sst25.write_sector(sector, copy_from);
 				sector++;
@@ -85,6 +87,7 @@ int FileSystem::msd_write(uint32_t lba, const uint8_t *copy_from)
 		return (1);
 	}
 	else {
+		_write_count++;
 		fs_pointer->_sst25.write_sector(lba, copy_from);
 		return (0);
 	}
@@ -121,6 +124,10 @@ uint32_t FileSystem::get_file_tell(FIL *file)
 {
 	return (f_tell(file));
 }
+uint32_t FileSystem::get_write_count()
+{
+	return (_write_count);
+}
 
 FRESULT FileSystem::read_file(FIL *file, const char *name, uint8_t *buffer)
 {
@@ -52,8 +52,10 @@ public:
 	static uint32_t get_file_tell(FIL *file);
 	static FRESULT read_file(FIL *file, const char *name, uint8_t *buffer);
 	static FRESULT write_file(FIL *file, const char *name, uint8_t *buffer, uint32_t size);
+	static uint32_t get_write_count();
 
 private:
+	static volatile uint32_t _write_count;
 	SST25 _sst25;
 	FatState get_fat_state();
 
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASS_AES_H
+#define KEEPASS_AES_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace KeepAss
+{
+	//AES-256 backends, all have the same static interface:
+	//encrypt_ECB() - in-place ECB encryption repeated [cycles] times (key transformation)
+	//decrypt_CBC() - in-place CBC decryption, iv is not modified
+	//wipe()        - clears the key kept by the backend between calls
+	class KeePassAesHardware
+	{
+	public:
+		static void encrypt_ECB(const uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles);
+		static void decrypt_CBC(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len);
+		static void wipe();
+	};
+
+	class KeePassAesSoftware
+	{
+	public:
+		static void encrypt_ECB(const uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles);
+		static void decrypt_CBC(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len);
+		static void wipe();
+
+	private:
+		static void _setKey(const uint8_t *key);
+		static void _makeDecryptionKey();
+		static void _encryptBlock(uint8_t *block);
+		static void _decryptBlock(uint8_t *block);
+	};
+
+	//tables of the software backend are indexed by secret bytes,
+	//this one has no lookups and runs in constant time, but slower
+	class KeePassAesBitsliced
+	{
+	public:
+		static void encrypt_ECB(const uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles);
+		static void decrypt_CBC(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len);
+		static void wipe();
+
+	private:
+		static void _setKey(const uint8_t *key);
+	};
+
+	//backend is selected at compile time,
+	//define KEEPASS_AES_SOFTWARE to build without the CRYP peripheral,
+	//KEEPASS_AES_BITSLICED to build it constant time
+#if defined(KEEPASS_AES_BITSLICED)
+	typedef KeePassAesBitsliced KeePassAes;
+#elif defined(KEEPASS_AES_SOFTWARE)
+	typedef KeePassAesSoftware KeePassAes;
+#else
+	typedef KeePassAesHardware KeePassAes;
+#endif
+}
+#endif
@@ -0,0 +1,548 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "keepass_aes.h"
+#include "keepass_crypto.h"
+
+using namespace KeepAss;
+
+//constant-time AES-256: two blocks are kept bit-sliced in eight 32-bit
+//words, the S-box is the Boyar-Peralta circuit, so there are no table
+//lookups and no branches on the key or the data
+static constexpr uint32_t AES_ROUNDS = 14;
+static constexpr uint32_t AES_KEY_WORDS = 8;
+static constexpr uint32_t AES_SCHEDULE_WORDS = 4 * (AES_ROUNDS + 1);
+static constexpr uint32_t AES_BLOCK_SIZE = 16;
+static constexpr uint32_t SLICED_BLOCKS = 2;
+
+static const uint8_t RCON[7] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
+
+static uint8_t key_cache[AES_KEY_WORDS * sizeof(uint32_t)];
+static bool key_cached = false;
+static uint32_t sliced_key[AES_SCHEDULE_WORDS * 2];
+
+static inline uint32_t load_le(const uint8_t *p)
+{
+	return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static inline void store_le(uint8_t *p, uint32_t x)
+{
+	p[0] = x;
+	p[1] = x >> 8;
+	p[2] = x >> 16;
+	p[3] = x >> 24;
+}
+
+static inline uint32_t rotr16(uint32_t x)
+{
+	return ((x << 16) | (x >> 16));
+}
+
+static inline void swap_bits(uint32_t &x, uint32_t &y, uint32_t mask, uint32_t shift)
+{
+	uint32_t a = x;
+	uint32_t b = y;
+
+	x = (a & mask) | ((b & mask) << shift);
+	y = ((a & ~mask) >> shift) | (b & ~mask);
+}
+
+//transposes bits of the words, it's its own inverse
+static void ortho(uint32_t *q)
+{
+	swap_bits(q[0], q[1], 0x55555555, 1);
+	swap_bits(q[2], q[3], 0x55555555, 1);
+	swap_bits(q[4], q[5], 0x55555555, 1);
+	swap_bits(q[6], q[7], 0x55555555, 1);
+
+	swap_bits(q[0], q[2], 0x33333333, 2);
+	swap_bits(q[1], q[3], 0x33333333, 2);
+	swap_bits(q[4], q[6], 0x33333333, 2);
+	swap_bits(q[5], q[7], 0x33333333, 2);
+
+	swap_bits(q[0], q[4], 0x0F0F0F0F, 4);
+	swap_bits(q[1], q[5], 0x0F0F0F0F, 4);
+	swap_bits(q[2], q[6], 0x0F0F0F0F, 4);
+	swap_bits(q[3], q[7], 0x0F0F0F0F, 4);
+}
+
+//q[0] holds the least significant bits of all bytes, q[7] the most
+static void sub_bytes(uint32_t *q)
+{
+	uint32_t x0, x1, x2, x3, x4, x5, x6, x7;
+	uint32_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+	uint32_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+	uint32_t y20, y21;
+	uint32_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+	uint32_t z10, z11, z12, z13, z14, z15, z16, z17;
+	uint32_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+	uint32_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+	uint32_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+	uint32_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+	uint32_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+	uint32_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+	uint32_t t60, t61, t62, t63, t64, t65, t66, t67;
+	uint32_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+	x0 = q[7];
+	x1 = q[6];
+	x2 = q[5];
+	x3 = q[4];
+	x4 = q[3];
+	x5 = q[2];
+	x6 = q[1];
+	x7 = q[0];
+
+	//top linear transformation
+	y14 = x3 ^ x5;
+	y13 = x0 ^ x6;
+	y9 = x0 ^ x3;
+	y8 = x0 ^ x5;
+	t0 = x1 ^ x2;
+	y1 = t0 ^ x7;
+	y4 = y1 ^ x3;
+	y12 = y13 ^ y14;
+	y2 = y1 ^ x0;
+	y5 = y1 ^ x6;
+	y3 = y5 ^ y8;
+	t1 = x4 ^ y12;
+	y15 = t1 ^ x5;
+	y20 = t1 ^ x1;
+	y6 = y15 ^ x7;
+	y10 = y15 ^ t0;
+	y11 = y20 ^ y9;
+	y7 = x7 ^ y11;
+	y17 = y10 ^ y11;
+	y19 = y10 ^ y8;
+	y16 = t0 ^ y11;
+	y21 = y13 ^ y16;
+	y18 = x0 ^ y16;
+
+	//inversion in GF(2^8)
+	t2 = y12 & y15;
+	t3 = y3 & y6;
+	t4 = t3 ^ t2;
+	t5 = y4 & x7;
+	t6 = t5 ^ t2;
+	t7 = y13 & y16;
+	t8 = y5 & y1;
+	t9 = t8 ^ t7;
+	t10 = y2 & y7;
+	t11 = t10 ^ t7;
+	t12 = y9 & y11;
+	t13 = y14 & y17;
+	t14 = t13 ^ t12;
+	t15 = y8 & y10;
+	t16 = t15 ^ t12;
+	t17 = t4 ^ t14;
+	t18 = t6 ^ t16;
+	t19 = t9 ^ t14;
+	t20 = t11 ^ t16;
+	t21 = t17 ^ y20;
+	t22 = t18 ^ y19;
+	t23 = t19 ^ y21;
+	t24 = t20 ^ y18;
+
+	t25 = t21 ^ t22;
+	t26 = t21 & t23;
+	t27 = t24 ^ t26;
+	t28 = t25 & t27;
+	t29 = t28 ^ t22;
+	t30 = t23 ^ t24;
+	t31 = t22 ^ t26;
+	t32 = t31 & t30;
+	t33 = t32 ^ t24;
+	t34 = t23 ^ t33;
+	t35 = t27 ^ t33;
+	t36 = t24 & t35;
+	t37 = t36 ^ t34;
+	t38 = t27 ^ t36;
+	t39 = t29 & t38;
+	t40 = t25 ^ t39;
+
+	t41 = t40 ^ t37;
+	t42 = t29 ^ t33;
+	t43 = t29 ^ t40;
+	t44 = t33 ^ t37;
+	t45 = t42 ^ t41;
+	z0 = t44 & y15;
+	z1 = t37 & y6;
+	z2 = t33 & x7;
+	z3 = t43 & y16;
+	z4 = t40 & y1;
+	z5 = t29 & y7;
+	z6 = t42 & y11;
+	z7 = t45 & y17;
+	z8 = t41 & y10;
+	z9 = t44 & y12;
+	z10 = t37 & y3;
+	z11 = t33 & y4;
+	z12 = t43 & y13;
+	z13 = t40 & y5;
+	z14 = t29 & y2;
+	z15 = t42 & y9;
+	z16 = t45 & y14;
+	z17 = t41 & y8;
+
+	//bottom linear transformation
+	t46 = z15 ^ z16;
+	t47 = z10 ^ z11;
+	t48 = z5 ^ z13;
+	t49 = z9 ^ z10;
+	t50 = z2 ^ z12;
+	t51 = z2 ^ z5;
+	t52 = z7 ^ z8;
+	t53 = z0 ^ z3;
+	t54 = z6 ^ z7;
+	t55 = z16 ^ z17;
+	t56 = z12 ^ t48;
+	t57 = t50 ^ t53;
+	t58 = z4 ^ t46;
+	t59 = z3 ^ t54;
+	t60 = t46 ^ t57;
+	t61 = z14 ^ t57;
+	t62 = t52 ^ t58;
+	t63 = t49 ^ t58;
+	t64 = z4 ^ t59;
+	t65 = t61 ^ t62;
+	t66 = z1 ^ t63;
+	s0 = t59 ^ t63;
+	s6 = t56 ^ ~t62;
+	s7 = t48 ^ ~t60;
+	t67 = t64 ^ t65;
+	s3 = t53 ^ t66;
+	s4 = t51 ^ t66;
+	s5 = t47 ^ t65;
+	s1 = t64 ^ ~s3;
+	s2 = t55 ^ ~t67;
+
+	q[7] = s0;
+	q[6] = s1;
+	q[5] = s2;
+	q[4] = s3;
+	q[3] = s4;
+	q[2] = s5;
+	q[1] = s6;
+	q[0] = s7;
+}
+
+//inverse affine transformation, S-box inverse is A^-1(S(A^-1(x)))
+static void inv_affine(uint32_t *q)
+{
+	uint32_t q0 = ~q[0];
+	uint32_t q1 = ~q[1];
+	uint32_t q2 = q[2];
+	uint32_t q3 = q[3];
+	uint32_t q4 = q[4];
+	uint32_t q5 = ~q[5];
+	uint32_t q6 = ~q[6];
+	uint32_t q7 = q[7];
+
+	q[7] = q1 ^ q4 ^ q6;
+	q[6] = q0 ^ q3 ^ q5;
+	q[5] = q7 ^ q2 ^ q4;
+	q[4] = q6 ^ q1 ^ q3;
+	q[3] = q5 ^ q0 ^ q2;
+	q[2] = q4 ^ q7 ^ q1;
+	q[1] = q3 ^ q6 ^ q0;
+	q[0] = q2 ^ q5 ^ q7;
+}
+
+static void inv_sub_bytes(uint32_t *q)
+{
+	inv_affine(q);
+	sub_bytes(q);
+	inv_affine(q);
+}
+
+static void shift_rows(uint32_t *q)
+{
+	for (uint32_t i = 0; i < 8; i++) {
+		uint32_t x = q[i];
+		q[i] = (x & 0x000000FF) |
+			   ((x & 0x0000FC00) >> 2) | ((x & 0x00000300) << 6) |
+			   ((x & 0x00F00000) >> 4) | ((x & 0x000F0000) << 4) |
+			   ((x & 0xC0000000) >> 6) | ((x & 0x3F000000) << 2);
+	}
+}
+
+static void inv_shift_rows(uint32_t *q)
+{
+	for (uint32_t i = 0; i < 8; i++) {
+		uint32_t x = q[i];
+		q[i] = (x & 0x000000FF) |
+			   ((x & 0x00003F00) << 2) | ((x & 0x0000C000) >> 6) |
+			   ((x & 0x000F0000) << 4) | ((x & 0x00F00000) >> 4) |
+			   ((x & 0x03000000) << 6) | ((x & 0xFC000000) >> 2);
+	}
+}
+
+//rotation by 8 takes the next byte of the column, by 16 the one after it
+static void mix_columns(uint32_t *q)
+{
+	uint32_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+	uint32_t q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+	uint32_t r0 = (q0 >> 8) | (q0 << 24);
+	uint32_t r1 = (q1 >> 8) | (q1 << 24);
+	uint32_t r2 = (q2 >> 8) | (q2 << 24);
+	uint32_t r3 = (q3 >> 8) | (q3 << 24);
+	uint32_t r4 = (q4 >> 8) | (q4 << 24);
+	uint32_t r5 = (q5 >> 8) | (q5 << 24);
+	uint32_t r6 = (q6 >> 8) | (q6 << 24);
+	uint32_t r7 = (q7 >> 8) | (q7 << 24);
+
+	//2 * (a0 ^ a1) ^ a1 ^ a2 ^ a3, doubling moves bits up and folds the top one
+	q[0] = q7 ^ r7 ^ r0 ^ rotr16(q0 ^ r0);
+	q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr16(q1 ^ r1);
+	q[2] = q1 ^ r1 ^ r2 ^ rotr16(q2 ^ r2);
+	q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr16(q3 ^ r3);
+	q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr16(q4 ^ r4);
+	q[5] = q4 ^ r4 ^ r5 ^ rotr16(q5 ^ r5);
+	q[6] = q5 ^ r5 ^ r6 ^ rotr16(q6 ^ r6);
+	q[7] = q6 ^ r6 ^ r7 ^ rotr16(q7 ^ r7);
+}
+
+//InvMixColumns is MixColumns of a0 ^ 4 * (a0 ^ a2)
+static void inv_mix_columns(uint32_t *q)
+{
+	uint32_t u0 = q[0] ^ rotr16(q[0]);
+	uint32_t u1 = q[1] ^ rotr16(q[1]);
+	uint32_t u2 = q[2] ^ rotr16(q[2]);
+	uint32_t u3 = q[3] ^ rotr16(q[3]);
+	uint32_t u4 = q[4] ^ rotr16(q[4]);
+	uint32_t u5 = q[5] ^ rotr16(q[5]);
+	uint32_t u6 = q[6] ^ rotr16(q[6]);
+	uint32_t u7 = q[7] ^ rotr16(q[7]);
+
+	q[0] ^= u6;
+	q[1] ^= u6 ^ u7;
+	q[2] ^= u0 ^ u7;
+	q[3] ^= u1 ^ u6;
+	q[4] ^= u2 ^ u6 ^ u7;
+	q[5] ^= u3 ^ u7;
+	q[6] ^= u4;
+	q[7] ^= u5;
+
+	mix_columns(q);
+}
+
+static void add_round_key(uint32_t *q, const uint32_t *key)
+{
+	for (uint32_t i = 0; i < 8; i++) {
+		q[i] ^= key[i];
+	}
+}
+
+static void encrypt_sliced(uint32_t *q)
+{
+	add_round_key(q, sliced_key);
+
+	for (uint32_t round = 1; round < AES_ROUNDS; round++) {
+		sub_bytes(q);
+		shift_rows(q);
+		mix_columns(q);
+		add_round_key(q, &sliced_key[round * 8]);
+	}
+
+	//last round has no MixColumns
+	sub_bytes(q);
+	shift_rows(q);
+	add_round_key(q, &sliced_key[AES_ROUNDS * 8]);
+}
+
+static void decrypt_sliced(uint32_t *q)
+{
+	add_round_key(q, &sliced_key[AES_ROUNDS * 8]);
+
+	for (uint32_t round = AES_ROUNDS - 1; round > 0; round--) {
+		inv_shift_rows(q);
+		inv_sub_bytes(q);
+		add_round_key(q, &sliced_key[round * 8]);
+		inv_mix_columns(q);
+	}
+
+	inv_shift_rows(q);
+	inv_sub_bytes(q);
+	add_round_key(q, sliced_key);
+}
+
+//words of the first block go to the even slots, of the second one to the odd
+static void load_blocks(uint32_t *q, const uint8_t *first, const uint8_t *second)
+{
+	for (uint32_t i = 0; i < 4; i++) {
+		q[i * 2] = load_le(&first[i * 4]);
+		q[i * 2 + 1] = load_le(&second[i * 4]);
+	}
+	ortho(q);
+}
+
+static void store_blocks(uint32_t *q, uint8_t *first, uint8_t *second)
+{
+	ortho(q);
+	for (uint32_t i = 0; i < 4; i++) {
+		store_le(&first[i * 4], q[i * 2]);
+		store_le(&second[i * 4], q[i * 2 + 1]);
+	}
+}
+
+static uint32_t sub_word(uint32_t x)
+{
+	uint32_t q[8];
+
+	for (uint32_t i = 0; i < 8; i++) {
+		q[i] = x;
+	}
+	ortho(q);
+	sub_bytes(q);
+	ortho(q);
+
+	return (q[0]);
+}
+
+void KeePassAesBitsliced::_setKey(const uint8_t *key)
+{
+	uint32_t schedule[AES_SCHEDULE_WORDS * 2];
+	uint32_t temp = 0;
+
+	//key schedule is reused while the key stays the same
+	if (key_cached && memcmp(key_cache, key, sizeof(key_cache)) == 0) {
+		return;
+	}
+
+	//both slots of a word get the same key word, words are little endian
+	for (uint32_t i = 0; i < AES_KEY_WORDS; i++) {
+		temp = load_le(&key[i * sizeof(uint32_t)]);
+		schedule[i * 2] = temp;
+		schedule[i * 2 + 1] = temp;
+	}
+
+	for (uint32_t i = AES_KEY_WORDS; i < AES_SCHEDULE_WORDS; i++) {
+		if ((i % AES_KEY_WORDS) == 0) {
+			temp = sub_word((temp << 24) | (temp >> 8)) ^ RCON[i / AES_KEY_WORDS - 1];
+		}
+		else if ((i % AES_KEY_WORDS) == 4) {
+			temp = sub_word(temp);
+		}
+
+		temp ^= schedule[(i - AES_KEY_WORDS) * 2];
+		schedule[i * 2] = temp;
+		schedule[i * 2 + 1] = temp;
+	}
+
+	//round keys are sliced as the state, every bit is doubled for both blocks
+	for (uint32_t i = 0; i < AES_SCHEDULE_WORDS; i += 4) {
+		ortho(&schedule[i * 2]);
+	}
+
+	for (uint32_t i = 0; i < AES_SCHEDULE_WORDS; i++) {
+		uint32_t x = (schedule[i * 2] & 0x55555555) | (schedule[i * 2 + 1] & 0xAAAAAAAA);
+		uint32_t even = x & 0x55555555;
+		uint32_t odd = x & 0xAAAAAAAA;
+
+		sliced_key[i * 2] = even | (even << 1);
+		sliced_key[i * 2 + 1] = odd | (odd >> 1);
+	}
+
+	KeePassCrypto::wipe(schedule, sizeof(schedule));
+	memcpy(key_cache, key, sizeof(key_cache));
+	key_cached = true;
+}
+
+void KeePassAesBitsliced::encrypt_ECB(const uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles)
+{
+	uint32_t q[8];
+	uint8_t spare[AES_BLOCK_SIZE];
+
+	_setKey(key);
+
+	//state stays sliced for all cycles, the key transformation
+	//has two blocks, so they are always run together
+	for (uint32_t offset = 0; offset + AES_BLOCK_SIZE <= data_len; offset += AES_BLOCK_SIZE * SLICED_BLOCKS) {
+		uint8_t *first = &data[offset];
+		uint8_t *second = spare;
+
+		if (offset + AES_BLOCK_SIZE * SLICED_BLOCKS <= data_len) {
+			second = &data[offset + AES_BLOCK_SIZE];
+		}
+		else {
+			memcpy(spare, first, AES_BLOCK_SIZE);
+		}
+
+		load_blocks(q, first, second);
+		for (uint32_t i = 0; i < cycles; i++) {
+			encrypt_sliced(q);
+		}
+		store_blocks(q, first, second);
+	}
+
+	KeePassCrypto::wipe(q, sizeof(q));
+	KeePassCrypto::wipe(spare, sizeof(spare));
+}
+
+void KeePassAesBitsliced::decrypt_CBC(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len)
+{
+	uint32_t q[8];
+	uint8_t prev[AES_BLOCK_SIZE];
+	uint8_t curr[AES_BLOCK_SIZE * SLICED_BLOCKS];
+	uint8_t spare[AES_BLOCK_SIZE];
+
+	_setKey(key);
+	memcpy(prev, iv, AES_BLOCK_SIZE);
+
+	//CBC decryption is parallel, blocks go by pairs
+	for (uint32_t offset = 0; offset + AES_BLOCK_SIZE <= data_len; offset += AES_BLOCK_SIZE * SLICED_BLOCKS) {
+		uint8_t *first = &data[offset];
+		uint8_t *second = spare;
+		uint32_t len = AES_BLOCK_SIZE;
+
+		if (offset + AES_BLOCK_SIZE * SLICED_BLOCKS <= data_len) {
+			second = &data[offset + AES_BLOCK_SIZE];
+			len = AES_BLOCK_SIZE * SLICED_BLOCKS;
+		}
+		else {
+			memcpy(spare, first, AES_BLOCK_SIZE);
+		}
+
+		memcpy(curr, first, len);
+		load_blocks(q, first, second);
+		decrypt_sliced(q);
+		store_blocks(q, first, second);
+
+		for (uint32_t i = 0; i < len; i++) {
+			data[offset + i] ^= (i < AES_BLOCK_SIZE) ? prev[i] : curr[i - AES_BLOCK_SIZE];
+		}
+		memcpy(prev, &curr[len - AES_BLOCK_SIZE], AES_BLOCK_SIZE);
+	}
+
+	KeePassCrypto::wipe(q, sizeof(q));
+	KeePassCrypto::wipe(spare, sizeof(spare));
+}
+
+void KeePassAesBitsliced::wipe()
+{
+	KeePassCrypto::wipe(sliced_key, sizeof(sliced_key));
+	KeePassCrypto::wipe(key_cache, sizeof(key_cache));
+	key_cached = false;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASS_AES_SOFTWARE
+
+#include <libopencm3/stm32/crypto.h>
+#include "keepass_aes.h"
+
+using namespace KeepAss;
+
+void KeePassAesHardware::encrypt_ECB(const uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles)
+{
+	crypto_set_key(CRYPTO_KEY_256BIT, (uint8_t*)key);
+	crypto_set_algorithm(ENCRYPT_AES_ECB);
+	crypto_set_datatype(CRYPTO_DATA_8BIT);
+	crypto_start();
+
+	for (uint32_t i = 0; i < cycles; i++) {
+		crypto_process_block((uint32_t*)data, (uint32_t*)data, data_len / sizeof(uint32_t));
+	}
+
+	crypto_stop();
+}
+
+void KeePassAesHardware::decrypt_CBC(const uint8_t *key, const uint8_t *iv, uint8_t *data, uint32_t data_len)
+{
+	crypto_set_key(CRYPTO_KEY_256BIT, (uint8_t*)key);
+	crypto_set_iv((uint8_t*)iv);
+	crypto_set_datatype(CRYPTO_DATA_8BIT);
+	crypto_set_algorithm(crypto_mode::DECRYPT_AES_CBC);
+	crypto_start();
+	crypto_process_block((uint32_t*)data, (uint32_t*)data, data_len / sizeof(uint32_t));
+	crypto_stop();
+}
+
+void KeePassAesHardware::wipe()
+{
+	//key and IV registers keep their values after crypto_stop()
+	uint8_t zero[32] = {0};
+
+	crypto_set_key(CRYPTO_KEY_256BIT, zero);
+	crypto_set_iv(zero);
+}
+
+#endif
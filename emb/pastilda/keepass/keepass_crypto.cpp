@@ -34,54 +34,209 @@ void KeePassCrypto::evalSHA256(const uint8_t *data, uint32_t len, uint8_t *hash)
 	cf_sha256_digest_final(&ctx, hash);
 }
 
-void KeePassCrypto::encrypt_AES_EBC(uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles)
+void KeePassCrypto::evalSHA512(const uint8_t *data, uint32_t len, uint8_t *hash)
 {
-	crypto_set_key(CRYPTO_KEY_256BIT, key);
-	crypto_set_algorithm(ENCRYPT_AES_ECB);
-	crypto_set_datatype(CRYPTO_DATA_8BIT);
-	crypto_start();
-
-	for (int i = 0; i < cycles; i++) {
-		crypto_process_block((uint32_t*)data, (uint32_t*)data, data_len / sizeof(uint32_t));
-	}
+	cf_sha512_context ctx;
+	cf_sha512_init(&ctx);
+	cf_sha512_update(&ctx, data, len);
+	cf_sha512_digest_final(&ctx, hash);
+}
 
-	crypto_stop();
+void KeePassCrypto::encrypt_AES_EBC(uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles)
+{
+	KeePassAes::encrypt_ECB(key, data, data_len, cycles);
 }
 
 void KeePassCrypto::decrypt_AES_CBC(uint8_t *key, uint8_t *iv, uint8_t *data, uint32_t data_len)
 {
-	crypto_set_key(CRYPTO_KEY_256BIT, key);
-	crypto_set_iv(iv);
-	crypto_set_datatype(CRYPTO_DATA_8BIT);
-	crypto_set_algorithm(crypto_mode::DECRYPT_AES_CBC);
-	crypto_start();
-	crypto_process_block((uint32_t*)data, (uint32_t*)data, data_len / sizeof(uint32_t));
-	crypto_stop();
+	KeePassAes::decrypt_CBC(key, iv, data, data_len);
+}
+
+void KeePassCrypto::wipe_AES()
+{
+	KeePassAes::wipe();
 }
 
+//chars out of the alphabet have both top bits set in kBase64DecodeTable
+static constexpr uint8_t BASE64_INVALID = 0xC0;
+static constexpr uint8_t BASE64_PAD = '=';
+
+//both ciphers have 64-byte blocks, several of them are generated per refill
+static constexpr uint32_t KEY_STREAM_BLOCKS = 4;
+static constexpr uint32_t KEY_STREAM_SIZE = KEY_STREAM_BLOCKS * Salsa20::BLOCK_SIZE;
+static_assert((size_t)Salsa20::BLOCK_SIZE == (size_t)ChaCha20::BLOCK_SIZE, "inner stream block sizes differ");
+
+static InnerRandomStream stream_algorithm = SALSA20_STREAM;
 static Salsa20 salsa;
-static uint8_t key_stream[Salsa20::BLOCK_SIZE];
-static uint8_t stream_pointer;
+static ChaCha20 chacha;
+static uint8_t key_stream[KEY_STREAM_SIZE];
+static uint32_t stream_pointer;
 
-void KeePassCrypto::init_Salsa20(uint8_t *key, const uint8_t *iv)
+static void generate_key_stream()
 {
-	salsa.setKey(key);
-	salsa.setIv(iv);
-	stream_pointer = 0;
-	memset(key_stream, 0, Salsa20::BLOCK_SIZE);
-	salsa.generateKeyStream(key_stream);
+	for (uint32_t i = 0; i < KEY_STREAM_BLOCKS; ++i) {
+		uint8_t *block = &key_stream[i * Salsa20::BLOCK_SIZE];
+		if (stream_algorithm == CHACHA20_STREAM) {
+			chacha.generateKeyStream(block);
+		}
+		else {
+			salsa.generateKeyStream(block);
+		}
+	}
 }
 
-void KeePassCrypto::eval_Salsa20(uint8_t *input, uint32_t length)
+void KeePassCrypto::init_inner_stream(InnerRandomStream algorithm, const uint8_t *key, const uint8_t *iv)
 {
-	for (int i = 0; i < length; i++) {
-		input[i] = input[i] ^ key_stream[stream_pointer];
-		stream_pointer++;
+	stream_algorithm = algorithm;
+
+	if (stream_algorithm == CHACHA20_STREAM) {
+		chacha.setKey(key);
+		chacha.setIv(iv);
+	}
+	else {
+		salsa.setKey(key);
+		salsa.setIv(iv);
+	}
 
-		if (stream_pointer >= Salsa20::BLOCK_SIZE) {
-			memset(key_stream, 0, Salsa20::BLOCK_SIZE);
-			salsa.generateKeyStream(key_stream);
+	generate_key_stream();
+	stream_pointer = 0;
+}
+
+void KeePassCrypto::eval_inner_stream(uint8_t *input, uint32_t length)
+{
+	//xor in runs up to the end of the current keystream block
+	while (length > 0) {
+		if (stream_pointer >= KEY_STREAM_SIZE) {
+			generate_key_stream();
 			stream_pointer = 0;
 		}
+
+		uint32_t run = KEY_STREAM_SIZE - stream_pointer;
+		if (run > length) {
+			run = length;
+		}
+
+		const uint8_t *ks = &key_stream[stream_pointer];
+		for (uint32_t i = 0; i < run; i++) {
+			input[i] ^= ks[i];
+		}
+
+		input += run;
+		length -= run;
+		stream_pointer += run;
 	}
 }
+
+void KeePassCrypto::seek_inner_stream(uint32_t offset)
+{
+	uint32_t block = offset / Salsa20::BLOCK_SIZE;
+
+	if (stream_algorithm == CHACHA20_STREAM) {
+		chacha.setCounter(block);
+	}
+	else {
+		salsa.setCounter(block);
+	}
+
+	generate_key_stream();
+	stream_pointer = offset % Salsa20::BLOCK_SIZE;
+}
+
+void KeePassCrypto::wipe(void *data, uint32_t length)
+{
+	//volatile keeps the compiler from dropping stores to dead buffers
+	volatile uint8_t *p = (volatile uint8_t*)data;
+
+	while (length--) {
+		*p++ = 0;
+	}
+}
+
+bool KeePassCrypto::decode_protected(const uint8_t *encoded, uint32_t encoded_len, uint32_t offset,
+									 uint8_t *plain, uint32_t plain_size, uint32_t *plain_len)
+{
+	uint32_t quads = encoded_len / 4;
+	const uint8_t *in = encoded;
+	uint8_t *out = plain;
+	uint8_t invalid = 0;
+
+	*plain_len = 0;
+	if ((encoded_len % 4) != 0 || (quads * 3) > plain_size) {
+		return (false);
+	}
+
+	seek_inner_stream(offset);
+
+	//base64 decoding and keystream xor in one pass, the value
+	//in the store stays encoded, only the caller's buffer gets it
+	for (uint32_t q = 0; q < quads; q++, in += 4) {
+		uint8_t c2 = in[2];
+		uint8_t c3 = in[3];
+		uint32_t bytes = 3;
+
+		if (q == quads - 1 && c3 == BASE64_PAD) {
+			bytes = (c2 == BASE64_PAD) ? 1 : 2;
+			c2 = (c2 == BASE64_PAD) ? 'A' : c2;
+			c3 = 'A';
+		}
+
+		uint8_t d0 = kBase64DecodeTable[in[0]];
+		uint8_t d1 = kBase64DecodeTable[in[1]];
+		uint8_t d2 = kBase64DecodeTable[c2];
+		uint8_t d3 = kBase64DecodeTable[c3];
+		invalid |= d0 | d1 | d2 | d3;
+
+		uint32_t word = ((uint32_t)d0 << 18) | ((uint32_t)d1 << 12) | ((uint32_t)d2 << 6) | d3;
+		uint8_t decoded[3] = {(uint8_t)(word >> 16), (uint8_t)(word >> 8), (uint8_t)word};
+
+		if (stream_pointer + bytes <= KEY_STREAM_SIZE) {
+			for (uint32_t i = 0; i < bytes; i++) {
+				out[i] = decoded[i] ^ key_stream[stream_pointer + i];
+			}
+			stream_pointer += bytes;
+		}
+		else {
+			memcpy(out, decoded, bytes);
+			eval_inner_stream(out, bytes);
+		}
+
+		out += bytes;
+	}
+
+	if (invalid & BASE64_INVALID) {
+		wipe(plain, plain_size);
+		return (false);
+	}
+
+	*plain_len = out - plain;
+	return (true);
+}
+
+bool KeePassCrypto::decode_protected_part(const uint8_t *encoded, uint32_t encoded_len, uint32_t offset,
+										  uint32_t position, uint8_t *plain, uint32_t plain_size,
+										  uint32_t *plain_len)
+{
+	uint32_t start = (position / 3) * 4;
+	uint32_t value_len = (encoded_len / 4) * 3;
+
+	//the last part may end inside the padded quad
+	if (encoded_len >= 4 && encoded[encoded_len - 1] == BASE64_PAD) {
+		value_len -= (encoded[encoded_len - 2] == BASE64_PAD) ? 2 : 1;
+	}
+
+	*plain_len = 0;
+	if (position >= value_len) {
+		return (true);
+	}
+	if ((position % 3) != 0 || (plain_size % 3) != 0 || plain_size == 0) {
+		return (false);
+	}
+
+	uint32_t part_len = encoded_len - start;
+	if (part_len / 4 > plain_size / 3) {
+		part_len = (plain_size / 3) * 4;
+	}
+	return (decode_protected(&encoded[start], part_len, offset + position,
+							 plain, plain_size, plain_len));
+}
+
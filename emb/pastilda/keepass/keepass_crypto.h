@@ -27,9 +27,11 @@
 
 #include <lib/crypto/base64.h>
 #include <lib/crypto/salsa20.h>
+#include <lib/crypto/chacha20.h>
 #include <stdint.h>
 #include <string.h>
-#include <libopencm3/stm32/crypto.h>
+#include "keepass_aes.h"
+#include "keepass_reader_defines.h"
 extern "C" {
 #include <lib/crypto/sha2.h>
 }
@@ -41,10 +43,21 @@ namespace KeepAss
 	public:
 		KeePassCrypto() {};
 		static void evalSHA256(const uint8_t *data, uint32_t len, uint8_t *hash);
+		static void evalSHA512(const uint8_t *data, uint32_t len, uint8_t *hash);
 		static void encrypt_AES_EBC(uint8_t *key, uint8_t *data, uint32_t data_len, uint32_t cycles);
 		static void decrypt_AES_CBC(uint8_t *key, uint8_t *iv, uint8_t *data, uint32_t data_len);
-		static void init_Salsa20(uint8_t *key, const uint8_t *iv);
-		static void eval_Salsa20(uint8_t *input, uint32_t length);
+		static void wipe_AES();
+		static void init_inner_stream(InnerRandomStream algorithm, const uint8_t *key, const uint8_t *iv);
+		static void eval_inner_stream(uint8_t *input, uint32_t length);
+		static void seek_inner_stream(uint32_t offset);
+		static bool decode_protected(const uint8_t *encoded, uint32_t encoded_len, uint32_t offset,
+									 uint8_t *plain, uint32_t plain_size, uint32_t *plain_len);
+		//part of the value from the plain position, base64 is decoded by quads,
+		//so position and plain_size are multiples of 3, plain_len is 0 at the end
+		static bool decode_protected_part(const uint8_t *encoded, uint32_t encoded_len, uint32_t offset,
+										  uint32_t position, uint8_t *plain, uint32_t plain_size,
+										  uint32_t *plain_len);
+		static void wipe(void *data, uint32_t length);
 	};
 }
 #endif
@@ -0,0 +1,577 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <keepass_inflate.h>
+
+using namespace KeepAss;
+
+namespace
+{
+	constexpr uint8_t GZIP_ID1				= 0x1F;
+	constexpr uint8_t GZIP_ID2				= 0x8B;
+	constexpr uint8_t GZIP_CM_DEFLATE		= 8;
+	constexpr uint8_t GZIP_FLAG_HCRC		= 0x02;
+	constexpr uint8_t GZIP_FLAG_EXTRA		= 0x04;
+	constexpr uint8_t GZIP_FLAG_NAME		= 0x08;
+	constexpr uint8_t GZIP_FLAG_COMMENT		= 0x10;
+
+	constexpr uint16_t END_OF_BLOCK			= 256;
+	constexpr uint32_t WINDOW_MASK			= INFLATE_WINDOW_SIZE_IN_BYTES - 1;
+
+	constexpr uint16_t LENGTH_BASE[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+
+	constexpr uint8_t LENGTH_EXTRA[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	constexpr uint16_t DIST_BASE[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+		8193, 12289, 16385, 24577
+	};
+
+	constexpr uint8_t DIST_EXTRA[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	constexpr uint8_t CODE_LENGTHS_ORDER[INFLATE_MAX_CODE_LENGTHS] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	constexpr uint32_t CRC32_TABLE[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+}
+
+KeePassInflate::KeePassInflate()
+{
+	_source = nullptr;
+	_result = DecryptionResult::SUCCESS;
+	_state = FINISHED;
+	_last_block = false;
+	_input_pos = 0;
+	_input_len = 0;
+	_bit_buf = 0;
+	_bit_count = 0;
+	_window_pos = 0;
+	_copy_len = 0;
+	_copy_dist = 0;
+	_crc = 0;
+	_total_size = 0;
+}
+
+DecryptionResult KeePassInflate::init(KeePassStream *source)
+{
+	_source = source;
+	_result = SUCCESS;
+	_state = BLOCK_HEADER;
+	_last_block = false;
+	_input_pos = 0;
+	_input_len = 0;
+	_bit_buf = 0;
+	_bit_count = 0;
+	_window_pos = 0;
+	_copy_len = 0;
+	_copy_dist = 0;
+	_crc = 0xFFFFFFFF;
+	_total_size = 0;
+
+	_readHeader();
+	return (_result);
+}
+
+int32_t KeePassInflate::read(uint8_t *buffer, uint32_t size)
+{
+	uint32_t done = 0;
+
+	while ((done < size) && (_result == SUCCESS))
+	{
+		switch (_state)
+		{
+			case BLOCK_HEADER:
+				if (_last_block) {
+					_state = TRAILER;
+				}
+				else {
+					_readBlockHeader();
+				}
+			break;
+
+			case STORED_BLOCK:
+				while ((_copy_len > 0) && (done < size) && (_result == SUCCESS)) {
+					_put(buffer, done, _getByte());
+					_copy_len--;
+				}
+				if (_copy_len == 0) {
+					_state = BLOCK_HEADER;
+				}
+			break;
+
+			case MATCH_COPY:
+				while ((_copy_len > 0) && (done < size)) {
+					_put(buffer, done, _window[(_window_pos - _copy_dist) & WINDOW_MASK]);
+					_copy_len--;
+				}
+				if (_copy_len == 0) {
+					_state = HUFFMAN_BLOCK;
+				}
+			break;
+
+			case HUFFMAN_BLOCK:
+			{
+				int32_t symbol = _decodeSymbol(&_lit_table);
+				if (symbol < 0) {
+					break;
+				}
+
+				if (symbol < END_OF_BLOCK) {
+					_put(buffer, done, (uint8_t)symbol);
+				}
+				else if (symbol == END_OF_BLOCK) {
+					_state = BLOCK_HEADER;
+				}
+				else if (_decodeMatch(symbol)) {
+					_state = MATCH_COPY;
+				}
+			}
+			break;
+
+			case TRAILER:
+				_readTrailer();
+			break;
+
+			case FINISHED:
+				return (done);
+		}
+	}
+
+	if (_result != SUCCESS) {
+		return (-1);
+	}
+
+	return (done);
+}
+
+DecryptionResult KeePassInflate::read_to_end()
+{
+	uint8_t buffer[AES_BLOCK_SIZE_IN_BYTES * 4];
+
+	while (read(buffer, sizeof(buffer)) > 0);
+	memset(buffer, 0, sizeof(buffer));
+
+	return (_result);
+}
+
+void KeePassInflate::close()
+{
+	memset(_window, 0, sizeof(_window));
+	memset(_input, 0, sizeof(_input));
+	_bit_buf = 0;
+	_source = nullptr;
+	_state = FINISHED;
+}
+
+int KeePassInflate::read_callback(void *inflate, unsigned char *buffer, int size)
+{
+	return (static_cast<KeePassInflate*>(inflate)->read(buffer, size));
+}
+
+bool KeePassInflate::_readHeader()
+{
+	//header organized as follows:
+	//2 bytes = magic, 1 byte = compression method, 1 byte = flags
+	//4 bytes = modification time, 1 byte = extra flags, 1 byte = OS
+	//then optional fields marked in flags
+	uint8_t id1 = _getByte();
+	uint8_t id2 = _getByte();
+	uint8_t method = _getByte();
+	uint8_t flags = _getByte();
+
+	if (id1 != GZIP_ID1 || id2 != GZIP_ID2 || method != GZIP_CM_DEFLATE) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+
+	for (int i = 0; i < 6; i++) {
+		_getByte();
+	}
+
+	if (flags & GZIP_FLAG_EXTRA) {
+		uint32_t extra_len = _getByte();
+		extra_len |= (uint32_t)_getByte() << 8;
+		while ((extra_len-- > 0) && (_result == SUCCESS)) {
+			_getByte();
+		}
+	}
+
+	if (flags & GZIP_FLAG_NAME) {
+		while ((_getByte() != 0) && (_result == SUCCESS));
+	}
+
+	if (flags & GZIP_FLAG_COMMENT) {
+		while ((_getByte() != 0) && (_result == SUCCESS));
+	}
+
+	if (flags & GZIP_FLAG_HCRC) {
+		_getByte();
+		_getByte();
+	}
+
+	return (_result == SUCCESS);
+}
+
+bool KeePassInflate::_readBlockHeader()
+{
+	_last_block = (_getBits(1) == 1);
+	uint32_t type = _getBits(2);
+
+	switch (type)
+	{
+		case 0:
+		{
+			_alignToByte();
+			uint32_t len = _getByte();
+			len |= (uint32_t)_getByte() << 8;
+			uint32_t nlen = _getByte();
+			nlen |= (uint32_t)_getByte() << 8;
+
+			if (len != (~nlen & 0xFFFF)) {
+				_fail(COMPRESSION_ERROR);
+				return (false);
+			}
+
+			_copy_len = len;
+			_state = STORED_BLOCK;
+		}
+		break;
+
+		case 1:
+			if (!_buildFixedTables()) {
+				return (false);
+			}
+			_state = HUFFMAN_BLOCK;
+		break;
+
+		case 2:
+			if (!_buildDynamicTables()) {
+				return (false);
+			}
+			_state = HUFFMAN_BLOCK;
+		break;
+
+		default:
+			_fail(COMPRESSION_ERROR);
+			return (false);
+	}
+
+	return (_result == SUCCESS);
+}
+
+bool KeePassInflate::_buildTable(HuffmanTable *table, const uint8_t *lengths, uint32_t count)
+{
+	uint16_t offsets[INFLATE_MAX_BITS + 1];
+
+	memset(table->count, 0, sizeof(table->count));
+	for (uint32_t symbol = 0; symbol < count; symbol++) {
+		table->count[lengths[symbol]]++;
+	}
+
+	if (table->count[0] == count) {
+		return (true);
+	}
+
+	//check for an over-subscribed set of lengths
+	int32_t left = 1;
+	for (uint32_t len = 1; len <= INFLATE_MAX_BITS; len++) {
+		left <<= 1;
+		left -= table->count[len];
+		if (left < 0) {
+			_fail(COMPRESSION_ERROR);
+			return (false);
+		}
+	}
+
+	offsets[1] = 0;
+	for (uint32_t len = 1; len < INFLATE_MAX_BITS; len++) {
+		offsets[len + 1] = offsets[len] + table->count[len];
+	}
+
+	for (uint32_t symbol = 0; symbol < count; symbol++) {
+		if (lengths[symbol] != 0) {
+			table->symbol[offsets[lengths[symbol]]++] = symbol;
+		}
+	}
+
+	return (true);
+}
+
+bool KeePassInflate::_buildFixedTables()
+{
+	uint8_t lengths[INFLATE_MAX_LIT_CODES];
+	uint32_t symbol = 0;
+
+	for (; symbol < 144; symbol++) {
+		lengths[symbol] = 8;
+	}
+	for (; symbol < 256; symbol++) {
+		lengths[symbol] = 9;
+	}
+	for (; symbol < 280; symbol++) {
+		lengths[symbol] = 7;
+	}
+	for (; symbol < INFLATE_MAX_LIT_CODES; symbol++) {
+		lengths[symbol] = 8;
+	}
+	_buildTable(&_lit_table, lengths, INFLATE_MAX_LIT_CODES);
+
+	memset(lengths, 5, INFLATE_MAX_DIST_CODES);
+	return (_buildTable(&_dist_table, lengths, INFLATE_MAX_DIST_CODES));
+}
+
+bool KeePassInflate::_buildDynamicTables()
+{
+	uint8_t lengths[INFLATE_MAX_LIT_CODES + INFLATE_MAX_DIST_CODES];
+
+	uint32_t lit_count = _getBits(5) + 257;
+	uint32_t dist_count = _getBits(5) + 1;
+	uint32_t code_count = _getBits(4) + 4;
+
+	if (lit_count > INFLATE_MAX_LIT_CODES || dist_count > INFLATE_MAX_DIST_CODES) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+
+	//code length code lengths go first, the literal/length
+	//and distance tables are encoded with this code
+	memset(lengths, 0, INFLATE_MAX_CODE_LENGTHS);
+	for (uint32_t i = 0; i < code_count; i++) {
+		lengths[CODE_LENGTHS_ORDER[i]] = _getBits(3);
+	}
+
+	if (!_buildTable(&_lit_table, lengths, INFLATE_MAX_CODE_LENGTHS)) {
+		return (false);
+	}
+
+	uint32_t index = 0;
+	while ((index < lit_count + dist_count) && (_result == SUCCESS))
+	{
+		int32_t symbol = _decodeSymbol(&_lit_table);
+		uint32_t repeat = 0;
+		uint8_t value = 0;
+
+		if (symbol < 0) {
+			return (false);
+		}
+
+		if (symbol < 16) {
+			lengths[index++] = symbol;
+			continue;
+		}
+
+		if (symbol == 16) {
+			if (index == 0) {
+				_fail(COMPRESSION_ERROR);
+				return (false);
+			}
+			value = lengths[index - 1];
+			repeat = 3 + _getBits(2);
+		}
+		else if (symbol == 17) {
+			repeat = 3 + _getBits(3);
+		}
+		else {
+			repeat = 11 + _getBits(7);
+		}
+
+		if (index + repeat > lit_count + dist_count) {
+			_fail(COMPRESSION_ERROR);
+			return (false);
+		}
+
+		while (repeat-- > 0) {
+			lengths[index++] = value;
+		}
+	}
+
+	//block without end-of-block code can't be decoded
+	if (lengths[END_OF_BLOCK] == 0) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+
+	return (_buildTable(&_lit_table, lengths, lit_count) &&
+			_buildTable(&_dist_table, &lengths[lit_count], dist_count));
+}
+
+int32_t KeePassInflate::_decodeSymbol(const HuffmanTable *table)
+{
+	//canonical huffman codes: the codes of each length are consecutive,
+	//so the symbol is found by comparing code with the first code
+	//of the current length
+	int32_t code = 0;
+	int32_t first = 0;
+	int32_t index = 0;
+
+	for (uint32_t len = 1; len <= INFLATE_MAX_BITS; len++)
+	{
+		code |= _getBits(1);
+		int32_t count = table->count[len];
+
+		if (code - first < count) {
+			return (table->symbol[index + (code - first)]);
+		}
+
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	_fail(COMPRESSION_ERROR);
+	return (-1);
+}
+
+bool KeePassInflate::_decodeMatch(uint32_t symbol)
+{
+	symbol -= END_OF_BLOCK + 1;
+	if (symbol >= sizeof(LENGTH_BASE) / sizeof(LENGTH_BASE[0])) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+	_copy_len = LENGTH_BASE[symbol] + _getBits(LENGTH_EXTRA[symbol]);
+
+	int32_t dist_symbol = _decodeSymbol(&_dist_table);
+	if (dist_symbol < 0) {
+		return (false);
+	}
+	if (dist_symbol >= (int32_t)INFLATE_MAX_DIST_CODES) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+	_copy_dist = DIST_BASE[dist_symbol] + _getBits(DIST_EXTRA[dist_symbol]);
+
+	if (_copy_dist > _total_size) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+
+	return (_result == SUCCESS);
+}
+
+bool KeePassInflate::_readTrailer()
+{
+	//trailer organized as follows:
+	//4 bytes = CRC32 of uncompressed data
+	//4 bytes = size of uncompressed data modulo 2^32
+	_alignToByte();
+
+	uint32_t crc = 0;
+	uint32_t size = 0;
+	for (int i = 0; i < 4; i++) {
+		crc |= (uint32_t)_getByte() << (8 * i);
+	}
+	for (int i = 0; i < 4; i++) {
+		size |= (uint32_t)_getByte() << (8 * i);
+	}
+
+	if (_result != SUCCESS) {
+		return (false);
+	}
+
+	if (crc != (_crc ^ 0xFFFFFFFF) || size != _total_size) {
+		_fail(COMPRESSION_ERROR);
+		return (false);
+	}
+
+	_state = FINISHED;
+	return (true);
+}
+
+uint32_t KeePassInflate::_getBits(uint32_t count)
+{
+	while (_bit_count < count) {
+		_bit_buf |= (uint32_t)_getByte() << _bit_count;
+		_bit_count += 8;
+	}
+
+	uint32_t value = _bit_buf & ((1UL << count) - 1);
+	_bit_buf >>= count;
+	_bit_count -= count;
+
+	return (value);
+}
+
+uint8_t KeePassInflate::_getByte()
+{
+	if (_input_pos >= _input_len) {
+		if (_result != SUCCESS) {
+			return (0);
+		}
+
+		int32_t len = _source->read(_input, INFLATE_INPUT_SIZE_IN_BYTES);
+		if (len <= 0) {
+			DecryptionResult source_result = _source->get_result();
+			_fail(source_result != SUCCESS ? source_result : COMPRESSION_ERROR);
+			return (0);
+		}
+
+		_input_pos = 0;
+		_input_len = len;
+	}
+
+	return (_input[_input_pos++]);
+}
+
+void KeePassInflate::_alignToByte()
+{
+	_bit_buf = 0;
+	_bit_count = 0;
+}
+
+void KeePassInflate::_fail(DecryptionResult result)
+{
+	if (_result == SUCCESS) {
+		_result = result;
+	}
+}
+
+inline void KeePassInflate::_put(uint8_t *buffer, uint32_t &done, uint8_t value)
+{
+	_window[_window_pos & WINDOW_MASK] = value;
+	_window_pos++;
+	_total_size++;
+	buffer[done++] = value;
+
+	_crc ^= value;
+	_crc = (_crc >> 4) ^ CRC32_TABLE[_crc & 0x0F];
+	_crc = (_crc >> 4) ^ CRC32_TABLE[_crc & 0x0F];
+}
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASS_INFLATE_H
+#define KEEPASS_INFLATE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "keepass_reader_defines.h"
+#include "keepass_stream.h"
+
+namespace KeepAss
+{
+	constexpr uint32_t INFLATE_WINDOW_SIZE_IN_BYTES		= 32768;
+	constexpr uint32_t INFLATE_INPUT_SIZE_IN_BYTES		= 128;
+	constexpr uint32_t INFLATE_MAX_BITS					= 15;
+	constexpr uint32_t INFLATE_MAX_LIT_CODES			= 288;
+	constexpr uint32_t INFLATE_MAX_DIST_CODES			= 30;
+	constexpr uint32_t INFLATE_MAX_CODE_LENGTHS			= 19;
+
+	// Streaming GZip (RFC 1952) / Deflate (RFC 1951) decoder.
+	//
+	// Compressed data is pulled from the KeePassStream by small pieces and
+	// decoded into a fixed 32 KB history window, no heap is used. read()
+	// stops as soon as the output buffer is full and resumes from the same
+	// place (literal, match copy or stored block) on the next call. CRC32
+	// and size from the gzip trailer are checked at the end of the stream.
+	//
+	// Huffman codes are decoded bit by bit, so the inflate costs about what
+	// is saved by decrypting and hashing a payload several times smaller
+	// (see bench_unlock). Gzipped database unlocks in about the same time,
+	// but the file read from flash is much smaller.
+	class KeePassInflate
+	{
+	public:
+		KeePassInflate();
+		DecryptionResult init(KeePassStream *source);
+		int32_t read(uint8_t *buffer, uint32_t size);
+		DecryptionResult read_to_end();
+		void close();
+
+		DecryptionResult get_result() {
+			return (_result);
+		}
+
+		// Adapter for mxmlLoadStream()
+		static int read_callback(void *inflate, unsigned char *buffer, int size);
+
+	private:
+		typedef enum : uint8_t
+		{
+			BLOCK_HEADER,
+			STORED_BLOCK,
+			HUFFMAN_BLOCK,
+			MATCH_COPY,
+			TRAILER,
+			FINISHED
+		} State;
+
+		typedef struct
+		{
+			uint16_t count[INFLATE_MAX_BITS + 1];
+			uint16_t symbol[INFLATE_MAX_LIT_CODES];
+		} HuffmanTable;
+
+		KeePassStream *_source;
+		DecryptionResult _result;
+		State _state;
+		bool _last_block;
+
+		uint8_t _input[INFLATE_INPUT_SIZE_IN_BYTES];
+		uint32_t _input_pos;
+		uint32_t _input_len;
+		uint32_t _bit_buf;
+		uint32_t _bit_count;
+
+		uint8_t _window[INFLATE_WINDOW_SIZE_IN_BYTES];
+		uint32_t _window_pos;
+		uint32_t _copy_len;
+		uint32_t _copy_dist;
+
+		HuffmanTable _lit_table;
+		HuffmanTable _dist_table;
+
+		uint32_t _crc;
+		uint32_t _total_size;
+
+		bool _readHeader();
+		bool _readBlockHeader();
+		bool _buildTable(HuffmanTable *table, const uint8_t *lengths, uint32_t count);
+		bool _buildFixedTables();
+		bool _buildDynamicTables();
+		int32_t _decodeSymbol(const HuffmanTable *table);
+		bool _decodeMatch(uint32_t symbol);
+		bool _readTrailer();
+
+		uint32_t _getBits(uint32_t count);
+		uint8_t _getByte();
+		void _alignToByte();
+		void _fail(DecryptionResult result);
+
+		inline void _put(uint8_t *buffer, uint32_t &done, uint8_t value);
+	};
+}
+#endif
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/desig.h>
+#include <keepass_quick_unlock.h>
+#include "systick_ext.h"
+
+using namespace KeepAss;
+
+KeePassQuickUnlock::KeePassQuickUnlock()
+{
+	_pin_rounds_done = 0;
+	wipe();
+}
+
+bool KeePassQuickUnlock::start_pin_key(const uint8_t *pin, uint32_t pin_len, const uint8_t *fingerprint)
+{
+	uint8_t salted_pin[QUICK_UNLOCK_MAX_PIN_LENGTH + DEVICE_ID_SIZE_IN_BYTES + HASH_LENGTH];
+
+	_wipePinKey();
+	if (!is_valid_pin(pin_len)) {
+		return (false);
+	}
+	uint8_t *device_id = &salted_pin[pin_len];
+
+	//the PIN hash is the data of AES rounds,
+	//the hash of the chip ID and the fingerprint is their key
+	memcpy(&salted_pin[0], pin, pin_len);
+	_readDeviceId(device_id);
+	memcpy(&device_id[DEVICE_ID_SIZE_IN_BYTES], fingerprint, HASH_LENGTH);
+	KeePassCrypto::evalSHA256(salted_pin, pin_len + DEVICE_ID_SIZE_IN_BYTES + HASH_LENGTH, _pin_key);
+	KeePassCrypto::evalSHA256(device_id, DEVICE_ID_SIZE_IN_BYTES + HASH_LENGTH, _pin_seed);
+
+	KeePassCrypto::wipe(salted_pin, sizeof(salted_pin));
+	return (true);
+}
+
+bool KeePassQuickUnlock::derive_pin_key()
+{
+	uint32_t start_ms = get_counter_ms();
+
+	while (_pin_rounds_done < QUICK_UNLOCK_PIN_ROUNDS) {
+		uint32_t rounds_left = QUICK_UNLOCK_PIN_ROUNDS - _pin_rounds_done;
+		uint32_t batch = (rounds_left < KDF_ROUNDS_PER_BATCH) ? rounds_left : KDF_ROUNDS_PER_BATCH;
+
+		KeePassCrypto::encrypt_AES_EBC(_pin_seed, _pin_key, HASH_LENGTH, batch);
+		_pin_rounds_done += batch;
+
+		if ((get_counter_ms() - start_ms) >= KDF_SLICE_TIME_MS) {
+			break;
+		}
+	}
+
+	if (_pin_rounds_done < QUICK_UNLOCK_PIN_ROUNDS) {
+		return (false);
+	}
+
+	KeePassCrypto::wipe_AES();  //schedule of the device bound seed
+	KeePassCrypto::evalSHA256(_pin_key, HASH_LENGTH, _pin_key);
+	return (true);
+}
+
+uint8_t KeePassQuickUnlock::get_progress()
+{
+	return ((uint8_t)((_pin_rounds_done * 100) / QUICK_UNLOCK_PIN_ROUNDS));
+}
+
+void KeePassQuickUnlock::seal(const uint8_t *transformed_key, const uint8_t *fingerprint, uint32_t write_count)
+{
+	for (uint32_t i = 0; i < HASH_LENGTH; i++) {
+		_sealed_key[i] = transformed_key[i] ^ _pin_key[i];
+	}
+	_wipePinKey();
+
+	memcpy(_fingerprint, fingerprint, HASH_LENGTH);
+	_write_count = write_count;
+	_attempts_left = QUICK_UNLOCK_MAX_ATTEMPTS;
+}
+
+bool KeePassQuickUnlock::is_sealed(uint32_t write_count)
+{
+	//database could be rewritten through mass storage
+	return ((_attempts_left > 0) && (write_count == _write_count));
+}
+
+bool KeePassQuickUnlock::is_ready(const uint8_t *fingerprint, uint32_t write_count)
+{
+	if (!is_sealed(write_count) || memcmp(fingerprint, _fingerprint, HASH_LENGTH)) {
+		wipe();
+		return (false);
+	}
+
+	return (true);
+}
+
+void KeePassQuickUnlock::unseal(uint8_t *transformed_key)
+{
+	for (uint32_t i = 0; i < HASH_LENGTH; i++) {
+		transformed_key[i] = _sealed_key[i] ^ _pin_key[i];
+	}
+	_wipePinKey();
+}
+
+void KeePassQuickUnlock::fail()
+{
+	if (_attempts_left > 0) {
+		_attempts_left--;
+	}
+
+	if (_attempts_left == 0) {
+		wipe();
+	}
+}
+
+void KeePassQuickUnlock::wipe()
+{
+	KeePassCrypto::wipe(_sealed_key, HASH_LENGTH);
+	KeePassCrypto::wipe(_fingerprint, HASH_LENGTH);
+	_write_count = 0;
+	_attempts_left = 0;
+	_wipePinKey();
+}
+
+void KeePassQuickUnlock::_readDeviceId(uint8_t *id)
+{
+	uint32_t words[DEVICE_ID_SIZE_IN_BYTES / sizeof(uint32_t)];
+
+	desig_get_unique_id(words);
+	memcpy(id, words, DEVICE_ID_SIZE_IN_BYTES);
+	KeePassCrypto::wipe(words, sizeof(words));
+}
+
+void KeePassQuickUnlock::_wipePinKey()
+{
+	KeePassCrypto::wipe(_pin_key, HASH_LENGTH);
+	KeePassCrypto::wipe(_pin_seed, HASH_LENGTH);
+	_pin_rounds_done = 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASS_QUICK_UNLOCK_H
+#define KEEPASS_QUICK_UNLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include "keepass_crypto.h"
+#include "keepass_reader_defines.h"
+
+namespace KeepAss
+{
+	// Cache of the transformed key for re-unlocking without the KDF rounds.
+	//
+	// After a full unlock the user may choose a PIN, the transformed key
+	// is kept XORed with a key derived from it. The PIN key is slow to
+	// derive: the PIN is hashed with the unique ID of the chip and the
+	// database fingerprint, then QUICK_UNLOCK_PIN_ROUNDS of AES are applied.
+	// The rounds are done in time slices by derive_pin_key(). They only
+	// slow a guess down, a short PIN is protected by the attempts limit:
+	// the cache is dropped after QUICK_UNLOCK_MAX_ATTEMPTS wrong PINs.
+	//
+	// The cache is bound to the fingerprint and to the flash write counter,
+	// so it is dropped as soon as the database file may have changed.
+	class KeePassQuickUnlock
+	{
+	public:
+		KeePassQuickUnlock();
+		bool start_pin_key(const uint8_t *pin, uint32_t pin_len, const uint8_t *fingerprint);
+		bool derive_pin_key();
+		uint8_t get_progress();
+		void seal(const uint8_t *transformed_key, const uint8_t *fingerprint, uint32_t write_count);
+		bool is_sealed(uint32_t write_count);
+		bool is_ready(const uint8_t *fingerprint, uint32_t write_count);
+		void unseal(uint8_t *transformed_key);
+		void fail();
+		void wipe();
+
+		uint32_t get_attempts_left() {
+			return (_attempts_left);
+		}
+
+		static bool is_valid_pin(uint32_t pin_len) {
+			return ((pin_len >= QUICK_UNLOCK_MIN_PIN_LENGTH) &&
+					(pin_len <= QUICK_UNLOCK_MAX_PIN_LENGTH));
+		}
+
+	private:
+		uint8_t _sealed_key[HASH_LENGTH];
+		uint8_t _fingerprint[HASH_LENGTH];
+		uint32_t _write_count;
+		uint32_t _attempts_left;
+		uint8_t _pin_key[HASH_LENGTH];
+		uint8_t _pin_seed[HASH_LENGTH];
+		uint32_t _pin_rounds_done;
+
+		void _readDeviceId(uint8_t *id);
+		void _wipePinKey();
+	};
+}
+#endif
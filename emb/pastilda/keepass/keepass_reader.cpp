@@ -23,6 +23,7 @@
  */
 
 #include <keepass_reader.h>
+#include "systick_ext.h"
 
 using namespace KeepAss;
 
@@ -30,13 +31,17 @@ constexpr uint8_t KeePassReader::IV_SALSA[8];
 
 KeePassReader::KeePassReader()
 {
-	_tree = nullptr;
 	_signature1 = 0;
 	_signature2 = 0;
 	_signature3 = 0;
 	_keyf_len = 0;
 	_pass_len = 0;
-	_file_len = 0;
+	_quick_unlocked = false;
+	_pin_expected = false;
+	_rounds = 0;
+	_rounds_done = 0;
+	_write_count = 0;
+	_stage = IDLE_STAGE;
 	_credentials = KeePassCredentials::NOT_SELECTED;
 }
 
@@ -109,116 +114,306 @@ void KeePassReader::_makeMasterKey(uint8_t *pass, uint8_t *keyfile, uint32_t pas
 }
 
 void KeePassReader::_makeKeyRoutine(uint8_t *key_hash)
+{
+	//rounds are stored as 64-bit value, the transformation itself
+	//is done in slices by _transformKey()
+	memcpy(&_rounds, _header[TRANSFORM_ROUNDS].data, sizeof(uint64_t));
+	_rounds_done = 0;
+
+	memcpy(_transformed_key, key_hash, HASH_LENGTH);
+	memset(key_hash, 0, HASH_LENGTH);
+}
+
+bool KeePassReader::_transformKey()
+{
+	uint32_t start_ms = get_counter_ms();
+
+	while (_rounds_done < _rounds) {
+		uint64_t rounds_left = _rounds - _rounds_done;
+		uint32_t batch = (rounds_left < KDF_ROUNDS_PER_BATCH) ? rounds_left : KDF_ROUNDS_PER_BATCH;
+
+		KeePassCrypto::encrypt_AES_EBC(_header[TRANSFORM_SEED].data, _transformed_key, HASH_LENGTH, batch);
+		_rounds_done += batch;
+
+		if ((get_counter_ms() - start_ms) >= KDF_SLICE_TIME_MS) {
+			break;
+		}
+	}
+
+	return (_rounds_done == _rounds);
+}
+
+void KeePassReader::_makeFinalKey(const uint8_t *transformed_key)
 {
 	uint8_t final_key[MASTER_KEY_LENGTH_2X];
 	memcpy(&final_key[0], _header[MASTER_SEED].data, _header[MASTER_SEED].size);
 
-	uint16_t rounds = (*(uint16_t*)_header[TRANSFORM_ROUNDS].data);
+	KeePassCrypto::evalSHA256(transformed_key, HASH_LENGTH, &final_key[_header[MASTER_SEED].size]);
+	KeePassCrypto::evalSHA256(final_key, MASTER_KEY_LENGTH_2X, _master_key);
+	memset(final_key, 0, MASTER_KEY_LENGTH_2X);
+}
+
+void KeePassReader::_makeFingerprint()
+{
+	//KeePass generates new seeds and IV on every saving,
+	//so they identify the database file together with its size
+	const HeaderFieldName fields[] = {MASTER_SEED, TRANSFORM_SEED, TRANSFORM_ROUNDS, ENCRYPTION_IV};
+	uint8_t data[sizeof(fields) * MAX_HEADER_FIELD_SIZE + sizeof(uint32_t)];
+	uint32_t len = 0;
+
+	for (HeaderFieldName field : fields) {
+		memcpy(&data[len], _header[field].data, _header[field].size);
+		len += _header[field].size;
+	}
+
+	uint32_t file_size = _file.fsize;
+	memcpy(&data[len], &file_size, sizeof(uint32_t));
+	len += sizeof(uint32_t);
 
-	KeePassCrypto::encrypt_AES_EBC(_header[TRANSFORM_SEED].data, key_hash, HASH_LENGTH, rounds);
+	KeePassCrypto::evalSHA256(data, len, _fingerprint);
+}
 
-	KeePassCrypto::evalSHA256(key_hash, HASH_LENGTH, &final_key[_header[MASTER_SEED].size]);
-	KeePassCrypto::evalSHA256(final_key, MASTER_KEY_LENGTH_2X, _master_key);
+DecryptionResult KeePassReader::_quickDecrypt()
+{
+	_quick_unlock.unseal(_transformed_key);
+	_makeFinalKey(_transformed_key);
+	KeePassCrypto::wipe(_transformed_key, HASH_LENGTH);
+
+	DecryptionResult result = _decrypt();
+
+	if (result == MASTER_KEY_ERROR) {
+		_quick_unlock.fail();
+	}
+	_quick_unlocked = (result == SUCCESS);
+
+	return (result);
+}
+
+DecryptionResult KeePassReader::_sealPin()
+{
+	_quick_unlock.seal(_transformed_key, _fingerprint, _write_count);
+	_wipeKeys();
+
+	return (SUCCESS);
+}
+
+void KeePassReader::_wipeKeys()
+{
+	KeePassCrypto::wipe(_master_key, HASH_LENGTH);
+	KeePassCrypto::wipe(_transformed_key, HASH_LENGTH);
+	_pin_expected = false;
 }
 
 DecryptionResult KeePassReader::_decrypt()
 {
-	uint8_t hash[HASH_LENGTH];
-	memset(_decrypted_data, 0, MAX_DATABASE_SIZE_IN_BYTES);
+	_stage = PAYLOAD_STAGE;
 
-	_file_len = _file.fsize - FileSystem::get_file_tell(&_file);
-	FileSystem::read_next_file_chunk(&_file, _decrypted_data, _file_len);
-	if (FileSystem::close_file(&_file) != FR_OK) {
-		return (DB_FILE_ERROR);
+	DecryptionResult result = _stream.open(&_file,
+										   _master_key,
+										   _header[ENCRYPTION_IV].data,
+										   _header[STREAM_START_BYTES].data,
+										   _header[STREAM_START_BYTES].size);
+	KeePassCrypto::wipe(_master_key, HASH_LENGTH);
+
+	if (result == SUCCESS) {
+		result = _loadXml();
 	}
 
-	KeePassCrypto::decrypt_AES_CBC(_master_key, _header[ENCRYPTION_IV].data, _decrypted_data, _file_len);
+	_stream.close();
+	if (FileSystem::close_file(&_file) != FR_OK && result == SUCCESS) {
+		result = DB_FILE_ERROR;
+	}
 
-	if (memcmp(_header[STREAM_START_BYTES].data, _decrypted_data, _header[STREAM_START_BYTES].size)) {
-		return (MASTER_KEY_ERROR);
+	//the parsing index is packed into the store and freed
+	if (result == SUCCESS && _store.build(_index) == false) {
+		result = XML_ERROR;
 	}
+	_index.clear();
 
-	_file_len -= _header[STREAM_START_BYTES].size;
-	return (_process_blocks());
+	if (result == SUCCESS) {
+		_initInnerStream();
+	}
+	else {
+		_store.clear();
+	}
+
+	return (result);
 }
 
-DecryptionResult KeePassReader::_process_blocks()
+DecryptionResult KeePassReader::_loadXml()
 {
-	uint8_t hash[HASH_LENGTH];
-	uint32_t data_size = 0;
-	uint32_t offset = _header[STREAM_START_BYTES].size;
-	BlockDataHeader block_data;
-
-	while (_file_len > sizeof(BlockDataHeader))
-	{
-		memcpy(&block_data, &_decrypted_data[offset], sizeof(BlockDataHeader));
+	DecryptionResult result = SUCCESS;
+	uint32_t compression = NO_COMPRESSION;
+	if (_header[COMPRESSION_FLAGS].size == sizeof(compression)) {
+		memcpy(&compression, _header[COMPRESSION_FLAGS].data, sizeof(compression));
+	}
 
-		if (block_data.blockDataSize == 0) {
-			break;
+	_index.clear();
+	_store.clear();
+
+	//the xml is parsed while the payload is being decrypted, only
+	//the index of groups and entries is kept, no tree is built
+	if (compression == NO_COMPRESSION) {
+		mxmlSAXLoadStream(NULL,
+						  KeePassStream::read_callback,
+						  &_stream,
+						  DB::XmlIndex::typeCallback,
+						  DB::XmlIndex::saxCallback,
+						  &_index);
+	}
+	else if (compression == GZIP_COMPRESSION) {
+		result = _inflate.init(&_stream);
+		if (result == SUCCESS) {
+			mxmlSAXLoadStream(NULL,
+							  KeePassInflate::read_callback,
+							  &_inflate,
+							  DB::XmlIndex::typeCallback,
+							  DB::XmlIndex::saxCallback,
+							  &_index);
+			result = _inflate.read_to_end();
 		}
+		_inflate.close();
+	}
+	else {
+		result = COMPRESSION_ERROR;
+	}
 
-		KeePassCrypto::evalSHA256(&_decrypted_data[offset + sizeof(BlockDataHeader)], block_data.blockDataSize, hash);
+	//the hash of the tail blocks is checked even if parser stopped earlier
+	if (result == SUCCESS) {
+		result = _stream.read_to_end();
+	}
 
-		if(!memcmp(block_data.blockDataHash, hash, HASH_LENGTH)) {
-			memcpy(&_decrypted_data[data_size], &_decrypted_data[offset + sizeof(BlockDataHeader)], block_data.blockDataSize);
-			offset += sizeof(BlockDataHeader) + block_data.blockDataSize;
-			data_size += block_data.blockDataSize;
-			_file_len = (_file_len - sizeof(BlockDataHeader) - block_data.blockDataSize);
-		}
+	if (result == SUCCESS && _index.isComplete() == false) {
+		result = XML_ERROR;
+	}
 
-		else {
-			return (DATA_HASH_ERROR);
-		}
+	return (result);
+}
+
+InnerRandomStream KeePassReader::_getInnerStream()
+{
+	//databases without the field were always read as Salsa20
+	if (_header[INNER_RANDOM_STREAM_ID].size != sizeof(uint32_t)) {
+		return (SALSA20_STREAM);
 	}
 
-	_decrypted_data[data_size++] = EOF;
-	memset(&_decrypted_data[data_size], 0, (MAX_DATABASE_SIZE_IN_BYTES - data_size));
-	_decrypt_passwords();
-	return (SUCCESS);
+	return (*(InnerRandomStream*)_header[INNER_RANDOM_STREAM_ID].data);
 }
 
-void KeePassReader::_decrypt_passwords()
+void KeePassReader::_initInnerStream()
 {
-	uint32_t decoded_len = 0;
-	uint8_t hash[HASH_LENGTH];
-	uint8_t decrypted_pass[MAX_PASSWORD_SIZE_IN_BYTES] = {0};
+	InnerRandomStream algorithm = _getInnerStream();
+
+	if (algorithm == CHACHA20_STREAM) {
+		//key and nonce are taken from SHA512 of the protected stream key
+		uint8_t hash[HASH_LENGTH * 2];
+		KeePassCrypto::evalSHA512(_header[PROTECTED_STREAM_KEY].data, _header[PROTECTED_STREAM_KEY].size, hash);
+		KeePassCrypto::init_inner_stream(algorithm, &hash[0], &hash[ChaCha20::KEY_SIZE]);
+		KeePassCrypto::wipe(hash, sizeof(hash));
+	}
+	else {
+		uint8_t hash[HASH_LENGTH];
+		KeePassCrypto::evalSHA256(_header[PROTECTED_STREAM_KEY].data, _header[PROTECTED_STREAM_KEY].size, hash);
+		KeePassCrypto::init_inner_stream(algorithm, hash, IV_SALSA);
+		KeePassCrypto::wipe(hash, sizeof(hash));
+	}
+}
 
-	KeePassCrypto::evalSHA256(_header[PROTECTED_STREAM_KEY].data, _header[PROTECTED_STREAM_KEY].size, hash);
-	KeePassCrypto::init_Salsa20(hash, IV_SALSA);
+uint32_t KeePassReader::reveal_protected(const uint8_t *value, uint32_t encoded_len, uint32_t offset,
+										 uint8_t *plain, uint32_t plain_size)
+{
+	uint32_t plain_len = 0;
 
-	if (_tree == nullptr) {
-		_tree = mxmlLoadString(NULL,
-							   (const char*)_decrypted_data,
-							   MXML_OPAQUE_CALLBACK);
+	if (encoded_len == 0) {
+		return (0);
+	}
 
-		mxml_node_t *last_node = _tree;
-		mxml_node_t *curr_node;
+	//the store is left encoded, the value is decrypted into the caller's buffer
+	KeePassCrypto::decode_protected(value, encoded_len, offset, plain, plain_size, &plain_len);
+	return (plain_len);
+}
 
-		while(true)
-		{
-			curr_node = mxmlFindElement(last_node, _tree, "Value", "Protected", "True", MXML_DESCEND);
+bool KeePassReader::reveal_protected_part(const uint8_t *value, uint32_t encoded_len, uint32_t offset,
+										  uint32_t position, uint8_t *plain, uint32_t plain_size,
+										  uint32_t *plain_len)
+{
+	//a value longer than the buffer is revealed by parts
+	return (KeePassCrypto::decode_protected_part(value, encoded_len, offset, position,
+												 plain, plain_size, plain_len));
+}
 
-			if (curr_node == NULL) {
-				break;
-			}
+const DB::EntryStore* KeePassReader::get_store()
+{
+	return (&_store);
+}
 
-			memset(decrypted_pass, 0, MAX_PASSWORD_SIZE_IN_BYTES);
-			uint32_t len = strlen(curr_node->child->value.opaque);
+bool KeePassReader::is_quick_unlock_ready()
+{
+	return (_quick_unlock.is_sealed(FileSystem::get_write_count()));
+}
 
-			Base64::Decode(curr_node->child->value.opaque, len, (char*)decrypted_pass, len, &decoded_len);
-			KeePassCrypto::eval_Salsa20(decrypted_pass, decoded_len);
+bool KeePassReader::is_quick_unlocked()
+{
+	return (_quick_unlocked);
+}
 
-			// curr_node->value.element.attrs[0].value = (char*)"False";
-			std::strcpy(curr_node->child->value.opaque, (char*)decrypted_pass);
+bool KeePassReader::is_quick_unlock_pin_expected()
+{
+	return (_pin_expected);
+}
 
-			last_node = curr_node;
-		}
+bool KeePassReader::set_quick_unlock_pin(const char *pin, uint32_t len)
+{
+	//the transformed key of the last full unlock is still kept
+	if (!_pin_expected || !_quick_unlock.start_pin_key((const uint8_t*)pin, len, _fingerprint)) {
+		return (false);
 	}
+
+	_pin_expected = false;
+	_stage = PIN_SEAL_STAGE;
+	return (true);
+}
+
+void KeePassReader::discard_quick_unlock_pin()
+{
+	_wipeKeys();
 }
 
-mxml_node_t* KeePassReader::get_xml()
+void KeePassReader::forget_quick_unlock()
 {
-	return (_tree);
+	_quick_unlock.wipe();
+}
+
+void KeePassReader::lock()
+{
+	_stage = IDLE_STAGE;
+	_wipeKeys();
+	_quick_unlock.wipe();
+	KeePassCrypto::wipe_AES();
+	_quick_unlocked = false;
+	_store.clear();
+}
+
+void KeePassReader::set_yield_callback(const KeePassStream::YieldCallback &callback)
+{
+	_stream.set_yield_callback(callback);
+}
+
+uint8_t KeePassReader::get_progress()
+{
+	if (_stage == PIN_UNSEAL_STAGE || _stage == PIN_SEAL_STAGE) {
+		return (_quick_unlock.get_progress());
+	}
+
+	if (_stage == PAYLOAD_STAGE) {
+		return (_stream.get_progress());
+	}
+
+	if (_rounds == 0) {
+		return (100);
+	}
+
+	return ((uint8_t)((_rounds_done * 100) / _rounds));
 }
 
 void KeePassReader::set_password(const char* pass, uint32_t len)
@@ -232,7 +427,7 @@ void KeePassReader::set_password(const char* pass, uint32_t len)
 	}
 }
 
-DecryptionResult KeePassReader::decrypt_database(const char* db_name)
+DecryptionResult KeePassReader::_openDatabase(const char* db_name)
 {
 	//TODO: move to another place
 	_credentials = KeePassCredentials::PASSWORD;
@@ -240,6 +435,13 @@ DecryptionResult KeePassReader::decrypt_database(const char* db_name)
 
 	DecryptionResult result;
 
+	//key of the previous unlock isn't waiting for a PIN anymore
+	_wipeKeys();
+	_stage = IDLE_STAGE;
+	_quick_unlocked = false;
+	_rounds = 0;
+	_rounds_done = 0;
+
 	if (FileSystem::open_file_to_read(&_file, db_name) != FR_OK) {
 		return (DB_FILE_ERROR);
 	}
@@ -257,6 +459,25 @@ DecryptionResult KeePassReader::decrypt_database(const char* db_name)
 
 	_readHeader();
 
+	InnerRandomStream inner_stream = _getInnerStream();
+	if (inner_stream != SALSA20_STREAM && inner_stream != CHACHA20_STREAM) {
+		FileSystem::close_file(&_file);
+		return (INNER_STREAM_ERROR);
+	}
+
+	_makeFingerprint();
+	_write_count = FileSystem::get_write_count();
+
+	return (SUCCESS);
+}
+
+DecryptionResult KeePassReader::decrypt_database(const char* db_name)
+{
+	DecryptionResult result = _openDatabase(db_name);
+	if (result != SUCCESS) {
+		return (result);
+	}
+
 	if (_credentials == KeePassCredentials::PASSWORD)
 		_makeMasterKey(_pass, _pass_len);
 
@@ -266,5 +487,78 @@ DecryptionResult KeePassReader::decrypt_database(const char* db_name)
 	if (_credentials == KeePassCredentials::PASSWORD_AND_KEY_FILE)
 		_makeMasterKey(_pass, _keyf, _pass_len, _keyf_len );
 
-	return (_decrypt());
+	KeePassCrypto::wipe(_pass, sizeof(_pass));
+
+	//file stays opened, key transformation is continued
+	//by continue_decryption() calls from the main loop
+	_stage = KEY_TRANSFORM_STAGE;
+	return (IN_PROGRESS);
+}
+
+DecryptionResult KeePassReader::quick_decrypt_database(const char* db_name)
+{
+	DecryptionResult result = _openDatabase(db_name);
+	if (result != SUCCESS) {
+		return (result);
+	}
+
+	//the PIN was chosen for this very file, its key is derived
+	//by continue_decryption() calls as the transformed key is
+	bool is_started = _quick_unlock.is_ready(_fingerprint, _write_count) &&
+					  _quick_unlock.start_pin_key(_pass, _pass_len, _fingerprint);
+	KeePassCrypto::wipe(_pass, sizeof(_pass));
+
+	if (!is_started) {
+		FileSystem::close_file(&_file);
+		return (CREDENTIALS_ERROR);
+	}
+
+	_stage = PIN_UNSEAL_STAGE;
+	return (IN_PROGRESS);
+}
+
+DecryptionResult KeePassReader::continue_decryption()
+{
+	DecryptionResult result;
+
+	switch (_stage) {
+		case KEY_TRANSFORM_STAGE:
+			if (!_transformKey()) {
+				return (IN_PROGRESS);
+			}
+
+			_makeFinalKey(_transformed_key);
+			result = _decrypt();
+
+			//transformed key is kept until the user chooses a PIN
+			//to seal it with or refuses to do it
+			if (result == SUCCESS && _credentials == KeePassCredentials::PASSWORD) {
+				_pin_expected = true;
+			}
+			else {
+				_wipeKeys();
+			}
+		break;
+
+		case PIN_UNSEAL_STAGE:
+			if (!_quick_unlock.derive_pin_key()) {
+				return (IN_PROGRESS);
+			}
+			result = _quickDecrypt();
+		break;
+
+		case PIN_SEAL_STAGE:
+			if (!_quick_unlock.derive_pin_key()) {
+				return (IN_PROGRESS);
+			}
+			result = _sealPin();
+		break;
+
+		default:
+			result = CREDENTIALS_ERROR;
+		break;
+	}
+
+	_stage = IDLE_STAGE;
+	return (result);
 }
@@ -30,6 +30,11 @@
 #include <string.h>
 #include "keepass_crypto.h"
 #include "keepass_reader_defines.h"
+#include "keepass_stream.h"
+#include "keepass_inflate.h"
+#include "keepass_quick_unlock.h"
+#include <database/xmlindex/XmlIndex.h>
+#include <database/entrystore/EntryStore.h>
 extern "C" {
 #include "mxml.h"
 }
@@ -42,7 +47,23 @@ namespace KeepAss
 		KeePassReader();
 		void set_password(const char* pass, uint32_t len);
 		DecryptionResult decrypt_database(const char *db_name);
-		mxml_node_t *get_xml();
+		DecryptionResult quick_decrypt_database(const char *db_name);
+		DecryptionResult continue_decryption();
+		uint8_t get_progress();
+		const DB::EntryStore *get_store();
+		uint32_t reveal_protected(const uint8_t *value, uint32_t encoded_len, uint32_t offset,
+								  uint8_t *plain, uint32_t plain_size);
+		bool reveal_protected_part(const uint8_t *value, uint32_t encoded_len, uint32_t offset,
+								   uint32_t position, uint8_t *plain, uint32_t plain_size,
+								   uint32_t *plain_len);
+		bool is_quick_unlock_ready();
+		bool is_quick_unlocked();
+		bool is_quick_unlock_pin_expected();
+		bool set_quick_unlock_pin(const char *pin, uint32_t len);
+		void discard_quick_unlock_pin();
+		void forget_quick_unlock();
+		void lock();
+		void set_yield_callback(const KeePassStream::YieldCallback &callback);
 
 	private:
 		static constexpr uint8_t IV_SALSA[8] = {0xE8, 0x30, 0x09, 0x4B, 0x97, 0x20, 0x5D, 0x2A};
@@ -56,19 +77,37 @@ namespace KeepAss
 		uint8_t _keyf[MAX_KEYFILE_SIZE_IN_BYTES];
 		uint32_t _keyf_len;
 		uint8_t _master_key[HASH_LENGTH];
+		uint8_t _transformed_key[HASH_LENGTH];
+		uint8_t _fingerprint[HASH_LENGTH];
+		uint64_t _rounds;
+		uint64_t _rounds_done;
+		uint32_t _write_count;
+		DecryptionStage _stage;
+		KeePassQuickUnlock _quick_unlock;
+		bool _quick_unlocked;
+		bool _pin_expected;
 		KeePassCredentials _credentials;
-		uint8_t _decrypted_data[MAX_DATABASE_SIZE_IN_BYTES];
-		uint32_t _file_len;
-		mxml_node_t *_tree;
+		KeePassStream _stream;
+		KeePassInflate _inflate;
+		DB::XmlIndex _index;
+		DB::EntryStore _store;
 
+		DecryptionResult _openDatabase(const char *db_name);
 		DecryptionResult _checkKeePassVersion();
 		void _readHeader();
 		void _makeMasterKey(uint8_t *key, uint32_t key_len);
 		void _makeMasterKey(uint8_t *pass, uint8_t *keyfile, uint32_t pass_len, uint32_t keylile_len);
 		void _makeKeyRoutine(uint8_t *key_hash);
+		bool _transformKey();
+		void _makeFinalKey(const uint8_t *transformed_key);
+		void _makeFingerprint();
+		DecryptionResult _quickDecrypt();
+		DecryptionResult _sealPin();
+		void _wipeKeys();
 		DecryptionResult _decrypt();
-		DecryptionResult _process_blocks();
-		void _decrypt_passwords();
+		DecryptionResult _loadXml();
+		InnerRandomStream _getInnerStream();
+		void _initInnerStream();
 
 	};
 }
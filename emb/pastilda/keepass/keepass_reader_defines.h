@@ -36,8 +36,16 @@ namespace KeepAss
 	constexpr uint32_t HASH_LENGTH 							= 32;
 	constexpr uint32_t COMPOSITE_KEY_LENGTH 				= 64;
 	constexpr uint32_t MASTER_KEY_LENGTH_2X                 = 64;
-	constexpr uint32_t MAX_DATABASE_SIZE_IN_BYTES 			= 30000;
+	constexpr uint32_t AES_BLOCK_SIZE_IN_BYTES				= 16;
+	constexpr uint32_t STREAM_CHUNK_SIZE_IN_BYTES			= 512;
+	constexpr uint32_t QUICK_UNLOCK_MIN_PIN_LENGTH			= 4;
+	constexpr uint32_t QUICK_UNLOCK_MAX_PIN_LENGTH			= 16;
+	constexpr uint32_t QUICK_UNLOCK_MAX_ATTEMPTS			= 3;
+	constexpr uint32_t QUICK_UNLOCK_PIN_ROUNDS				= 20000;
+	constexpr uint32_t DEVICE_ID_SIZE_IN_BYTES				= 12;
 	constexpr uint32_t MAX_HEADER_FIELD_SIZE                = 32;
+	constexpr uint32_t KDF_ROUNDS_PER_BATCH					= 256;
+	constexpr uint32_t KDF_SLICE_TIME_MS					= 4;
 
 	#pragma pack(push, 1)
 	typedef struct
@@ -71,6 +79,20 @@ namespace KeepAss
 		HEADER_FIELD_COUNT = 11
 	} HeaderFieldName;
 
+	typedef enum : uint32_t
+	{
+		NO_COMPRESSION = 0,
+		GZIP_COMPRESSION = 1
+	} CompressionAlgorithm;
+
+	typedef enum : uint32_t
+	{
+		NO_INNER_STREAM = 0,
+		ARC_FOUR_STREAM = 1,
+		SALSA20_STREAM = 2,
+		CHACHA20_STREAM = 3
+	} InnerRandomStream;
+
 	typedef enum
 	{
 		NOT_SELECTED,
@@ -79,6 +101,15 @@ namespace KeepAss
 		PASSWORD_AND_KEY_FILE
 	} KeePassCredentials;
 
+	typedef enum
+	{
+		IDLE_STAGE,
+		KEY_TRANSFORM_STAGE,
+		PIN_UNSEAL_STAGE,
+		PIN_SEAL_STAGE,
+		PAYLOAD_STAGE
+	} DecryptionStage;
+
 	typedef enum
 	{
 		SUCCESS,
@@ -87,6 +118,10 @@ namespace KeepAss
 		CREDENTIALS_ERROR,
 		DB_FILE_ERROR,
 		DATA_HASH_ERROR,
+		XML_ERROR,
+		COMPRESSION_ERROR,
+		INNER_STREAM_ERROR,
+		IN_PROGRESS,
 	} DecryptionResult;
 }
 #endif
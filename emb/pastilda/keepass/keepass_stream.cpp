@@ -0,0 +1,251 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <keepass_stream.h>
+#include "systick_ext.h"
+
+using namespace KeepAss;
+
+KeePassStream::KeePassStream()
+{
+	_file = nullptr;
+	_chunk_pos = 0;
+	_chunk_len = 0;
+	_cipher_left = 0;
+	_cipher_len = 0;
+	_yield_ms = 0;
+	_block_left = 0;
+	_result = DecryptionResult::SUCCESS;
+	_finished = true;
+}
+
+DecryptionResult KeePassStream::open(FIL *file, const uint8_t *key, const uint8_t *iv,
+									 const uint8_t *start_bytes, uint32_t start_bytes_len)
+{
+	uint8_t stream_start[MAX_HEADER_FIELD_SIZE];
+
+	_file = file;
+	memcpy(_key, key, HASH_LENGTH);
+	memcpy(_iv, iv, AES_BLOCK_SIZE_IN_BYTES);
+
+	_chunk_pos = 0;
+	_chunk_len = 0;
+	_cipher_left = _file->fsize - FileSystem::get_file_tell(_file);
+	_cipher_len = _cipher_left;
+	_yield_ms = get_counter_ms();
+	_block_left = 0;
+	_result = SUCCESS;
+	_finished = false;
+
+	//first decrypted bytes must be equal to the stream start bytes
+	//from the header, otherwise the master key is wrong
+	if (start_bytes_len > MAX_HEADER_FIELD_SIZE ||
+		_take(stream_start, start_bytes_len) != start_bytes_len ||
+		memcmp(start_bytes, stream_start, start_bytes_len))
+	{
+		_result = MASTER_KEY_ERROR;
+	}
+
+	return (_result);
+}
+
+int32_t KeePassStream::read(uint8_t *buffer, uint32_t size)
+{
+	uint32_t done = 0;
+
+	while ((done < size) && (_result == SUCCESS) && !_finished)
+	{
+		if (_block_left == 0) {
+			if (!_nextBlock()) {
+				break;
+			}
+			continue;
+		}
+
+		uint32_t len = (size - done) < _block_left ? (size - done) : _block_left;
+		if (_take(&buffer[done], len) != len) {
+			_result = DB_FILE_ERROR;
+			break;
+		}
+
+		cf_sha256_update(&_hash_ctx, &buffer[done], len);
+		_block_left -= len;
+		done += len;
+
+		if (_block_left == 0) {
+			_checkBlockHash();
+		}
+	}
+
+	if (_result != SUCCESS) {
+		return (-1);
+	}
+
+	return (done);
+}
+
+DecryptionResult KeePassStream::read_to_end()
+{
+	uint8_t buffer[AES_BLOCK_SIZE_IN_BYTES * 4];
+
+	while (read(buffer, sizeof(buffer)) > 0);
+	memset(buffer, 0, sizeof(buffer));
+
+	return (_result);
+}
+
+void KeePassStream::close()
+{
+	memset(_key, 0, sizeof(_key));
+	memset(_iv, 0, sizeof(_iv));
+	memset(_chunk, 0, sizeof(_chunk));
+	memset(&_hash_ctx, 0, sizeof(_hash_ctx));
+	KeePassCrypto::wipe_AES();  //key schedule of the final key
+	_file = nullptr;
+	_finished = true;
+}
+
+uint8_t KeePassStream::get_progress()
+{
+	if (_cipher_len == 0) {
+		return (100);
+	}
+
+	return ((uint8_t)(((uint64_t)(_cipher_len - _cipher_left) * 100) / _cipher_len));
+}
+
+int KeePassStream::read_callback(void *stream, unsigned char *buffer, int size)
+{
+	return (static_cast<KeePassStream*>(stream)->read(buffer, size));
+}
+
+bool KeePassStream::_fillChunk()
+{
+	uint8_t next_iv[AES_BLOCK_SIZE_IN_BYTES];
+	uint32_t len = _cipher_left;
+
+	if (len == 0) {
+		return (false);
+	}
+
+	if (len > STREAM_CHUNK_SIZE_IN_BYTES) {
+		len = STREAM_CHUNK_SIZE_IN_BYTES;
+	}
+
+	if (_yield && (get_counter_ms() - _yield_ms) >= KDF_SLICE_TIME_MS) {
+		_yield();
+		_yield_ms = get_counter_ms();
+	}
+
+	if ((len % AES_BLOCK_SIZE_IN_BYTES) != 0 ||
+		FileSystem::read_next_file_chunk(_file, _chunk, len) != FR_OK)
+	{
+		_result = DB_FILE_ERROR;
+		return (false);
+	}
+
+	//the last cipher block of this chunk is the IV for the next one
+	memcpy(next_iv, &_chunk[len - AES_BLOCK_SIZE_IN_BYTES], AES_BLOCK_SIZE_IN_BYTES);
+	KeePassCrypto::decrypt_AES_CBC(_key, _iv, _chunk, len);
+	memcpy(_iv, next_iv, AES_BLOCK_SIZE_IN_BYTES);
+
+	_cipher_left -= len;
+
+	//strip PKCS#7 padding at the end of the payload
+	if (_cipher_left == 0) {
+		uint8_t padding = _chunk[len - 1];
+		if (padding == 0 || padding > AES_BLOCK_SIZE_IN_BYTES) {
+			_result = MASTER_KEY_ERROR;
+			return (false);
+		}
+		len -= padding;
+	}
+
+	_chunk_pos = 0;
+	_chunk_len = len;
+	return (true);
+}
+
+uint32_t KeePassStream::_take(uint8_t *data, uint32_t size)
+{
+	uint32_t done = 0;
+
+	while (done < size)
+	{
+		if (_chunk_pos >= _chunk_len) {
+			if (!_fillChunk()) {
+				break;
+			}
+		}
+
+		uint32_t len = _chunk_len - _chunk_pos;
+		if (len > (size - done)) {
+			len = size - done;
+		}
+
+		memcpy(&data[done], &_chunk[_chunk_pos], len);
+		_chunk_pos += len;
+		done += len;
+	}
+
+	return (done);
+}
+
+bool KeePassStream::_nextBlock()
+{
+	//data organized as follows:
+	//4 bytes = block id
+	//32 bytes = hash of block data
+	//4 bytes = size of block data
+	//[size of block data] bytes
+	if (_take((uint8_t*)&_block, sizeof(BlockDataHeader)) != sizeof(BlockDataHeader)) {
+		if (_result == SUCCESS) {
+			_result = DB_FILE_ERROR;
+		}
+		return (false);
+	}
+
+	//the block of zero size marks the end of the stream
+	if (_block.blockDataSize == 0) {
+		_finished = true;
+		return (false);
+	}
+
+	cf_sha256_init(&_hash_ctx);
+	_block_left = _block.blockDataSize;
+	return (true);
+}
+
+bool KeePassStream::_checkBlockHash()
+{
+	uint8_t hash[HASH_LENGTH];
+	cf_sha256_digest_final(&_hash_ctx, hash);
+
+	if (memcmp(_block.blockDataHash, hash, HASH_LENGTH)) {
+		_result = DATA_HASH_ERROR;
+		return (false);
+	}
+
+	return (true);
+}
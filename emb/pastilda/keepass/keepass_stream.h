@@ -0,0 +1,100 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef KEEPASS_STREAM_H
+#define KEEPASS_STREAM_H
+
+#include <fs/file_system.h>
+#include <stdint.h>
+#include <string.h>
+#include <FastDelegate.h>
+#include "keepass_crypto.h"
+#include "keepass_reader_defines.h"
+
+namespace KeepAss
+{
+	// Streaming decryption of the KeePass 2.x payload.
+	//
+	// The encrypted payload is read from the file by chunks of
+	// STREAM_CHUNK_SIZE_IN_BYTES, decrypted with AES-CBC (IV is carried from
+	// one chunk to the next) and split into hashed blocks. Only the data of
+	// the blocks is returned by read(), every block is hashed on the fly and
+	// checked as soon as its last byte is read. So the size of a database is
+	// not limited by RAM, only the chunk buffer is kept in memory.
+	//
+	// The parser pulls the whole payload at once, so the yield callback is
+	// called between chunks every KDF_SLICE_TIME_MS to keep USB alive.
+	class KeePassStream
+	{
+	public:
+		typedef fastdelegate::FastDelegate0<> YieldCallback;
+
+		KeePassStream();
+		DecryptionResult open(FIL *file, const uint8_t *key, const uint8_t *iv,
+							  const uint8_t *start_bytes, uint32_t start_bytes_len);
+		int32_t read(uint8_t *buffer, uint32_t size);
+		DecryptionResult read_to_end();
+		void close();
+
+		DecryptionResult get_result() {
+			return (_result);
+		}
+
+		bool is_finished() {
+			return (_finished);
+		}
+
+		void set_yield_callback(const YieldCallback &callback) {
+			_yield = callback;
+		}
+
+		uint8_t get_progress();
+
+		// Adapter for mxmlLoadStream()
+		static int read_callback(void *stream, unsigned char *buffer, int size);
+
+	private:
+		FIL *_file;
+		uint8_t _key[HASH_LENGTH];
+		uint8_t _iv[AES_BLOCK_SIZE_IN_BYTES];
+		uint8_t _chunk[STREAM_CHUNK_SIZE_IN_BYTES];
+		uint32_t _chunk_pos;
+		uint32_t _chunk_len;
+		uint32_t _cipher_left;
+		uint32_t _cipher_len;
+		YieldCallback _yield;
+		uint32_t _yield_ms;
+		BlockDataHeader _block;
+		uint32_t _block_left;
+		cf_sha256_context _hash_ctx;
+		DecryptionResult _result;
+		bool _finished;
+
+		bool _fillChunk();
+		uint32_t _take(uint8_t *data, uint32_t size);
+		bool _nextBlock();
+		bool _checkBlockHash();
+	};
+}
+#endif
@@ -351,7 +351,7 @@ static AsciiCode asciiShiftedBack[128 - SHIFT_FOR_SHIFTED_BACK_ASCII_CODES] = {
 	AsciiCode::NUL,
 	AsciiCode::NUL,      		 // LOWERCASE_Z
 	AsciiCode::OPENING_BRACKET,	 // OPENING_BRACE
-	AsciiCode::SLASH_OR_DIVIDE,  // VERTICAL_BAR
+	AsciiCode::BACKSLASH,        // VERTICAL_BAR
 	AsciiCode::CLOSING_BRACKET,  // CLOSING_BRACE
 	AsciiCode::GRAVE_ACCENT,     // TILDE_OR_EQUIVALENCY_SIGN
 	AsciiCode::NUL				 // DELETE
@@ -514,6 +514,11 @@ AsciiCode getAsciiBackShifted(AsciiCode code)
 
 bool isAsciiShifted(AsciiCode code)
 {
+	// Codes below the table (space and control ones) are never shifted
+	if (static_cast<AsciiCodeType>(code) < SHIFT_FOR_SHIFTED_BACK_ASCII_CODES ||
+		static_cast<AsciiCodeType>(code) >= 128) {
+		return false;
+	}
 	return (getAsciiBackShifted(code) != AsciiCode::NUL);
 }
 
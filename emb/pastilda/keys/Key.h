@@ -58,6 +58,8 @@ public:
 	Key(AsciiCode code);
 	~Key();
 
+	Key(const Key& key) = default;
+
 	void set(UsbKeyCodeType key, UsbKeyCodeType modifier);
 	void set(UsbKey key, UsbSpecialKeySequence modifier);
 	void set(UsbKey key, UsbSpecialKey modifier);
@@ -46,6 +46,21 @@ void LEDS_api::toggle()
 	}
 }
 
+void LEDS_api::show_progress(uint8_t percent)
+{
+	//progress bar grows from one led to all of them
+	uint8_t count = 1 + ((percent * (LEDS_COUNT - 1)) / LEDS_PROGRESS_MAX);
+
+	for(int i = 0; i < LEDS_COUNT; i++) {
+		if (i < count) {
+			_leds[i].clear();
+		}
+		else {
+			_leds[i].set();
+		}
+	}
+}
+
 void LEDS_api::leds_toggle()
 {
 	uint8_t mask = LEDS_INI_STATE;
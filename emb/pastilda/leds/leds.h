@@ -39,12 +39,14 @@ namespace LEDS_API
 	constexpr uint8_t LEDS_MAX_STATE             = 0x07;
 	constexpr uint8_t LEDS_INI_STATE     		 = 0x01;
 	constexpr uint32_t LEDS_TOGGLE_PERIOD_MS     = 1000;
+	constexpr uint8_t LEDS_PROGRESS_MAX          = 100;
 
 	class LEDS_api
 	{
 	public:
 		LEDS_api();
 		void toggle();
+		void show_progress(uint8_t percent);
 
 	private:
 		TimerMs _timer_leds_toggle;
@@ -0,0 +1,119 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CHACHA20_H
+#define CHACHA20_H
+
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+using std::size_t;
+using std::int32_t;
+using std::uint8_t;
+using std::uint32_t;
+
+/**
+ * Represents ChaCha20 cypher (RFC 7539: 32-bit block counter, 96-bit nonce).
+ * Supports only 256-bit keys.
+ */
+class ChaCha20
+{
+public:
+	/// Helper constants
+	enum: size_t
+	{
+			VECTOR_SIZE = 16,
+			BLOCK_SIZE = 64,
+			KEY_SIZE = 32,
+			IV_SIZE = 12
+	};
+
+	/**
+	 * \brief Constructs cypher with given key.
+	 * \param[in] key 256-bit key
+	 */
+	inline ChaCha20(const uint8_t* key = nullptr);
+	ChaCha20(const ChaCha20&) = default;
+	ChaCha20(ChaCha20&&) = default;
+	~ChaCha20() = default;
+	ChaCha20& operator =(const ChaCha20&) = default;
+	ChaCha20& operator =(ChaCha20&&) = default;
+
+	/**
+	 * \brief Sets key.
+	 * \param[in] key 256-bit key
+	 */
+	inline void setKey(const uint8_t* key);
+
+	/**
+	 * \brief Sets IV (nonce) and resets block counter.
+	 * \param[in] iv 96-bit IV
+	 */
+	inline void setIv(const uint8_t* iv);
+
+	/**
+	 * \brief Sets block counter (position in the key stream).
+	 * \param[in] counter index of the next key stream block
+	 */
+	inline void setCounter(uint32_t counter);
+
+	/**
+	 * \brief Generates key stream.
+	 * \param[out] output generated key stream
+	 */
+	inline void generateKeyStream(uint8_t output[BLOCK_SIZE]);
+
+private:
+	/**
+	 * \brief Rotates value.
+	 * \param[in] value value
+	 * \param[in] numBits number of bits to rotate
+	 * \return result of the rotation
+	 */
+	inline uint32_t rotate(uint32_t value, uint32_t numBits);
+
+	/**
+	 * \brief Converts 32-bit unsigned integer value to the array of bytes.
+	 * \param[in] value 32-bit unsigned integer value
+	 * \param[out] array array of bytes
+	 */
+	inline void convert(uint32_t value, uint8_t* array);
+
+	/**
+	 * \brief Converts array of bytes to the 32-bit unsigned integer value.
+	 * \param[in] array array of bytes
+	 * \return 32-bit unsigned integer value
+	 */
+	inline uint32_t convert(const uint8_t* array);
+
+	// Data members
+	uint32_t vector_[VECTOR_SIZE];
+
+};
+
+#include <chacha20.inl>
+#endif
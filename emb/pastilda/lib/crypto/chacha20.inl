@@ -0,0 +1,126 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "chacha20.h"
+
+#define CHACHA20_QUARTER_ROUND(a, b, c, d)                     \
+		x[a] += x[b]; x[d] = rotate(x[d] ^ x[a], 16);          \
+		x[c] += x[d]; x[b] = rotate(x[b] ^ x[c], 12);          \
+		x[a] += x[b]; x[d] = rotate(x[d] ^ x[a],  8);          \
+		x[c] += x[d]; x[b] = rotate(x[b] ^ x[c],  7)
+
+ChaCha20::ChaCha20(const uint8_t* key)
+{
+		std::memset(vector_, 0, sizeof(vector_));
+		setKey(key);
+}
+
+//----------------------------------------------------------------------------------
+void ChaCha20::setKey(const uint8_t* key)
+{
+		static const char constants[] = "expand 32-byte k";
+
+		if(key == nullptr)
+				return;
+
+		for(size_t i = 0; i < 4; ++i)
+				vector_[i] = convert(reinterpret_cast<const uint8_t*>(&constants[4 * i]));
+
+		for(size_t i = 0; i < 8; ++i)
+				vector_[4 + i] = convert(&key[4 * i]);
+}
+
+//----------------------------------------------------------------------------------
+void ChaCha20::setIv(const uint8_t* iv)
+{
+		if(iv == nullptr)
+				return;
+
+		vector_[12] = 0;
+		vector_[13] = convert(&iv[0]);
+		vector_[14] = convert(&iv[4]);
+		vector_[15] = convert(&iv[8]);
+}
+
+//----------------------------------------------------------------------------------
+void ChaCha20::setCounter(uint32_t counter)
+{
+		vector_[12] = counter;
+}
+
+//----------------------------------------------------------------------------------
+void ChaCha20::generateKeyStream(uint8_t output[BLOCK_SIZE])
+{
+		uint32_t x[VECTOR_SIZE];
+		std::memcpy(x, vector_, sizeof(vector_));
+
+		for(int32_t i = 20; i > 0; i -= 2)
+		{
+				// column rounds
+				CHACHA20_QUARTER_ROUND(0, 4,  8, 12);
+				CHACHA20_QUARTER_ROUND(1, 5,  9, 13);
+				CHACHA20_QUARTER_ROUND(2, 6, 10, 14);
+				CHACHA20_QUARTER_ROUND(3, 7, 11, 15);
+				// diagonal rounds
+				CHACHA20_QUARTER_ROUND(0, 5, 10, 15);
+				CHACHA20_QUARTER_ROUND(1, 6, 11, 12);
+				CHACHA20_QUARTER_ROUND(2, 7,  8, 13);
+				CHACHA20_QUARTER_ROUND(3, 4,  9, 14);
+		}
+
+		for(size_t i = 0; i < VECTOR_SIZE; ++i)
+		{
+				x[i] += vector_[i];
+				convert(x[i], &output[4 * i]);
+		}
+
+		++vector_[12];
+}
+
+//----------------------------------------------------------------------------------
+uint32_t ChaCha20::rotate(uint32_t value, uint32_t numBits)
+{
+		return (value << numBits) | (value >> (32 - numBits));
+}
+
+//----------------------------------------------------------------------------------
+void ChaCha20::convert(uint32_t value, uint8_t* array)
+{
+		array[0] = static_cast<uint8_t>(value >> 0);
+		array[1] = static_cast<uint8_t>(value >> 8);
+		array[2] = static_cast<uint8_t>(value >> 16);
+		array[3] = static_cast<uint8_t>(value >> 24);
+}
+
+//----------------------------------------------------------------------------------
+uint32_t ChaCha20::convert(const uint8_t* array)
+{
+		return ((static_cast<uint32_t>(array[0]) << 0)  |
+				(static_cast<uint32_t>(array[1]) << 8)  |
+				(static_cast<uint32_t>(array[2]) << 16) |
+				(static_cast<uint32_t>(array[3]) << 24));
+}
+
+#undef CHACHA20_QUARTER_ROUND
@@ -52,6 +52,12 @@ public:
 	 */
 	inline void setIv(const uint8_t* iv);
 
+	/**
+	 * \brief Sets block counter (position in the key stream).
+	 * \param[in] counter index of the next key stream block
+	 */
+	inline void setCounter(uint64_t counter);
+
 	/**
 	 * \brief Generates key stream.
 	 * \param[out] output generated key stream
@@ -1,7 +1,7 @@
 // Copyright (c) 2015 Nezametdinov E. Ildus
 // See LICENSE.TXT for licensing details
 
-#include "Salsa20.h"
+#include "salsa20.h"
 
 Salsa20::Salsa20(const uint8_t* key)
 {
@@ -45,6 +45,13 @@ void Salsa20::setIv(const uint8_t* iv)
 		vector_[8] = vector_[9] = 0;
 }
 
+//----------------------------------------------------------------------------------
+void Salsa20::setCounter(uint64_t counter)
+{
+		vector_[8] = static_cast<uint32_t>(counter);
+		vector_[9] = static_cast<uint32_t>(counter >> 32);
+}
+
 //----------------------------------------------------------------------------------
 void Salsa20::generateKeyStream(uint8_t output[BLOCK_SIZE])
 {
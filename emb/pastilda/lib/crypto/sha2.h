@@ -75,6 +75,12 @@ extern void cf_sha256_init(cf_sha256_context *ctx);
  */
 extern void cf_sha256_update(cf_sha256_context *ctx, const void *data, size_t nbytes);
 
+/* .. c:function:: $DECL
+ * Hashes `nblocks` whole blocks at `data` without copying them.
+ * There must be no partially buffered input in `ctx`.
+ */
+extern void cf_sha256_update_blocks(cf_sha256_context *ctx, const void *data, size_t nblocks);
+
 /* .. c:function:: $DECL
  * Finishes the hash operation, writing `CF_SHA256_HASHSZ` bytes to `hash`.
  *
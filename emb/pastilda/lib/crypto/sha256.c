@@ -71,72 +71,191 @@ void cf_sha224_init(cf_sha256_context *ctx)
   ctx->H[7] = 0xbefa4fa4;
 }
 
-static void sha256_update_block(void *vctx, const uint8_t *inp)
+#if defined(__SHA__) && defined(__SSE4_1__)
+
+/* x86 hosts built with SHA extensions (-msha -msse4.1) use the SHA-NI
+ * instructions.  The state is kept as ABEF/CDGH pairs, as those
+ * instructions expect. */
+#include <immintrin.h>
+
+static void sha256_compress_blocks(uint32_t H[8], const uint8_t *inp, size_t nblocks)
 {
-  cf_sha256_context *ctx = vctx;
+  const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i state0, state1, msg, tmp, abef, cdgh;
+  __m128i M[4];
+
+  tmp = _mm_loadu_si128((const __m128i *) &H[0]);
+  state1 = _mm_loadu_si128((const __m128i *) &H[4]);
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);            /* CDAB */
+  state1 = _mm_shuffle_epi32(state1, 0x1B);      /* EFGH */
+  state0 = _mm_alignr_epi8(tmp, state1, 8);      /* ABEF */
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);   /* CDGH */
+
+  while (nblocks--)
+  {
+    abef = state0;
+    cdgh = state1;
+
+    for (size_t i = 0; i < 16; i++)
+    {
+      if (i < 4)
+      {
+        M[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (inp + 16 * i)), MASK);
+      } else {
+        /* W[t..t+3] from W[t-16..t-13], W[t-12], W[t-7..t-4] and W[t-4..t-1]. */
+        tmp = _mm_sha256msg1_epu32(M[i % 4], M[(i + 1) % 4]);
+        tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(M[(i + 3) % 4], M[(i + 2) % 4], 4));
+        M[i % 4] = _mm_sha256msg2_epu32(tmp, M[(i + 3) % 4]);
+      }
+
+      msg = _mm_add_epi32(M[i % 4], _mm_loadu_si128((const __m128i *) &K[4 * i]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      msg = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+    inp += CF_SHA256_BLOCKSZ;
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);         /* FEBA */
+  state1 = _mm_shuffle_epi32(state1, 0xB1);      /* DCHG */
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);   /* DCBA */
+  state1 = _mm_alignr_epi8(state1, tmp, 8);      /* HGFE */
+
+  _mm_storeu_si128((__m128i *) &H[0], state0);
+  _mm_storeu_si128((__m128i *) &H[4], state1);
+}
+
+#else
+
+/* Word loads: a single byte-reversing load on little endian targets
+ * (REV on Cortex-M4, which also allows unaligned LDR). */
+static inline uint32_t load32_be(const uint8_t *inp)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  uint32_t w;
+  memcpy(&w, inp, sizeof w);
+  return __builtin_bswap32(w);
+#else
+  return read32_be(inp);
+#endif
+}
+
+/* One round with the working variables renamed instead of shifted:
+ * only d and h are written. */
+# define ROUND(a, b, c, d, e, f, g, h, t, Wt)                  \
+  do {                                                        \
+    uint32_t T1 = (h) + BSIG1(e) + CH(e, f, g) + K[t] + (Wt); \
+    (d) += T1;                                                \
+    (h) = T1 + BSIG0(a) + MAJ(a, b, c);                       \
+  } while (0)
 
-  /* This is a 16-word window into the whole W array. */
+/* W[0..16] come from the input, the rest is expanded in a 16-word
+ * window: W[t % 16] still holds W[t - 16] when it is replaced. */
+# define WIN(t) (W[t])
+# define WEXP(t) (W[(t) & 15] += SSIG1(W[((t) - 2) & 15]) + W[((t) - 7) & 15] + SSIG0(W[((t) - 15) & 15]))
+
+# define ROUNDS8(t, WX)                            \
+  do {                                            \
+    ROUND(a, b, c, d, e, f, g, h, (t) + 0, WX((t) + 0)); \
+    ROUND(h, a, b, c, d, e, f, g, (t) + 1, WX((t) + 1)); \
+    ROUND(g, h, a, b, c, d, e, f, (t) + 2, WX((t) + 2)); \
+    ROUND(f, g, h, a, b, c, d, e, (t) + 3, WX((t) + 3)); \
+    ROUND(e, f, g, h, a, b, c, d, (t) + 4, WX((t) + 4)); \
+    ROUND(d, e, f, g, h, a, b, c, (t) + 5, WX((t) + 5)); \
+    ROUND(c, d, e, f, g, h, a, b, (t) + 6, WX((t) + 6)); \
+    ROUND(b, c, d, e, f, g, h, a, (t) + 7, WX((t) + 7)); \
+  } while (0)
+
+static void sha256_compress_blocks(uint32_t H[8], const uint8_t *inp, size_t nblocks)
+{
   uint32_t W[16];
 
-  uint32_t a = ctx->H[0],
-           b = ctx->H[1],
-           c = ctx->H[2],
-           d = ctx->H[3],
-           e = ctx->H[4],
-           f = ctx->H[5],
-           g = ctx->H[6],
-           h = ctx->H[7],
-           Wt;
-
-  for (size_t t = 0; t < 64; t++)
+  while (nblocks--)
   {
-    /* For W[0..16] we process the input into W.
-     * For W[16..64] we compute the next W value:
-     *
-     * W[t] = SSIG1(W[t - 2]) + W[t - 7] + SSIG0(W[t - 15]) + W[t - 16];
-     *
-     * But all W indices are reduced mod 16 into our window.
-     */
-    if (t < 16)
+    uint32_t a = H[0],
+             b = H[1],
+             c = H[2],
+             d = H[3],
+             e = H[4],
+             f = H[5],
+             g = H[6],
+             h = H[7];
+
+    for (size_t t = 0; t < 16; t++)
+      W[t] = load32_be(inp + 4 * t);
+
+    ROUNDS8(0, WIN);
+    ROUNDS8(8, WIN);
+
+    for (size_t t = 16; t < 64; t += 16)
     {
-      W[t] = Wt = read32_be(inp);
-      inp += 4;
-    } else {
-      Wt = SSIG1(W[(t - 2) % 16]) +
-           W[(t - 7) % 16] +
-           SSIG0(W[(t - 15) % 16]) +
-           W[(t - 16) % 16];
-      W[t % 16] = Wt;
+      ROUNDS8(t, WEXP);
+      ROUNDS8(t + 8, WEXP);
     }
 
-    uint32_t T1 = h + BSIG1(e) + CH(e, f, g) + K[t] + Wt;
-    uint32_t T2 = BSIG0(a) + MAJ(a, b, c);
-    h = g;
-    g = f;
-    f = e;
-    e = d + T1;
-    d = c;
-    c = b;
-    b = a;
-    a = T1 + T2;
+    H[0] += a;
+    H[1] += b;
+    H[2] += c;
+    H[3] += d;
+    H[4] += e;
+    H[5] += f;
+    H[6] += g;
+    H[7] += h;
+
+    inp += CF_SHA256_BLOCKSZ;
   }
+}
+
+#endif
 
-  ctx->H[0] += a;
-  ctx->H[1] += b;
-  ctx->H[2] += c;
-  ctx->H[3] += d;
-  ctx->H[4] += e;
-  ctx->H[5] += f;
-  ctx->H[6] += g;
-  ctx->H[7] += h;
+static void sha256_update_block(void *vctx, const uint8_t *inp)
+{
+  cf_sha256_context *ctx = vctx;
 
+  sha256_compress_blocks(ctx->H, inp, 1);
   ctx->blocks++;
 }
 
+void cf_sha256_update_blocks(cf_sha256_context *ctx, const void *data, size_t nblocks)
+{
+  assert(ctx->npartial == 0);
+
+  sha256_compress_blocks(ctx->H, data, nblocks);
+  ctx->blocks += nblocks;
+}
+
 void cf_sha256_update(cf_sha256_context *ctx, const void *data, size_t nbytes)
 {
+  const uint8_t *bufin = data;
+
+  /* Top up a pending partial block first. */
+  if (ctx->npartial)
+  {
+    size_t taken = MIN(sizeof ctx->partial - ctx->npartial, nbytes);
+
+    cf_blockwise_accumulate(ctx->partial, &ctx->npartial, sizeof ctx->partial,
+                            bufin, taken,
+                            sha256_update_block, ctx);
+    bufin += taken;
+    nbytes -= taken;
+  }
+
+  /* Whole blocks are compressed straight from the caller's buffer. */
+  if (nbytes >= CF_SHA256_BLOCKSZ)
+  {
+    size_t nblocks = nbytes / CF_SHA256_BLOCKSZ;
+
+    cf_sha256_update_blocks(ctx, bufin, nblocks);
+    bufin += nblocks * CF_SHA256_BLOCKSZ;
+    nbytes -= nblocks * CF_SHA256_BLOCKSZ;
+  }
+
+  /* Buffer the tail. */
   cf_blockwise_accumulate(ctx->partial, &ctx->npartial, sizeof ctx->partial,
-                          data, nbytes,
+                          bufin, nbytes,
                           sha256_update_block, ctx);
 }
 
@@ -32,6 +32,14 @@
 #define MXML_VERSION	""
 
 
+/*
+ * File descriptor/stream buffer size (the default 8k is too much
+ * for the device stack)...
+ */
+
+#define MXML_FDBUF_SIZE	1024
+
+
 /*
  * Inline function support...
  */
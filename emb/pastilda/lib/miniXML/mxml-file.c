@@ -47,12 +47,18 @@
 typedef int (*_mxml_getc_cb_t)(void *, int *);
 typedef int (*_mxml_putc_cb_t)(int, void *);
 
+#ifndef MXML_FDBUF_SIZE
+#  define MXML_FDBUF_SIZE	8192	/* Size of file descriptor buffer */
+#endif /* !MXML_FDBUF_SIZE */
+
 typedef struct _mxml_fdbuf_s		/**** File descriptor buffer ****/
 {
   int		fd;			/* File descriptor */
+  mxml_read_cb_t read_cb;		/* Read callback or NULL for fd */
+  void		*read_data;		/* Read callback data */
   unsigned char	*current,		/* Current position in buffer */
 		*end,			/* End of buffer */
-		buffer[8192];		/* Character buffer */
+		buffer[MXML_FDBUF_SIZE];/* Character buffer */
 } _mxml_fdbuf_t;
 
 
@@ -126,6 +132,7 @@ mxmlLoadFd(mxml_node_t    *top,		/* I - Top node */
   */
 
   buf.fd      = fd;
+  buf.read_cb = NULL;
   buf.current = buf.buffer;
   buf.end     = buf.buffer;
 
@@ -194,6 +201,34 @@ mxmlLoadString(mxml_node_t    *top,	/* I - Top node */
 }
 
 
+/*
+ * 'mxmlLoadStream()' - Load a data stream into an XML node tree.
+ *
+ * The stream is read in chunks through the specified read callback,
+ * which fills the buffer passed to it and returns the number of bytes
+ * stored, or 0 (or a negative value) at the end of the stream. This
+ * allows loading data that never exists in memory as a whole, e.g.
+ * data decrypted on the fly.
+ *
+ * The nodes in the specified stream are added to the specified top node.
+ * If no top node is provided, the XML data MUST be well-formed with a
+ * single parent node like <?xml> for the entire stream. The callback
+ * function returns the value type that should be used for child nodes.
+ * If MXML_NO_CALLBACK is specified then all child nodes will be either
+ * MXML_ELEMENT or MXML_TEXT nodes.
+ */
+
+mxml_node_t *				/* O - First node or NULL if the stream has errors. */
+mxmlLoadStream(mxml_node_t    *top,	/* I - Top node */
+               mxml_read_cb_t read_cb,	/* I - Read callback function */
+               void           *read_data,/* I - Read callback data */
+               mxml_load_cb_t cb)	/* I - Callback function or MXML_NO_CALLBACK */
+{
+  return (mxmlSAXLoadStream(top, read_cb, read_data, cb, MXML_NO_CALLBACK,
+                            NULL));
+}
+
+
 /*
  * 'mxmlSaveAllocString()' - Save an XML tree to an allocated string.
  *
@@ -283,6 +318,7 @@ mxmlSaveFd(mxml_node_t    *node,	/* I - Node to write */
   */
 
   buf.fd      = fd;
+  buf.read_cb = NULL;
   buf.current = buf.buffer;
   buf.end     = buf.buffer + sizeof(buf.buffer);
 
@@ -437,6 +473,7 @@ mxmlSAXLoadFd(mxml_node_t    *top,	/* I - Top node */
   */
 
   buf.fd      = fd;
+  buf.read_cb = NULL;
   buf.current = buf.buffer;
   buf.end     = buf.buffer;
 
@@ -524,6 +561,48 @@ mxmlSAXLoadString(
 }
 
 
+/*
+ * 'mxmlSAXLoadStream()' - Load a data stream into an XML node tree
+ *                         using a SAX callback.
+ *
+ * The stream is read in chunks through the specified read callback,
+ * see mxmlLoadStream() for details.
+ *
+ * The SAX callback must call mxmlRetain() for any nodes that need to
+ * be kept for later use. Otherwise, nodes are deleted when the parent
+ * node is closed or after each data, comment, CDATA, or directive node.
+ */
+
+mxml_node_t *				/* O - First node or NULL if the stream has errors. */
+mxmlSAXLoadStream(
+    mxml_node_t    *top,		/* I - Top node */
+    mxml_read_cb_t read_cb,		/* I - Read callback function */
+    void           *read_data,		/* I - Read callback data */
+    mxml_load_cb_t cb,			/* I - Callback function or MXML_NO_CALLBACK */
+    mxml_sax_cb_t  sax_cb,		/* I - SAX callback or MXML_NO_CALLBACK */
+    void           *sax_data)		/* I - SAX user data */
+{
+  _mxml_fdbuf_t	buf;			/* Stream buffer */
+
+
+ /*
+  * Initialize the stream buffer...
+  */
+
+  buf.fd        = -1;
+  buf.read_cb   = read_cb;
+  buf.read_data = read_data;
+  buf.current   = buf.buffer;
+  buf.end       = buf.buffer;
+
+ /*
+  * Read the XML data...
+  */
+
+  return (mxml_load_data(top, &buf, cb, mxml_fd_getc, sax_cb, sax_data));
+}
+
+
 /*
  * 'mxmlSetCustomHandlers()' - Set the handling functions for custom data.
  *
@@ -1014,6 +1093,22 @@ mxml_fd_read(_mxml_fdbuf_t *buf)		/* I - File descriptor buffer */
   if (!buf)
     return (-1);
 
+ /*
+  * Read from the stream callback...
+  */
+
+  if (buf->read_cb)
+  {
+    if ((bytes = (buf->read_cb)(buf->read_data, buf->buffer,
+                                sizeof(buf->buffer))) <= 0)
+      return (-1);
+
+    buf->current = buf->buffer;
+    buf->end     = buf->buffer + bytes;
+
+    return (0);
+  }
+
  /*
   * Read from the file descriptor...
   */
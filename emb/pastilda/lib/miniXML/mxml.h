@@ -179,6 +179,9 @@ typedef const char *(*mxml_save_cb_t)(mxml_node_t *, int);
 typedef void (*mxml_sax_cb_t)(mxml_node_t *, mxml_sax_event_t, void *);
 					/**** SAX callback function ****/
 
+typedef int (*mxml_read_cb_t)(void *, unsigned char *, int);
+					/**** Stream read callback function ****/
+
 
 /*
  * C++ support...
@@ -244,6 +247,9 @@ extern mxml_node_t	*mxmlLoadFile(mxml_node_t *top, FILE *fp,
 			              mxml_type_t (*cb)(mxml_node_t *));
 extern mxml_node_t	*mxmlLoadString(mxml_node_t *top, const char *s,
 			                mxml_type_t (*cb)(mxml_node_t *));
+extern mxml_node_t	*mxmlLoadStream(mxml_node_t *top, mxml_read_cb_t read_cb,
+			                void *read_data,
+			                mxml_type_t (*cb)(mxml_node_t *));
 extern mxml_node_t	*mxmlNewCDATA(mxml_node_t *parent, const char *string);
 extern mxml_node_t	*mxmlNewCustom(mxml_node_t *parent, void *data,
 			               mxml_custom_destroy_cb_t destroy);
@@ -280,6 +286,10 @@ extern mxml_node_t	*mxmlSAXLoadFile(mxml_node_t *top, FILE *fp,
 extern mxml_node_t	*mxmlSAXLoadString(mxml_node_t *top, const char *s,
 			                   mxml_type_t (*cb)(mxml_node_t *),
 			                   mxml_sax_cb_t sax, void *sax_data);
+extern mxml_node_t	*mxmlSAXLoadStream(mxml_node_t *top,
+			                   mxml_read_cb_t read_cb, void *read_data,
+			                   mxml_type_t (*cb)(mxml_node_t *),
+			                   mxml_sax_cb_t sax, void *sax_data);
 extern int		mxmlSetCDATA(mxml_node_t *node, const char *data);
 extern int		mxmlSetCustom(mxml_node_t *node, void *data,
 			              mxml_custom_destroy_cb_t destroy);
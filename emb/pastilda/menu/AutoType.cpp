@@ -0,0 +1,380 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "systick_ext.h"
+#include <keepass/keepass_crypto.h>
+
+#include <AutoType.h>
+
+using namespace Keys;
+using namespace DB;
+
+namespace Logic {
+
+constexpr size_t AutoTypeProgram::MAX_INSTRUCTIONS_COUNT;
+constexpr uint16_t AutoTypeProgram::MAX_REPEAT_COUNT;
+constexpr uint16_t AutoTypeProgram::MAX_DELAY_MS;
+constexpr size_t AutoTypeRunner::PASSWORD_PART_LENGTH;
+
+namespace {
+	using Op = AutoTypeProgram::Op;
+
+	struct Placeholder {
+		const char* name;
+		Op op;
+		UsbKey key;
+	};
+
+	// Names are compared case-insensitive, as KeePass does
+	constexpr Placeholder PLACEHOLDERS[] = {
+		{"USERNAME", Op::TYPE_LOGIN, UsbKey::NOT_A_KEY},
+		{"PASSWORD", Op::TYPE_PASSWORD, UsbKey::NOT_A_KEY},
+		{"TITLE", Op::TYPE_TITLE, UsbKey::NOT_A_KEY},
+		{"DELAY", Op::DELAY, UsbKey::NOT_A_KEY},
+		{"TAB", Op::PRESS_KEY, UsbKey::KEY_TAB},
+		{"ENTER", Op::PRESS_KEY, UsbKey::KEY_ENTER},
+		{"SPACE", Op::PRESS_KEY, UsbKey::KEY_SPACEBAR},
+		{"BACKSPACE", Op::PRESS_KEY, UsbKey::KEY_BACKSPACE},
+		{"BKSP", Op::PRESS_KEY, UsbKey::KEY_BACKSPACE},
+		{"BS", Op::PRESS_KEY, UsbKey::KEY_BACKSPACE},
+		{"DELETE", Op::PRESS_KEY, UsbKey::KEY_DELETE},
+		{"DEL", Op::PRESS_KEY, UsbKey::KEY_DELETE},
+		{"INSERT", Op::PRESS_KEY, UsbKey::KEY_INSERT},
+		{"INS", Op::PRESS_KEY, UsbKey::KEY_INSERT},
+		{"ESC", Op::PRESS_KEY, UsbKey::KEY_ESCAPE},
+		{"HOME", Op::PRESS_KEY, UsbKey::KEY_HOME},
+		{"END", Op::PRESS_KEY, UsbKey::KEY_END1},
+		{"PGUP", Op::PRESS_KEY, UsbKey::KEY_PAGEUP},
+		{"PGDN", Op::PRESS_KEY, UsbKey::KEY_PAGEDOWN},
+		{"UP", Op::PRESS_KEY, UsbKey::KEY_UPARROW},
+		{"DOWN", Op::PRESS_KEY, UsbKey::KEY_DOWNARROW},
+		{"LEFT", Op::PRESS_KEY, UsbKey::KEY_LEFTARROW},
+		{"RIGHT", Op::PRESS_KEY, UsbKey::KEY_RIGHTARROW}
+	};
+
+	constexpr uint16_t MAX_ARGUMENT = UINT16_MAX;
+
+	inline uint8_t toUpper(uint8_t symbol) {
+		return ((symbol >= 'a' && symbol <= 'z') ? symbol - ('a' - 'A') : symbol);
+	}
+
+	bool isName(StringFieldConst& text, const char* name) {
+		size_t length = std::strlen(name);
+		if (text.length() != length) {
+			return false;
+		}
+
+		for (size_t i = 0; i < length; ++i) {
+			if (toUpper(text[i]) != (uint8_t)name[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// "{TAB 3}" and "{DELAY 300}" have decimal argument, it's capped
+	// by the caller. "{DELAY=300}" isn't supported
+	bool parseArgument(StringFieldConst& text, uint16_t* argument) {
+		if (text.empty()) {
+			return false;
+		}
+
+		uint32_t value = 0;
+		for (size_t i = 0; i < text.length(); ++i) {
+			if (text[i] < '0' || text[i] > '9') {
+				return false;
+			}
+			value = value * 10 + (text[i] - '0');
+			if (value > MAX_ARGUMENT) {
+				return false;
+			}
+		}
+
+		*argument = value;
+		return true;
+	}
+}
+
+AutoTypeProgram::AutoTypeProgram() :
+	_count(0)
+{ }
+
+bool AutoTypeProgram::compile(StringFieldConst& sequence)
+{
+	_text = sequence;
+	_count = 0;
+
+	size_t textStart = 0;
+	size_t pos = 0;
+
+	while (pos < _text.length()) {
+		uint8_t symbol = _text[pos];
+
+		if (symbol == '{') {
+			if (_addText(textStart, pos - textStart) == false) {
+				return false;
+			}
+
+			// "{{}" and "{}}" are braces themselves
+			size_t end = _text.find('}', pos + 2);
+			if (end == StringField::npos) {
+				return false;
+			}
+			if (_addPlaceholder(pos + 1, end - pos - 1) == false) {
+				return false;
+			}
+
+			pos = textStart = end + 1;
+		}
+		else if (symbol == '~') {  // Enter
+			if (_addText(textStart, pos - textStart) == false ||
+				_add(Op::PRESS_KEY, UsbKey::KEY_ENTER, 0, 1) == false)
+			{
+				return false;
+			}
+
+			pos = textStart = pos + 1;
+		}
+		else if (symbol == '+' || symbol == '^' || symbol == '%' ||
+				 symbol == '(' || symbol == ')')
+		{
+			return false;  // modifiers and groups aren't supported
+		}
+		else {
+			pos++;
+		}
+	}
+
+	return (_addText(textStart, pos - textStart) && _count > 0);
+}
+
+bool AutoTypeProgram::_addPlaceholder(size_t offset, size_t length)
+{
+	StringField body = _text.substr(offset, length);
+	StringField name = body;
+	uint16_t argument = 1;
+
+	size_t space = body.find(' ');
+	if (space != StringField::npos) {
+		name = body.substr(0, space);
+		if (parseArgument(body.substr(space + 1), &argument) == false) {
+			return false;
+		}
+	}
+
+	// Escaped special chars are typed as they are
+	if (name.length() == 1 && space == StringField::npos) {
+		uint8_t symbol = name[0];
+		if (symbol == '{' || symbol == '}' || symbol == '+' ||
+			symbol == '^' || symbol == '%' || symbol == '~' ||
+			symbol == '(' || symbol == ')')
+		{
+			return _addText(offset, 1);
+		}
+	}
+
+	for (const Placeholder& placeholder : PLACEHOLDERS) {
+		if (isName(name, placeholder.name) == false) {
+			continue;
+		}
+
+		// Long delays and repeats would hold the keyboard
+		if (placeholder.op == Op::DELAY) {
+			if (space == StringField::npos || argument > MAX_DELAY_MS) {
+				return false;
+			}
+			return _add(Op::DELAY, UsbKey::NOT_A_KEY, argument, 0);
+		}
+
+		if (placeholder.op != Op::PRESS_KEY && space != StringField::npos) {
+			return false;
+		}
+		if (argument > MAX_REPEAT_COUNT) {
+			return false;
+		}
+		return _add(placeholder.op, placeholder.key, 0, argument);
+	}
+
+	return false;
+}
+
+bool AutoTypeProgram::_addText(size_t offset, size_t length)
+{
+	if (length == 0) {
+		return true;
+	}
+	if (offset > MAX_ARGUMENT || length > MAX_ARGUMENT) {
+		return false;
+	}
+
+	// Escaped chars go one by one, adjacent text is merged
+	if (_count > 0) {
+		Instruction& last = _instructions[_count - 1];
+		if (last.op == Op::TYPE_TEXT && last.value + last.count == offset) {
+			last.count += length;
+			return true;
+		}
+	}
+
+	return _add(Op::TYPE_TEXT, UsbKey::NOT_A_KEY, offset, length);
+}
+
+bool AutoTypeProgram::_add(Op op, UsbKey key, uint16_t value, uint16_t count)
+{
+	if (_count == MAX_INSTRUCTIONS_COUNT) {
+		return false;
+	}
+
+	_instructions[_count++] = {op, key, value, count};
+	return true;
+}
+
+AutoTypeRunner::AutoTypeRunner(PackageFactory* factory,
+							   const PasswordCallback& revealPassword) :
+	_factory(factory),
+	_revealPassword(revealPassword),
+	_program(nullptr),
+	_step(0),
+	_passwordPosition(0),
+	_isPasswordRevealed(false),
+	_isFailed(false),
+	_isDelayStarted(false),
+	_delayStartMs(0)
+{ }
+
+void AutoTypeRunner::start(const AutoTypeProgram& program,
+						   const DB::Entry& entry)
+{
+	_program = &program;
+	_entry = entry;
+	_step = 0;
+	_passwordPosition = 0;
+	_isFailed = false;
+	_isDelayStarted = false;
+}
+
+void AutoTypeRunner::stop()
+{
+	// Reports are dropped first, the buffer isn't read after that
+	if (isRunning()) {
+		_factory->cancel();
+	}
+	_wipePassword();
+
+	_program = nullptr;
+	_isDelayStarted = false;
+}
+
+void AutoTypeRunner::process()
+{
+	while (isRunning()) {
+		// Reports of the previous step are sent first
+		if (_factory->isIdle() == false) {
+			return;
+		}
+
+		if (_isPasswordRevealed) {
+			_wipePassword();
+		}
+
+		if (_step == _program->getInstructionsCount()) {
+			_program = nullptr;
+			return;
+		}
+
+		if (_execute(_program->getInstruction(_step)) == false) {
+			return;
+		}
+		_step++;
+	}
+}
+
+bool AutoTypeRunner::_execute(const AutoTypeProgram::Instruction& instruction)
+{
+	switch (instruction.op) {
+		case Op::TYPE_LOGIN:
+			_factory->processData(_entry.getLogin());
+		break;
+
+		case Op::TYPE_PASSWORD:
+			return (_typePassword());
+
+		case Op::TYPE_TITLE:
+			_factory->processData(_entry.getName());
+		break;
+
+		case Op::TYPE_TEXT:
+			_factory->processData(_program->getText(instruction));
+		break;
+
+		case Op::PRESS_KEY:
+			_factory->generateKeyPackage(instruction.key, instruction.count);
+		break;
+
+		case Op::DELAY:
+			// Delay is counted from the moment the last report is sent
+			if (_isDelayStarted == false) {
+				_isDelayStarted = true;
+				_delayStartMs = get_counter_ms();
+			}
+			if (get_counter_ms() - _delayStartMs < instruction.value) {
+				return false;
+			}
+			_isDelayStarted = false;
+		break;
+	}
+
+	return true;
+}
+
+bool AutoTypeRunner::_typePassword()
+{
+	size_t length = 0;
+	if (_revealPassword(_entry, _passwordPosition, _password, sizeof(_password), &length) == false) {
+		stop();
+		_isFailed = true;
+		return false;
+	}
+
+	if (length == 0) {
+		_passwordPosition = 0;
+		return true;  // whole password is typed
+	}
+
+	// Next part is revealed when this one is typed and wiped
+	_isPasswordRevealed = true;
+	_factory->processData((const char*)_password, length);
+	_passwordPosition += length;
+	return false;
+}
+
+void AutoTypeRunner::_wipePassword()
+{
+	KeepAss::KeePassCrypto::wipe(_password, sizeof(_password));
+	_isPasswordRevealed = false;
+}
+
+}  // namespace Logic
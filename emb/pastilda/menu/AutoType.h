@@ -0,0 +1,154 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MENU_AUTOTYPE_H_
+#define MENU_AUTOTYPE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <FastDelegate.h>
+
+#include <keys/Key.h>
+#include <database/DbEntry.h>
+#include <UsbPackageFactory.h>
+
+using std::size_t;
+
+namespace fd = fastdelegate;
+
+namespace Logic {
+
+// KeePass Auto-Type sequence compiled to a small program, e.g.
+// "{USERNAME}{TAB}{PASSWORD}{DELAY 300}{ENTER}". Literal text is
+// kept as a part of the sequence string, it must outlive the program.
+class AutoTypeProgram {
+public:
+	static constexpr size_t MAX_INSTRUCTIONS_COUNT = 32;
+	static constexpr uint16_t MAX_REPEAT_COUNT = 64;
+	static constexpr uint16_t MAX_DELAY_MS = 10000;
+
+	enum class Op : uint8_t {
+		TYPE_LOGIN,
+		TYPE_PASSWORD,
+		TYPE_TITLE,
+		TYPE_TEXT,   // value is offset of text, count is its length
+		PRESS_KEY,   // key is pressed count times
+		DELAY        // value is delay in ms
+	};
+
+	struct Instruction {
+		Op op;
+		UsbKey key;
+		uint16_t value;
+		uint16_t count;
+	};
+
+	AutoTypeProgram();
+
+	bool compile(DB::StringFieldConst& sequence);
+
+	size_t getInstructionsCount() const {
+		return _count;
+	}
+
+	const Instruction& getInstruction(size_t num) const {
+		return _instructions[num];
+	}
+
+	DB::StringField getText(const Instruction& instruction) const {
+		return _text.substr(instruction.value, instruction.count);
+	}
+
+private:
+	DB::StringField _text;
+	Instruction _instructions[MAX_INSTRUCTIONS_COUNT];
+	size_t _count;
+
+	bool _addPlaceholder(size_t offset, size_t length);
+	bool _addText(size_t offset, size_t length);
+	bool _add(Op op, UsbKey key, uint16_t value, uint16_t count);
+};
+
+// Runs the program step by step from the main loop. The next step
+// starts only when all reports of the previous one are sent,
+// delays don't block the loop. Password of any length is typed by
+// parts of the buffer. A password which can't be revealed stops the
+// program, nothing after it is typed.
+class AutoTypeRunner {
+public:
+	// Protected value is decoded by base64 quads of 3 bytes
+	static constexpr size_t PASSWORD_PART_LENGTH = 255;
+
+	static_assert(PASSWORD_PART_LENGTH % 3 == 0, "Part must hold whole base64 quads");
+
+	using PackageFactory = UsbPackages::PackageFactory;
+	// Plain password from the position is written to the buffer,
+	// length is 0 past its end, false if it can't be revealed
+	using PasswordCallback =
+			fd::FastDelegate5<const DB::Entry&, size_t, uint8_t*, size_t, size_t*, bool>;
+
+	AutoTypeRunner(PackageFactory* factory,
+				   const PasswordCallback& revealPassword);
+
+	void start(const AutoTypeProgram& program, const DB::Entry& entry);
+	// Reports which aren't sent yet are dropped, password is wiped
+	void stop();
+	void process();
+
+	bool isRunning() const {
+		return (_program != nullptr);
+	}
+
+	// Last program was stopped by a password which can't be revealed
+	bool isFailed() const {
+		return (_isFailed);
+	}
+
+private:
+	PackageFactory* _factory;
+	PasswordCallback _revealPassword;
+
+	const AutoTypeProgram* _program;
+	DB::Entry _entry;
+	size_t _step;
+
+	// Password part is typed lazily from the buffer,
+	// it's wiped when all reports are sent
+	uint8_t _password[PASSWORD_PART_LENGTH];
+	size_t _passwordPosition;
+	bool _isPasswordRevealed;
+	bool _isFailed;
+
+	bool _isDelayStarted;
+	uint32_t _delayStartMs;
+
+	bool _execute(const AutoTypeProgram::Instruction& instruction);
+	bool _typePassword();
+	void _wipePassword();
+};
+
+}  // namespace Logic
+
+#endif /* MENU_AUTOTYPE_H_ */
@@ -62,6 +62,9 @@ public:
 	~KeyboardLikeInput();
 
 	void process(UsbPackageConst* packagePtr);
+	void reset() {
+		_resetInput();
+	}
 
 private:
 #ifdef DEBUG
@@ -0,0 +1,312 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <LevelCursor.h>
+
+namespace Logic {
+
+constexpr size_t LevelCursor::FIXED_POINTS_COUNT;
+constexpr size_t LevelCursor::MAX_DEPTH;
+
+LevelCursor::LevelCursor():
+	_db(nullptr),
+	_fixedTree(nullptr),
+	_entryCallback(&FixedTreeT::TreeNodeT::EMPTY_CALLBACK),
+	_inDb(false),
+	_dbTopCount(0),
+	_position(0),
+	_depth(0)
+{ }
+
+LevelCursor::~LevelCursor()
+{ }
+
+void LevelCursor::init(DB::XmlTree* db, FixedTreeT* fixedTree)
+{
+	_db = db;
+	_fixedTree = fixedTree;
+	_dbTopCount = 0;
+
+	// Only top level is counted, it's needed to number fixed points
+	if (_db->isEmpty() == false) {
+		_db->moveInHead();
+		for (_dbTopCount = 1; _db->isMostRight() == false; ++_dbTopCount) {
+			_db->moveRight();
+		}
+	}
+
+	if (_hasDb()) {
+		_enterDb();
+	}
+	else {
+		_enterFixed();
+	}
+}
+
+void LevelCursor::moveLeft()
+{
+	if (_inDb) {
+		if (_db->isMostLeft() == false) {
+			_db->moveLeft();
+			_position--;
+			_load();
+		}
+	}
+	else if (_fixedTree->isMostTop() && _fixedTree->isMostLeft() && _hasDb()) {
+		// From the first fixed point to the last database point
+		_inDb = true;
+		_db->moveInHead();
+		_db->moveMostRight();
+		_depth = 0;
+		_position = _dbTopCount - 1;
+		_load();
+	}
+	else {
+		_fixedTree->moveLeft();
+	}
+}
+
+void LevelCursor::moveRight()
+{
+	if (_inDb) {
+		if (_db->isMostRight() == false) {
+			_db->moveRight();
+			_position++;
+			_load();
+		}
+		else if (_depth == 0) {
+			_enterFixed();
+		}
+	}
+	else {
+		_fixedTree->moveRight();
+	}
+}
+
+void LevelCursor::moveInto()
+{
+	if (_inDb) {
+		if (_db->isMostBottom() == false && _depth < MAX_DEPTH) {
+			_path[_depth++] = _position;
+			_db->moveInto();
+			_position = 0;
+			_load();
+		}
+	}
+	else {
+		_fixedTree->moveInto();
+	}
+}
+
+void LevelCursor::moveOut()
+{
+	if (_inDb) {
+		if (_depth > 0) {
+			_db->moveOut();
+			_position = _path[--_depth];
+			_load();
+		}
+	}
+	else {
+		_fixedTree->moveOut();
+	}
+}
+
+void LevelCursor::moveInHead()
+{
+	if (_inDb) {
+		if (_depth > 0) {
+			while (_depth > 0) {
+				_db->moveOut();
+				_position = _path[--_depth];
+			}
+			_load();
+		}
+	}
+	else {
+		_fixedTree->moveInHead();
+	}
+}
+
+void LevelCursor::moveMostRight()
+{
+	if (_inDb && _depth == 0) {
+		_enterFixed();
+		_fixedTree->moveMostRight();
+	}
+	else if (_inDb) {
+		while (_db->isMostRight() == false) {
+			_db->moveRight();
+			_position++;
+		}
+		_load();
+	}
+	else {
+		_fixedTree->moveMostRight();
+	}
+}
+
+void LevelCursor::moveMostLeft()
+{
+	if (_inDb) {
+		_db->moveMostLeft();
+		_position = 0;
+		_load();
+	}
+	else if (_fixedTree->isMostTop() && _hasDb()) {
+		_enterDb();
+	}
+	else {
+		_fixedTree->moveMostLeft();
+	}
+}
+
+void LevelCursor::moveTo(NodeId node)
+{
+	if (_hasDb() == false) {
+		return;
+	}
+
+	// Breadcrumb is restored by walking to the top from the node
+	size_t positions[MAX_DEPTH];
+	size_t levels = 0;
+
+	// Root group and nodes out of the store aren't menu points
+	_db->moveTo(node);
+	if (_db->getCurrentNode() != node) {
+		return;
+	}
+
+	while (levels < MAX_DEPTH) {
+		size_t position = 0;
+		for (; _db->isMostLeft() == false; ++position) {
+			_db->moveLeft();
+		}
+		positions[levels++] = position;
+
+		if (_db->isMostTop()) {
+			break;
+		}
+		_db->moveOut();
+	}
+	_db->moveTo(node);
+
+	_inDb = true;
+	_position = positions[0];
+	for (_depth = 0; _depth < levels - 1; ++_depth) {
+		_path[_depth] = positions[levels - 1 - _depth];
+	}
+	_load();
+}
+
+bool LevelCursor::isMostLeft()
+{
+	if (_inDb) {
+		return (_db->isMostLeft());
+	}
+
+	bool dbOnLeft = _fixedTree->isMostTop() && _hasDb();
+	return (_fixedTree->isMostLeft() && dbOnLeft == false);
+}
+
+bool LevelCursor::isMostRight()
+{
+	if (_inDb) {
+		// Fixed points follow database top level
+		return (_depth > 0 && _db->isMostRight());
+	}
+
+	return (_fixedTree->isMostRight());
+}
+
+bool LevelCursor::isMostTop()
+{
+	return (_inDb ? _depth == 0 : _fixedTree->isMostTop());
+}
+
+bool LevelCursor::isMostBottom()
+{
+	return (_inDb ? _db->isMostBottom() : _fixedTree->isMostBottom());
+}
+
+size_t LevelCursor::getCurrentChildNum()
+{
+	if (_inDb) {
+		return (_position);
+	}
+
+	size_t offset = _fixedTree->isMostTop() ? _dbTopCount : 0;
+	return (_fixedTree->getCurrentChildNum() + offset);
+}
+
+LevelCursor::ContainerT& LevelCursor::getCurrentContainer()
+{
+	if (_inDb) {
+		return (_entry);
+	}
+
+	return (_fixedTree->getCurrentNode()->getContainer());
+}
+
+void LevelCursor::call()
+{
+	if (_inDb == false) {
+		_fixedTree->call();
+	}
+	else if (_db->isEndNode()) {
+		_entryCallback(_entry);
+	}
+}
+
+void LevelCursor::_enterDb()
+{
+	_inDb = true;
+	_db->moveInHead();
+	_depth = 0;
+	_position = 0;
+	_load();
+}
+
+void LevelCursor::_enterFixed()
+{
+	_inDb = false;
+	_fixedTree->moveInHead();
+	_fixedTree->moveMostLeft();
+}
+
+void LevelCursor::_load()
+{
+	const DB::XmlTree::NodeStruct& node = _db->getCurrentNodeInfo();
+
+	_entry.setIndex(_db->getCurrentNode());
+	_entry.setName(node.name.data(), node.name.length());
+	_entry.setLogin(node.login.data(), node.login.length());
+	_entry.setPassword(node.password.data(), node.password.length());
+	_entry.setType(node.type.data(), node.type.length());
+	_entry.setSequence(node.sequence.data(), node.sequence.length());
+	_entry.setPasswordProtection(node.isPasswordProtected,
+								 node.passwordOffset);
+}
+
+}  // namespace Logic
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MENU_LEVELCURSOR_H_
+#define MENU_LEVELCURSOR_H_
+
+#include <cstddef>
+
+#include <database/DbEntry.h>
+#include <database/xmlindex/XmlIndex.h>
+#include <database/xmltree/XmlTree.h>
+#include <Tree.hpp>
+
+using std::size_t;
+
+namespace Logic {
+
+// Menu level over the database and the fixed menu points.
+// Database points aren't copied into the menu: the cursor walks
+// the entry store and only the current point is materialized.
+// Top level is database top points followed by the fixed points.
+class LevelCursor {
+public:
+	static constexpr size_t FIXED_POINTS_COUNT = 4;
+	static constexpr size_t MAX_DEPTH = DB::XmlIndex::MAX_GROUP_DEPTH;
+
+	using ContainerT = DB::Entry;
+	using NodeId = DB::EntryStore::NodeId;
+	using FixedTreeT = Tree<FIXED_POINTS_COUNT, ContainerT>;
+	using CallbackT = FixedTreeT::CallbackT;
+	using CallbackArg = FixedTreeT::CallbackArg;
+
+	LevelCursor();
+	~LevelCursor();
+
+	void init(DB::XmlTree* db, FixedTreeT* fixedTree);
+	void setEntryCallback(const CallbackT& callback) {
+		_entryCallback = callback;
+	}
+
+	void moveLeft();
+	void moveRight();
+	void moveInto();
+	void moveOut();
+
+	void moveInHead();
+	void moveMostRight();
+	void moveMostLeft();
+	void moveTo(NodeId node);
+
+	bool isMostLeft();
+	bool isMostRight();
+	bool isMostTop();
+	bool isMostBottom();
+
+	size_t getCurrentChildNum();
+	ContainerT& getCurrentContainer();
+	void call();
+
+private:
+	DB::XmlTree* _db;
+	FixedTreeT* _fixedTree;
+	CallbackT _entryCallback;
+
+	bool _inDb;  // cursor is on a database point
+	size_t _dbTopCount;  // database points on top level
+	size_t _position;  // position of current database point
+	size_t _depth;
+	size_t _path[MAX_DEPTH];  // positions of parent points
+	ContainerT _entry;  // current database point
+
+	bool _hasDb() {
+		return (_dbTopCount > 0);
+	}
+
+	void _enterDb();
+	void _enterFixed();
+	void _load();
+};
+
+}  // namespace Logic
+
+#endif /* MENU_LEVELCURSOR_H_ */
@@ -27,18 +27,15 @@
 
 #include <keys/Key.h>
 #include <database/DbEntry.h>
-#include <Tree.hpp>
 
-template <std::size_t COUNT_OF_MENU_POINTS>
+// LevelT is a tree-like cursor over menu points,
+// the menu doesn't own or copy the points
+template <typename LevelT>
 class Menu {
 public:
-	static constexpr std::size_t COUNT_OF_POINTS = COUNT_OF_MENU_POINTS;
-
-	using TreeT = Tree<COUNT_OF_POINTS, DB::Entry>;
+	using TreeT = LevelT;
 	using TreePtr = TreeT*;
 
-	using MenuPoint = typename TreeT::TreeNodePtr;
-
 	using ContainerT = typename TreeT::ContainerT;
 
 	template<typename T>
@@ -54,7 +51,6 @@ public:
 		_tree = tree;
 	}
 	void processKey(Keys::Key key);
-	size_t search(DB::StringFieldConst& substring);
 
 	void moveTop();
 
@@ -70,29 +66,29 @@ private:
 	void _processEnterKey();
 };
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-Menu<COUNT_OF_MENU_POINTS>::Menu():
+template<typename LevelT>
+Menu<LevelT>::Menu():
 	_tree(nullptr)
 { }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-Menu<COUNT_OF_MENU_POINTS>::Menu(TreePtr tree):
+template<typename LevelT>
+Menu<LevelT>::Menu(TreePtr tree):
 	_tree(tree)
 { }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-Menu<COUNT_OF_MENU_POINTS>::~Menu()
+template<typename LevelT>
+Menu<LevelT>::~Menu()
 { }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-inline void Menu<COUNT_OF_MENU_POINTS>::moveTop()
+template<typename LevelT>
+inline void Menu<LevelT>::moveTop()
 {
 	_tree->moveInHead();  // maximum top
 	_tree->moveMostLeft();  // maximum left
 }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-void Menu<COUNT_OF_MENU_POINTS>::processKey(Keys::Key key)
+template<typename LevelT>
+void Menu<LevelT>::processKey(Keys::Key key)
 {
 	using ControlKey = Keys::UsbKey;
 
@@ -113,71 +109,22 @@ void Menu<COUNT_OF_MENU_POINTS>::processKey(Keys::Key key)
 	}
 }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-typename Menu<COUNT_OF_MENU_POINTS>::ContainerT&
-Menu<COUNT_OF_MENU_POINTS>::getCurrentPointContainer()
+template<typename LevelT>
+typename Menu<LevelT>::ContainerT&
+Menu<LevelT>::getCurrentPointContainer()
 {
-	return _tree->getCurrentNode()->getContainer();
+	return _tree->getCurrentContainer();
 }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-void Menu<COUNT_OF_MENU_POINTS>::_processEnterKey()
+template<typename LevelT>
+void Menu<LevelT>::_processEnterKey()
 {
-	MenuPoint currentPoint = _tree->getCurrentNode();
-	if (currentPoint->isEndNode()) {
-		currentPoint->call();
+	if (_tree->isMostBottom()) {
+		_tree->call();
 	}
 	else {
 		_tree->moveInto();
 	}
 }
 
-template<std::size_t COUNT_OF_MENU_POINTS>
-size_t Menu<COUNT_OF_MENU_POINTS>::search(DB::StringFieldConst& substring)
-{
-	size_t pos = DB::StringField::npos;
-
-	// Remember last node
-	int32_t currentNodeNum = _tree->getCurrentChildNum();
-
-	_tree->moveMostLeft();
-
-	// Finding lambda
-	auto findSubstring = [&]() -> size_t {
-		DB::StringFieldConst& compareString =
-				_tree->getCurrentNode()->getContainer().getName();
-		pos = compareString.compare(0, substring.length(), substring);
-	};
-
-	// If found lambda
-	auto substringWasFound = [&]() -> bool {
-		return pos == 0;
-	};
-
-	// Trying to found something
-	while (_tree->isMostRight() == false) {
-		findSubstring();
-		if (substringWasFound()) {
-			break;
-		}
-		_tree->moveRight();
-	}
-
-	// Founding in last child
-	if (substringWasFound() == false) {
-		findSubstring();
-	}
-
-	// If found nothing, return to last node
-	if (substringWasFound() == false) {
-		_tree->moveMostLeft();
-		while (currentNodeNum > 0) {
-			currentNodeNum--;
-			_tree->moveRight();
-		}
-	}
-
-	return pos;
-}
-
 #endif /* MENU_H_ */
@@ -22,6 +22,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
@@ -43,12 +44,12 @@ namespace fd = fastdelegate;
 namespace Logic {
 using namespace Logic::Private;
 
-TildaLogic::TildaLogic(UsbDequeStandart* deque,
+TildaLogic::TildaLogic(UsbRingStandart* ring,
 					   const SpecialPoints& specialPoints):
 	_inputData(nullptr),
 	_inputDataLength(0),
 	_inputPackagePtr(&ZERO_PACKAGE),
-	_packageFactory(PackageFactory(deque)),
+	_packageFactory(PackageFactory(ring)),
 	_db(nullptr),
 	_fixedMenuCbs(new FixedMenuCallbacks(this)),
 	_lastPackage(ZERO_PACKAGE),
@@ -57,7 +58,15 @@ TildaLogic::TildaLogic(UsbDequeStandart* deque,
 #ifdef DEBUG
 			, &_packageFactory
 #endif
-	))
+	)),
+	_autoType(&_packageFactory,
+			  fd::MakeDelegate(this, &TildaLogic::_revealPassword)),
+	_searchResult(0),
+	_isPrefixResult(false),
+	_unlockStats({0, 0, 0}),
+	_unlockStartMs(0),
+	_isSealingPin(false),
+	_greeting(Strings::GREETING_TO_WRITE)
 {
 	_specialMenuPoints.formatFat = specialPoints.formatFat;
 
@@ -72,7 +81,7 @@ void TildaLogic::_init()
 	_fixedMenu.settings = {
 			Strings::SETTINGS_POINT,
 			std::strlen(Strings::SETTINGS_POINT),
-			MenuTreeT::TreeNodeT::EMPTY_CALLBACK
+			FixedTreeT::TreeNodeT::EMPTY_CALLBACK
 	};
 
 	_fixedMenu.exit = {
@@ -81,6 +90,11 @@ void TildaLogic::_init()
 			fd::MakeDelegate(_fixedMenuCbs, &FixedMenuCallbacks::exit)
 	};
 
+	_buildFixedMenu();
+	_menuLevel.setEntryCallback(
+			fd::MakeDelegate(this, &TildaLogic::_logInCallback)
+		);
+
 	_tildaKey = TILDA_MODE_KEY;
 	_tildaSeq.set(UsbSpecialKey::LEFT_CTRL);
 
@@ -89,113 +103,44 @@ void TildaLogic::_init()
 
 void TildaLogic::_buildMenu()
 {
-	_db.init(_keepassReader.get_xml());
-
-	_menuTree.destroy();
-	_buildMenuTree();
-
-	_menu.init(&_menuTree);
+	// Menu points are taken from the store on demand,
+	// so nothing depends on database size here
+	_db.init(_keepassReader.get_store());
+	_menuLevel.init(&_db, &_fixedTree);
+	_searchIndex.build(_keepassReader.get_store());
+	_matcher.build(_keepassReader.get_store());
+
+	_menu.init(&_menuLevel);
 	_menu.moveTop();
 }
 
-void TildaLogic::_buildMenuTree()
-{
-	constexpr uint32_t startIndex = 0;
-	_buildTree(startIndex);
-
-	_menuTree.moveInHead();
-	_menuTree.moveMostRight();
-	_buildFixedMenu();
-}
-
-void TildaLogic::_buildTree(uint32_t index)
-{
-	_copyDbContainer(index++);
-
-	if (_db.isMostBottom() == false) {
-		_db.moveInto();
-
-		_menuTree.addChild();
-		_menuTree.moveInto();
-		_menuTree.moveMostRight();
-
-		_buildTree(index++);
-	}
-	else {
-		while (_db.isMostRight() == false) {
-			_db.moveRight();
-
-			_menuTree.moveOut();
-			if (_db.isMostTop()) {
-				_menuTree.addNeighbor();
-				_menuTree.moveRight();
-			}
-			else {
-				_menuTree.addChild();
-				_menuTree.moveInto();
-				_menuTree.moveMostRight();
-			}
-
-			_buildTree(index++);
-		}
-
-		_db.moveOut();
-		_menuTree.moveOut();
-	}
-}
-
 void TildaLogic::_buildFixedMenu()
 {
-	_menuTree.addNeighbor();
-	_menuTree.moveRight();
+	_fixedTree.destroy();
 	_addMenuPoint(_fixedMenu.settings);
 
 	// Add special menu points
-	_menuTree.addChild();
-	_menuTree.moveInto();
+	_fixedTree.addChild();
+	_fixedTree.moveInto();
 	_addMenuPoint(_specialMenuPoints.formatFat);
-	_menuTree.getCurrentNode()->setCallback(
+	_fixedTree.setCallback(
 			fd::MakeDelegate(_fixedMenuCbs, &FixedMenuCallbacks::formatFat)
 		);
 	// Another points
-	_menuTree.moveOut();
+	_fixedTree.moveOut();
 
-	_menuTree.addNeighbor();
-	_menuTree.moveRight();
+	_fixedTree.addNeighbor();
+	_fixedTree.moveRight();
 	_addMenuPoint(_fixedMenu.exit);
-	_menuTree.getCurrentNode()->setCallback(
+	_fixedTree.setCallback(
 			_fixedMenu.exit.callback
 		);
 }
 
-void TildaLogic::_copyDbContainer(uint32_t index)
-{
-	MenuTreeT::TreeNodePtr currentNode = _menuTree.getCurrentNode();
-	MenuTreeT::ContainerT& currentContainer = currentNode->getContainer();
-
-	const XmlTree::NodeStruct& srcNode = _db.getCurrentNodeInfo();
-
-	currentContainer.setIndex(index);
-	currentContainer.setName(srcNode.name.data(), srcNode.name.length());
-	currentContainer.setLogin(srcNode.login.data(), srcNode.login.length());
-	currentContainer.setPassword(srcNode.password.data(),
-								 srcNode.password.length());
-	currentContainer.setType(srcNode.type.data(), srcNode.type.length());
-
-	if (_db.isEndNode()) {
-		currentNode->setCallback(
-			fd::MakeDelegate(
-					this,
-					&TildaLogic::_logInCallback
-				)
-			);
-	}
-}
-
 template<typename T>
 void TildaLogic::_addMenuPoint(T& point)
 {
-	MenuTreeT::TreeNodePtr node = _menuTree.getCurrentNode();
+	FixedTreeT::TreeNodePtr node = _fixedTree.getCurrentNode();
 	node->getContainer().setName(
 		reinterpret_cast<const StringFieldChar*>(
 				point.name
@@ -206,28 +151,58 @@ void TildaLogic::_addMenuPoint(T& point)
 
 void TildaLogic::_logInCallback(MenuT::ContainerT& container)
 {
-	_packageFactory.generateClearSequence(container.getName().length());
-
-	// Login enter
-	_packageFactory.processData(container.getLogin());
-
-	// Switch field
-	StringFieldConst& type = container.getType();
-	if (type == Strings::FORM) {
-		_packageFactory.generateTabPackage();
+	StringFieldConst& name = container.getName();
+	StringFieldConst& sequence = container.getSequence();
+
+	// Sequence of entry or its groups, otherwise the one of login type.
+	// Broken sequence isn't replaced by another one, it's shown as error.
+	if (sequence.empty()) {
+		StringFieldConst& type = container.getType();
+		_autoTypeProgram.compile(StringField(
+				(type == Strings::FORM) ?
+						Strings::FORM_SEQUENCE : Strings::CONSOLE_SEQUENCE
+			));
 	}
-	else {
-		_packageFactory.generateEnterPackage();
-		delay_ms(800);  // Wait console reaction
+	else if (_autoTypeProgram.compile(sequence) == false) {
+		_packageFactory.generateClearSequence(name.length());
+		_sendMsg(Strings::SEQUENCE_ERROR);
+		delay_ms(WRONG_PASSWORD_DELAY);
+		_clearMsg(Strings::SEQUENCE_ERROR);
+
+		_packageFactory.processData(name);
+		return;
 	}
 
-	// Password enter
-	_packageFactory.processData(container.getPassword());
+	_packageFactory.generateClearSequence(name.length());
+
+	// Program is typed from poll(), input is dropped until it's done
+	_autoType.start(_autoTypeProgram, container);
+	_keysBuffer.resize(0);
+	_setState(State::AUTO_TYPE);
+}
+
+bool TildaLogic::_revealPassword(const MenuT::ContainerT& container, size_t position,
+								uint8_t* buffer, size_t size, size_t* length)
+{
+	StringFieldConst& password = container.getPassword();
+
+	*length = 0;
+	if (container.isPasswordProtected() == false) {
+		if (position < password.length()) {
+			*length = std::min(password.length() - position, size);
+			std::memcpy(buffer, password.data() + position, *length);
+		}
+		return true;
+	}
 
-	// Press "Enter"
-	_packageFactory.generateEnterPackage();
+	// Store stays encrypted, the value is decrypted into the runner's buffer
+	uint32_t partLength = 0;
+	bool isRevealed = _keepassReader.reveal_protected_part(
+			password.data(), password.length(), container.getPasswordOffset(),
+			position, buffer, size, &partLength);
 
-	_setState(State::MENU_MODE_END);
+	*length = partLength;
+	return isRevealed;
 }
 
 void TildaLogic::process(DataBufferConst inputData, size_t inputDataLength)
@@ -248,6 +223,16 @@ void TildaLogic::process(DataBufferConst inputData, size_t inputDataLength)
 			_processMasterPassword();
 		break;
 
+		case State::ENTER_NEW_PIN:
+			_processNewPin();
+		break;
+
+		case State::DB_DECRYPTING:
+			// Keyboard stays usable while the key is transformed
+			_redirectInput();
+			_lastPackage = *_inputPackagePtr;
+		break;
+
 		case State::MENU_MODE_START:
 			_sendMenuGreeting();
 			_setState(State::MENU_MODE);
@@ -258,6 +243,15 @@ void TildaLogic::process(DataBufferConst inputData, size_t inputDataLength)
 			_lastPackage = *_inputPackagePtr;
 		break;
 
+		case State::SEARCH_MODE:
+			_processSearchMode();
+			_lastPackage = *_inputPackagePtr;
+		break;
+
+		case State::AUTO_TYPE:
+			_processAutoType();
+		break;
+
 		default:
 		break;
 	}
@@ -269,76 +263,221 @@ void TildaLogic::_processMasterPassword()
 		const char* passw = (const char*)_keysBuffer.data();
 		size_t passwLen = _keysBuffer.size();
 
+		// Empty PIN falls back to the master password
+		if (passwLen == 0 && _greeting == Strings::GREETING_QUICK_UNLOCK) {
+			_keepassReader.forget_quick_unlock();
+			_clearHiddenInput();
+
+			_selectGreeting();
+			_sendMsg(_greeting);
+			return;
+		}
+
 		_dbDecrypt(passw, passwLen);
+		_clearHiddenInput();
 
-		_keysBuffer.resize(0);
-		_packageFactory.generateClearSequence(_lastKeysBufferLen);
-		_lastKeysBufferLen = 0;
+		_checkDbState();
+	}
+	else if (_inputPackagePtr->key[0] == UsbKey::KEY_ESCAPE) {
+		_clearHiddenInput();
+		_setState(State::PASSIVE_MODE);
+	}
+	else {
+		_processHiddenInput();
+	}
+}
+
+void TildaLogic::_startNewPin()
+{
+	_keysBuffer.resize(0);
+	_lastKeysBufferLen = 0;
+	_keyboardInput.reset();
 
-		if (_currentState == State::MASTER_PASSWORD_PASSED) {
-			_buildMenu();
+	_greeting = Strings::GREETING_NEW_PIN;
+	_sendMsg(_greeting);
 
-			_setState(State::MENU_MODE_START);
-		}
-		else {
-			_clearMsg(Strings::GREETING_TO_WRITE);
+	_setState(State::ENTER_NEW_PIN);
+}
 
-			_sendMsg(_getDbErrorType());
-			delay_ms(WRONG_PASSWORD_DELAY);
-			_clearMsg(_getDbErrorType());
+void TildaLogic::_processNewPin()
+{
+	if (_inputPackagePtr->key[0] == UsbKey::KEY_ENTER) {
+		bool isSet = _keepassReader.set_quick_unlock_pin(
+				(const char*)_keysBuffer.data(), _keysBuffer.size());
+		_clearHiddenInput();
 
-			_setState(State::ENTER_MASTER_PASSWORD);
+		if (isSet == false) {
+			_sendMsg(Strings::PIN_LENGTH_ERROR);
+			delay_ms(WRONG_PASSWORD_DELAY);
+			_clearMsg(Strings::PIN_LENGTH_ERROR);
 
-			_sendMsg(Strings::GREETING_TO_WRITE);
+			_sendMsg(_greeting);
+			return;
 		}
+
+		// PIN key is derived in slices as the master key is
+		_isSealingPin = true;
+		_dbState = KeepAss::DecryptionResult::IN_PROGRESS;
+		_setState(State::DB_DECRYPTING);
 	}
 	else if (_inputPackagePtr->key[0] == UsbKey::KEY_ESCAPE) {
-		_packageFactory.generateClearSequence(_lastKeysBufferLen);
-		_lastKeysBufferLen = 0;
+		_clearHiddenInput();
+		_keepassReader.discard_quick_unlock_pin();
 
-		_clearMsg(Strings::GREETING_TO_WRITE);
-		_setState(State::PASSIVE_MODE);
+		_buildMenu();
+		_setState(State::MENU_MODE_START);
 	}
 	else {
-		_keyboardInput.process(_inputPackagePtr);
+		_processHiddenInput();
+	}
+}
+
+void TildaLogic::_clearHiddenInput()
+{
+	_keysBuffer.resize(0);
+	_packageFactory.generateClearSequence(_lastKeysBufferLen);
+	_lastKeysBufferLen = 0;
+	_clearMsg(_greeting);
+}
+
+void TildaLogic::_processHiddenInput()
+{
+	_keyboardInput.process(_inputPackagePtr);
 
-		int32_t newOutputLen =
-				(int32_t)_keysBuffer.size() - (int32_t)_lastKeysBufferLen;
-		if (newOutputLen > 0) {
+	int32_t newOutputLen =
+			(int32_t)_keysBuffer.size() - (int32_t)_lastKeysBufferLen;
+	if (newOutputLen > 0) {
 #ifdef DEBUG
-			_packageFactory.processData(" >", 2);
-			for (size_t i = _lastKeysBufferLen; i < _keysBuffer.size(); ++i) {
-				_packageFactory.processData((char*)&_keysBuffer[i], 1);
-			}
-#else
-			for (size_t i = 0; i < newOutputLen; ++i) {
-				_sendMsg(Strings::PASSWORD_SYMB);
-			}
-#endif
+		_packageFactory.processData(" >", 2);
+		for (size_t i = _lastKeysBufferLen; i < _keysBuffer.size(); ++i) {
+			_packageFactory.processData((char*)&_keysBuffer[i], 1);
 		}
-		else {
-			_packageFactory.generateClearSequence(abs(newOutputLen));
-			_packageFactory.generateEmptyPackage();
+#else
+		for (size_t i = 0; i < newOutputLen; ++i) {
+			_sendMsg(Strings::PASSWORD_SYMB);
 		}
-
-		_lastKeysBufferLen = _keysBuffer.size();
+#endif
+	}
+	else {
+		_packageFactory.generateClearSequence(abs(newOutputLen));
+		_packageFactory.generateEmptyPackage();
 	}
+
+	_lastKeysBufferLen = _keysBuffer.size();
 }
 
 void TildaLogic::_dbDecrypt(const char* passwd, size_t len)
+{
+	_searchIndex.clear();  // store is rebuilt
+	_matcher.clear();
+	_keepassReader.set_password(passwd, len);
+
+	_unlockStartMs = get_counter_ms();
+	if (_greeting == Strings::GREETING_QUICK_UNLOCK) {
+		_dbState = _keepassReader.quick_decrypt_database(KEEPASS_BASE_FILE);
+	}
+	else {
+		_dbState = _keepassReader.decrypt_database(KEEPASS_BASE_FILE);
+	}
+
+	_setState(State::DB_DECRYPTING);
+}
+
+void TildaLogic::_checkDbState()
 {
 	using namespace KeepAss;
 
-	_keepassReader.set_password(passwd, len);
+	if (_dbState == DecryptionResult::IN_PROGRESS) {
+		return;
+	}
 
-	_dbState = _keepassReader.decrypt_database(KEEPASS_BASE_FILE);
+	uint32_t unlockMs = get_counter_ms() - _unlockStartMs;
+
+	// Database is open already, sealing of the new PIN can't fail it
+	if (_isSealingPin) {
+		_isSealingPin = false;
+
+		_buildMenu();
+		_setState(State::MENU_MODE_START);
+		return;
+	}
 
 	if (_dbState == DecryptionResult::SUCCESS) {
-		_setState(State::MASTER_PASSWORD_PASSED);
+		if (_keepassReader.is_quick_unlocked()) {
+			_unlockStats.lastQuickUnlockMs = unlockMs;
+			_unlockStats.quickUnlocksCount++;
+		}
+		else {
+			_unlockStats.lastFullUnlockMs = unlockMs;
+		}
+
+#ifdef DEBUG
+		static char stats[48];  // it's typed lazily
+		int statsLen = snprintf(stats, sizeof(stats), " full:%lums quick:%lums(%lu)",
+				(unsigned long)_unlockStats.lastFullUnlockMs,
+				(unsigned long)_unlockStats.lastQuickUnlockMs,
+				(unsigned long)_unlockStats.quickUnlocksCount);
+		_packageFactory.processData(stats, statsLen);
+#endif
+
+		// PIN is chosen right after the master password is accepted
+		if (_keepassReader.is_quick_unlock_pin_expected()) {
+			_startNewPin();
+			return;
+		}
+
+		_buildMenu();
+
+		_setState(State::MENU_MODE_START);
 	}
 	else {
+		_sendMsg(_getDbErrorType());
+		delay_ms(WRONG_PASSWORD_DELAY);
+		_clearMsg(_getDbErrorType());
+
+		_setState(State::ENTER_MASTER_PASSWORD);
+
+		_selectGreeting();
+		_sendMsg(_greeting);
+	}
+}
+
+void TildaLogic::poll()
+{
+	if (_currentState == State::DB_DECRYPTING) {
+		_dbState = _keepassReader.continue_decryption();
+		_checkDbState();
+	}
+	else if (_currentState == State::AUTO_TYPE) {
+		_autoType.process();
+		if (_autoType.isRunning() == false) {
+			_setState(State::PASSIVE_MODE);
+		}
+		// Nothing after the password is typed, e.g. Enter of the form
+		if (_autoType.isFailed()) {
+			_sendMsg(Strings::SEQUENCE_ERROR);
+			delay_ms(WRONG_PASSWORD_DELAY);
+			_clearMsg(Strings::SEQUENCE_ERROR);
+		}
+	}
+}
+
+void TildaLogic::_processAutoType()
+{
+	// Esc or Tilda chord stops typing, the rest of the password isn't sent
+	bool isAbort = (_inputPackagePtr->key[0] == UsbKey::KEY_ESCAPE ||
+					(_inputPackagePtr->key[0] == _tildaKey &&
+					 _tildaSeq == _inputPackagePtr->special));
+
+	if (isAbort) {
+		_autoType.stop();
 		_setState(State::PASSIVE_MODE);
+
+		_lastPackage = ZERO_PACKAGE;  // chord's release doesn't open menu
+		return;
 	}
+
+	_lastPackage = *_inputPackagePtr;
 }
 
 void TildaLogic::_redirectInput()
@@ -356,7 +495,8 @@ inline void TildaLogic::_checkMode()
 			_lastPackage = ZERO_PACKAGE;
 
 			if (_currentState == State::MENU_MODE_START) {
-				_sendMsg(Strings::GREETING_TO_WRITE);
+				_selectGreeting();
+				_sendMsg(_greeting);
 
 				_setState(State::ENTER_MASTER_PASSWORD);
 			}
@@ -364,11 +504,16 @@ inline void TildaLogic::_checkMode()
 	}
 }
 
+inline void TildaLogic::_selectGreeting()
+{
+	_greeting = _keepassReader.is_quick_unlock_ready() ?
+			Strings::GREETING_QUICK_UNLOCK : Strings::GREETING_TO_WRITE;
+}
+
 inline void TildaLogic::_sendMenuGreeting()
 {
 	_menu.moveTop();
 
-	_clearMsg(Strings::GREETING_TO_WRITE);
 	_packageFactory.processData(
 		_menu.getCurrentPointContainer().getName()
 	);
@@ -379,6 +524,7 @@ inline void TildaLogic::_switchMenuMode()
 	_keysBuffer.resize(0);
 	if (_currentState == State::MENU_MODE ||
 		_currentState == State::MENU_MODE_END ||
+		_currentState == State::SEARCH_MODE ||
 		_currentState == State::ENTER_MASTER_PASSWORD)
 	{
 		_setState(State::PASSIVE_MODE);
@@ -418,35 +564,105 @@ void TildaLogic::_processMenuMode()
 			_switchMenuMode();
 			_setState(State::PASSIVE_MODE);
 		}
-		else if (newPoint.compare(currentPoint) != 0) {
-			_packageFactory.generateClearSequence(currentPoint.length());
-			_packageFactory.processData(newPoint);
+		else if (_currentState == State::MENU_MODE) {
+			_packageFactory.replaceData(currentPoint, newPoint);
 		}
 	}
-	// TODO: place it into separate class, into Menu (probably)
-//	else if (key != UsbKey::NOT_A_KEY) { // in search mode
-//		_setState(State::SEARCH_MODE);
-//	}
+	else if (key != UsbKey::NOT_A_KEY) {
+		_startSearchMode();
+	}
+}
+
+void TildaLogic::_startSearchMode()
+{
+	_keysBuffer.resize(0);
+	_lastKeysBufferLen = 0;
+	_keyboardInput.reset();
+	_searchIndex.reset();
+	_matcher.reset();
+	_searchResult = 0;
+
+	_setState(State::SEARCH_MODE);
+	_processSearchMode();
+}
+
+void TildaLogic::_processSearchMode()
+{
+	Key key {
+		_inputPackagePtr->key[0],
+		_inputPackagePtr->special
+	};
+
+	if (key == UsbKey::KEY_TAB) {
+		_nextSearchResult();
+		return;
+	}
+
+	// Control keys work with the found point as in menu
+	if (key.isControl()) {
+		_setState(State::MENU_MODE);
+		_processMenuMode();
+		return;
+	}
+
+	_keyboardInput.process(_inputPackagePtr);
+
+	if (_keysBuffer.size() != _lastKeysBufferLen) {
+		_lastKeysBufferLen = _keysBuffer.size();
+		_searchMode();
+	}
 }
 
 void TildaLogic::_searchMode()
+{
+	if (_keysBuffer.empty()) {
+		return;
+	}
+
+	// Prefix of title or username is found by the sorted index,
+	// fuzzy matcher scans entries only when no prefix matches.
+	// Last found point stays if nothing matches at all.
+	_isPrefixResult =
+			_searchIndex.search(_keysBuffer.data(), _keysBuffer.size());
+
+	if (_isPrefixResult == false &&
+		_matcher.search(_keysBuffer.data(), _keysBuffer.size()) == 0)
+	{
+		return;
+	}
+
+	_searchResult = 0;
+	_showSearchResult();
+}
+
+void TildaLogic::_nextSearchResult()
+{
+	size_t count = (_isPrefixResult ?
+			_searchIndex.getMatchesCount() : _matcher.getResultsCount());
+
+	if (count > 1) {
+		_searchResult = (_searchResult + 1) % count;
+		_showSearchResult();
+	}
+}
+
+DB::EntryStore::NodeId TildaLogic::_getSearchResult(size_t num)
+{
+	return (_isPrefixResult ?
+			_searchIndex.getMatch(num) : _matcher.getResult(num));
+}
+
+void TildaLogic::_showSearchResult()
 {
 	StringFieldConst currentPoint =
 			_menu.getCurrentPointContainer().getName();
 
-	size_t pos = _menu.search(
-			StringField(_keysBuffer.data(), _keysBuffer.size())
-		);
+	_menuLevel.moveTo(_getSearchResult(_searchResult));
 
 	StringFieldConst& newPoint =
 			_menu.getCurrentPointContainer().getName();
 
-	bool pointChanged = newPoint.compare(currentPoint);
-
-	if (pos != StringField::npos && pointChanged) {
-		_packageFactory.generateClearSequence(currentPoint.length());
-		_packageFactory.processData(newPoint);
-	}
+	_packageFactory.replaceData(currentPoint, newPoint);
 }
 
 const char* TildaLogic::_getDbErrorType()
@@ -474,6 +690,18 @@ const char* TildaLogic::_getDbErrorType()
 			return Strings::SIGNATURE_ERROR;
 		break;
 
+		case DecryptionResult::XML_ERROR:
+			return Strings::XML_ERROR;
+		break;
+
+		case DecryptionResult::COMPRESSION_ERROR:
+			return Strings::COMPRESSION_ERROR;
+		break;
+
+		case DecryptionResult::INNER_STREAM_ERROR:
+			return Strings::INNER_STREAM_ERROR;
+		break;
+
 		default:
 			return Strings::PASSWORD_WRONG;
 		break;
@@ -504,6 +732,11 @@ namespace Private {
 
 	void FixedMenuCallbacks::exit(TildaLogic::CallbackArg arg)
 	{
+		// Explicit lock, cached key is forgotten too
+		_logic->_searchIndex.clear();
+		_logic->_matcher.clear();
+		_logic->_keepassReader.lock();
+
 		_logic->_setState(TildaLogic::State::MENU_MODE_END);
 	}
 }
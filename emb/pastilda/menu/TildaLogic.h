@@ -28,13 +28,17 @@
 #include <cstring>
 #include <etl/vector.h>
 
-#include <usb_deque.h>
+#include <usb_ring.h>
 #include <keys/Key.h>
 #include <keepass/keepass_reader.h>
 #include <database/DbEntry.h>
 #include <database/xmltree/XmlTree.h>
+#include <database/searchindex/FuzzyMatcher.h>
+#include <database/searchindex/SearchIndex.h>
 #include <KeyboardLikeInput.hpp>
 #include <Menu.hpp>
+#include <LevelCursor.h>
+#include <AutoType.h>
 #include <UsbPackageFactory.h>
 
 using std::size_t;
@@ -52,6 +56,10 @@ namespace Private {
 		// Messages
 		static constexpr const char* PASSWORD_WRONG = "Failed!\0";
 		static constexpr const char* GREETING_TO_WRITE = "Pass:\0";
+		static constexpr const char* GREETING_QUICK_UNLOCK = "PIN:\0";
+		static constexpr const char* GREETING_NEW_PIN = "New PIN:\0";
+		static constexpr const char* PIN_LENGTH_ERROR = "PIN length error!\0";
+		static constexpr const char* SEQUENCE_ERROR = "Auto-Type error!\0";
 		static constexpr const char* PASSWORD_SYMB = "*\0";
 		// Menu point's names
 		static constexpr const char* SETTINGS_POINT = "Settings\0";
@@ -60,6 +68,11 @@ namespace Private {
 		// Login/password types
 		static constexpr const uint8_t* FORM = (const uint8_t*)"FORM\0";
 		static constexpr const uint8_t* CONSOLE = (const uint8_t*)"CONSOLE\0";
+		// Auto-Type sequences of login types
+		static constexpr const uint8_t* FORM_SEQUENCE =
+				(const uint8_t*)"{USERNAME}{TAB}{PASSWORD}{ENTER}\0";
+		static constexpr const uint8_t* CONSOLE_SEQUENCE =
+				(const uint8_t*)"{USERNAME}{ENTER}{DELAY 800}{PASSWORD}{ENTER}\0";
 		// Database states
 		static constexpr const char* SUCCESS = "Success!\0";
 		static constexpr const char* SIGNATURE_ERROR = "Signature error!\0";
@@ -67,6 +80,9 @@ namespace Private {
 		static constexpr const char* CREDENTIALS_ERROR = "Credentials error!\0";
 		static constexpr const char* DB_FILE_ERROR = "Db file error!\0";
 		static constexpr const char* DATA_HASH_ERROR = "Data hash error!\0";
+		static constexpr const char* XML_ERROR = "Xml error!\0";
+		static constexpr const char* COMPRESSION_ERROR = "Compression error!\0";
+		static constexpr const char* INNER_STREAM_ERROR = "Inner stream error!\0";
 	};
 
 	static constexpr size_t KEYS_BUFFER_SIZE = 128;
@@ -86,14 +102,11 @@ public:
 	typedef DataT* DataBuffer;
 	typedef const DataT* DataBufferConst;
 
-	constexpr static size_t MAX_MENU_POINTS_COUNT = 100;
-	using MenuT = Menu<MAX_MENU_POINTS_COUNT>;
+	using MenuT = Menu<LevelCursor>;
+	using FixedTreeT = LevelCursor::FixedTreeT;
 
-	constexpr static size_t MAX_TREE_NODES_COUNT = MenuT::COUNT_OF_POINTS;
-	using MenuTreeT = Tree<MAX_TREE_NODES_COUNT, MenuT::ContainerT>;
-
-	using CallbackT = MenuT::TreeT::TreeNodeT::CallbackT;
-	using CallbackArg = MenuT::TreeT::TreeNodeT::CallbackArg;
+	using CallbackT = LevelCursor::CallbackT;
+	using CallbackArg = LevelCursor::CallbackArg;
 
 	using KeyBuffer = etl::vector<AsciiCodeType, Private::KEYS_BUFFER_SIZE>;
 
@@ -103,8 +116,10 @@ public:
 		MENU_MODE,
 		MENU_MODE_END,
 		ENTER_MASTER_PASSWORD,
-		MASTER_PASSWORD_PASSED,
-		SEARCH_MODE
+		ENTER_NEW_PIN,
+		DB_DECRYPTING,
+		SEARCH_MODE,
+		AUTO_TYPE
 	};
 
 	struct SpecialPoints {
@@ -116,15 +131,39 @@ public:
 		MenuT::PointDescr<CallbackT> exit;
 	};
 
+	struct UnlockStats {
+		uint32_t lastFullUnlockMs;
+		uint32_t lastQuickUnlockMs;
+		uint32_t quickUnlocksCount;
+	};
+
 	static constexpr const char* KEEPASS_BASE_FILE = "db.kdb";
 	static constexpr UsbKey TILDA_MODE_KEY = UsbKey::KEY_GRAVE_ACCENT_AND_TILDE;
 
 	// Constructors
-	TildaLogic(UsbDequeStandart* deque, const SpecialPoints& specialPoints);
+	TildaLogic(UsbRingStandart* ring, const SpecialPoints& specialPoints);
 	~TildaLogic();
 
 	// Public methods
 	void process(DataBufferConst inputData, size_t length);
+	void poll();
+
+	bool isUnlocking() const {
+		return (_currentState == State::DB_DECRYPTING);
+	}
+
+	uint8_t getUnlockProgress() {
+		return _keepassReader.get_progress();
+	}
+
+	// Called while the payload is parsed, input is only redirected then
+	void setUnlockYieldCallback(const fd::FastDelegate0<>& callback) {
+		_keepassReader.set_yield_callback(callback);
+	}
+
+	const UnlockStats& getUnlockStats() const {
+		return _unlockStats;
+	}
 
 private:
 	SpecialPoints _specialMenuPoints;
@@ -142,7 +181,8 @@ private:
 	size_t _inputDataLength;
 	UsbPackageConst* _inputPackagePtr;
 
-	MenuTreeT _menuTree;
+	FixedTreeT _fixedTree;
+	LevelCursor _menuLevel;
 	MenuT _menu;
 
 	PackageFactory _packageFactory;
@@ -152,37 +192,59 @@ private:
 	size_t _lastKeysBufferLen;
 	KeyboardLikeInput<KeyBuffer> _keyboardInput;
 
+	AutoTypeProgram _autoTypeProgram;
+	AutoTypeRunner _autoType;
+
 	KeepAss::KeePassReader _keepassReader;
 	DB::XmlTree _db;
+	DB::SearchIndex _searchIndex;
+	DB::FuzzyMatcher _matcher;
+	size_t _searchResult;
+	bool _isPrefixResult;
 	KeepAss::DecryptionResult _dbState;
+	UnlockStats _unlockStats;
+	uint32_t _unlockStartMs;
+	bool _isSealingPin;
+	const char* _greeting;
 
 	TildaLogic(const TildaLogic&);
 
 	void _init();
-	void _buildTree(uint32_t index);
-	void _buildMenuTree();
 	void _buildMenu();
 	void _buildFixedMenu();
 	template<typename T> void _addMenuPoint(T& point);
-	void _copyDbContainer(uint32_t index);
 
 	void _dbDecrypt(const char* passwd, size_t len);
+	void _checkDbState();
 
 	void _setState(State state) {
 		_currentState = state;
 	}
 
 	void _logInCallback(MenuT::ContainerT& container);
+	bool _revealPassword(const MenuT::ContainerT& container, size_t position,
+						 uint8_t* buffer, size_t size, size_t* length);
 
 	void _processMasterPassword();
+	void _processNewPin();
+	void _startNewPin();
+	void _processHiddenInput();
+	void _clearHiddenInput();
 	void _processMenuMode();
+	void _processAutoType();
 	const char* _getDbErrorType();
 
 	void _checkMode();
 	void _switchMenuMode();
 	void _sendMenuGreeting();
+	void _selectGreeting();
 
+	void _startSearchMode();
+	void _processSearchMode();
 	void _searchMode();
+	void _nextSearchResult();
+	void _showSearchResult();
+	DB::EntryStore::NodeId _getSearchResult(size_t num);
 
 	void _redirectInput();
 	void _sendMsg(const char* msg);
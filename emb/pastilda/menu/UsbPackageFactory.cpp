@@ -27,7 +27,7 @@
 
 #include <keys/Key.h>
 
-#include <usb_deque.h>
+#include <usb_ring.h>
 #include <UsbPackageFactory.h>
 
 using std::size_t;
@@ -36,21 +36,11 @@ using namespace Keys;
 namespace UsbPackages {
 
 PackageFactory::PackageFactory() :
-	_packageDeque(new PackageDeque()),
-	_inputData(nullptr),
-	_inputDataLength(0),
-	_currentPackage(nullptr),
-	_currentPackageFieldNum(0),
-	_lastKey(UsbKey::NOT_A_KEY)
+	_packageRing(new PackageRing())
 { }
 
-PackageFactory::PackageFactory(PackageDeque* deque) :
-	_packageDeque(deque),
-	_inputData(nullptr),
-	_inputDataLength(0),
-	_currentPackage(nullptr),
-	_currentPackageFieldNum(0),
-	_lastKey(UsbKey::NOT_A_KEY)
+PackageFactory::PackageFactory(PackageRing* ring) :
+	_packageRing(ring)
 { }
 
 
@@ -59,194 +49,106 @@ PackageFactory::~PackageFactory()
 
 void PackageFactory::generatePackage(InputDataConst inputData)
 {
-	_packageDeque->unlock();
-		auto inputPackage = reinterpret_cast<UsbPackageConst*>(inputData);
-		_packageDeque->push_back(*inputPackage);
-	_packageDeque->lock();
+	auto inputPackage = reinterpret_cast<UsbPackageConst*>(inputData);
+	_packageRing->push_back().setPackage(*inputPackage);
+	_packageRing->commit();
 }
 
 void PackageFactory::generateClearSequence()
 {
-	_addEmptyPackage();
-	_addClearPackage();
-	_addEmptyPackage();
+	Key aKey(UsbKey::KEY_A, UsbSpecialKey::LEFT_CTRL);
+	Key deleteKey(UsbKey::KEY_DELETE);
+
+	_addKey(aKey, 1);
+	_addKey(deleteKey, 1);
+	_packageRing->commit();
 }
 
 void PackageFactory::generateClearSequence(size_t count)
 {
-	Key backspaceKey(UsbKey::KEY_BACKSPACE);
-
-	_addEmptyPackage();
-	for (size_t i = 0; i < count; ++i) {
-		_addSimplePackage(backspaceKey);
-	}
-	_addEmptyPackage();
+	generateKeyPackage(UsbKey::KEY_BACKSPACE, count);
 }
 
 void PackageFactory::generateTabPackage()
 {
-	_addEmptyPackage();
-
-	Key tabKey(UsbKey::KEY_TAB);
-	_addSimplePackage(tabKey);
-
-	_addEmptyPackage();
+	generateKeyPackage(UsbKey::KEY_TAB, 1);
 }
 
 void PackageFactory::generateEnterPackage()
 {
-	_addEmptyPackage();
+	generateKeyPackage(UsbKey::KEY_ENTER, 1);
+}
 
-	Key enterKey(UsbKey::KEY_ENTER);
-	_addSimplePackage(enterKey);
+void PackageFactory::generateKeyPackage(UsbKey usbKey, size_t count)
+{
+	Key key(usbKey);
 
-	_addEmptyPackage();
+	_addKey(key, count);
+	_packageRing->commit();
 }
 
 void PackageFactory::generateEmptyPackage()
 {
-	_addEmptyPackage();
+	_packageRing->push_back().setPackage(ZERO_PACKAGE);
+	_packageRing->commit();
 }
 
-void PackageFactory::_addClearPackage()
+void PackageFactory::cancel()
 {
-	Key aKey(UsbKey::KEY_A, UsbSpecialKey::LEFT_CTRL);
-	Key deleteKey(UsbKey::KEY_DELETE);
-
-	_addEmptyPackage();
-	_addSimplePackage(aKey);
-	_addEmptyPackage();
-	_addSimplePackage(deleteKey);
-	_addEmptyPackage();
+	_packageRing->cancel();
 }
 
 void PackageFactory::processData(const basic_string_view<uint8_t>& inputData)
 {
-	_inputDataLength = inputData.length();
-	_inputData = reinterpret_cast<InputDataConst>(inputData.data());
-	_processInputData();
+	_addText(reinterpret_cast<InputDataConst>(inputData.data()),
+			 inputData.length());
+	_packageRing->commit();
 }
 
 void PackageFactory::processData(InputDataConst inputData,
 		                         size_t inputDataLength)
 {
-	_inputDataLength = inputDataLength;
-	_inputData = inputData;
-	_processInputData();
+	_addText(inputData, inputDataLength);
+	_packageRing->commit();
 }
 
 void PackageFactory::processData(const char* inputData,
 		                         size_t inputDataLength)
 {
-	_inputDataLength = inputDataLength;
-	_inputData = reinterpret_cast<InputDataConst>(inputData);
-	_processInputData();
-}
-
-void PackageFactory::_processInputData()
-{
-	for (size_t iSymbol = 0; iSymbol < _inputDataLength; iSymbol++) {
-		Key key(_inputData[iSymbol]);
-
-		if (key.isShifted()) {
-			_addShiftedPackage(key);
-		}
-		else {
-			_addSimplePackage(key);
-		}
-	}
-	_addEmptyPackage();
-}
-
-inline void PackageFactory::_completeLastSimplePackage()
-{
-	bool lastPackageNotCompleted = (_currentPackageFieldNum > 0);
-	if (lastPackageNotCompleted) {
-		_currentPackageFieldNum = 0;
-		_packageDeque->lock();
-	}
+	_addText(reinterpret_cast<InputDataConst>(inputData), inputDataLength);
+	_packageRing->commit();
 }
 
-void PackageFactory::_addEmptyPackage()
+void PackageFactory::replaceData(const basic_string_view<uint8_t>& oldData,
+								 const basic_string_view<uint8_t>& newData)
 {
-	_completeLastSimplePackage();
-
-	bool dequeWasLocked = _packageDeque->isLocked();
-	_packageDeque->unlock();
+	// Common beginning is already typed, only tails are changed
+	size_t commonLength = 0;
+	while (commonLength < oldData.length() &&
+		   commonLength < newData.length() &&
+		   oldData[commonLength] == newData[commonLength])
 	{
-		_packageDeque->push_back();
-
-		UsbPackage& currentPackage = _packageDeque->back();
-
-		currentPackage.clear();
+		commonLength++;
 	}
-	if (dequeWasLocked) {       // if deque was locked before adding empty package,
-		_packageDeque->lock();  // then lock it, otherwise it's something
-	}							// need deque unlocked (e.g. simple package)
-}
-
-void PackageFactory::_addShiftedPackage(Key& key)
-{
-	_packageDeque->unlock();
-	{
-		_addEmptyPackage();  // clear last key
-		_addEmptyPackage();  // add new empty package
-
-		UsbPackage& currentPackage = _packageDeque->back();
 
-		currentPackage.special = key.getUsbKeyModifier();
-		currentPackage.key[0] = key.getUsbKey();
+	if (oldData.length() > commonLength) {
+		generateClearSequence(oldData.length() - commonLength);
 	}
-	_packageDeque->lock();
-}
 
-void PackageFactory::_addSimplePackage(Key& key)
-{
-	// If in one package will be two same keys one
-	// by one, then the only one will be send. So we
-	// should split package if we have this situation.
-	if (_currentPackageFieldNum == 0 || key == _lastKey) {
-		_newSimplePackage(key);
+	if (newData.length() > commonLength) {
+		processData(newData.data() + commonLength,
+					newData.length() - commonLength);
 	}
-	else {
-		_continueSimplePackage(key);
-	}
-
-	_lastKey = key;
-	_checkSimplePackageEnd();
 }
 
-void PackageFactory::_continueSimplePackage(Key& key)
+void PackageFactory::_addText(InputDataConst inputData, size_t inputDataLength)
 {
-	_currentPackageFieldNum++;
-	size_t currentKeyNum =
-			_currentPackageFieldNum - USB_PACKAGE_SPECIAL_FIELDS_LENGTH;
-
-	UsbPackage& currentPackage = _packageDeque->back();
-	currentPackage.key[currentKeyNum] = key.getUsbKey();
-}
-
-void PackageFactory::_newSimplePackage(Key& key)
-{
-	_packageDeque->unlock();
-
-	_addEmptyPackage();  // clear last key
-	_addEmptyPackage();  // add new empty package
-
-	UsbPackage& currentPackage = _packageDeque->back();
-	currentPackage.special = key.getUsbKeyModifier();
-	currentPackage.reserved = _EMPTY_FIELD;
-	currentPackage.key[0] = key.getUsbKey();
-
-	_currentPackageFieldNum = 2;  // last set field
+	_packageRing->push_back().setText(inputData, inputDataLength);
 }
 
-void PackageFactory::_checkSimplePackageEnd()
+void PackageFactory::_addKey(const Key& key, size_t count)
 {
-	if (_currentPackageFieldNum == USB_PACKAGE_LENGTH - 6) {  // USB_PACKAGE_LENGTH - 5 = 2,
-		_completeLastSimplePackage();						  // what means, that there will be
-	}														  // only one key per package,
-															  // otherwise linux don't work
+	_packageRing->push_back().setKey(key, count);
 }
 
 } /* namespace UsbPackages */
@@ -29,7 +29,7 @@
 #include <string>
 #include <experimental/string_view>
 
-#include <usb_deque.h>
+#include <usb_ring.h>
 #include <keys/Key.h>
 
 using std::experimental::basic_string_view;
@@ -43,46 +43,38 @@ class PackageFactory {
 public:
 	typedef const AsciiCodeType* InputDataConst;
 	typedef UsbRawData* OutputData;
-	using PackageDeque = UsbDequeStandart;
+	using PackageRing = UsbRingStandart;
 
 	PackageFactory();
-	PackageFactory(PackageDeque* deque);
+	PackageFactory(PackageRing* ring);
 	~PackageFactory();
 
+	// Text is typed lazily, so it must live until it's typed
+	// (short text is copied, see TypingJob)
 	void processData(InputDataConst inputData, size_t inputDataLength);
 	void processData(const basic_string_view<uint8_t>& inputData);
 	void processData(const char* inputData, size_t inputDataLength);
+	void replaceData(const basic_string_view<uint8_t>& oldData,
+					 const basic_string_view<uint8_t>& newData);
 	void generateClearSequence();
 	void generateClearSequence(size_t count);
 	void generateEmptyPackage();
 	void generateTabPackage();
 	void generateEnterPackage();
+	void generateKeyPackage(UsbKey usbKey, size_t count);
 	void generatePackage(InputDataConst inputData);
+	// Reports which aren't sent yet are dropped, held keys are released
+	void cancel();
 
-private:
-	constexpr static UsbRawData _EMPTY_FIELD = 0;
-
-	PackageDeque* _packageDeque;
-
-	InputDataConst _inputData;
-	size_t _inputDataLength;
-
-	UsbPackage* _currentPackage;
-	size_t _currentPackageFieldNum;
+	bool isIdle() const {
+		return _packageRing->isIdle();
+	}
 
-	Key _lastKey;
-
-	void _processInputData();
-
-	void _addEmptyPackage();
-	void _addClearPackage();
-	void _addShiftedPackage(Key& key);
+private:
+	PackageRing* _packageRing;
 
-	void _addSimplePackage(Key& key);
-	void _continueSimplePackage(Key& key);
-	void _newSimplePackage(Key& key);
-	void _checkSimplePackageEnd();
-	void _completeLastSimplePackage();
+	void _addText(InputDataConst inputData, size_t inputDataLength);
+	void _addKey(const Key& key, size_t count);
 };
 
 } /* namespace UsbPackages */
@@ -25,33 +25,40 @@
 #ifndef TREE_H_
 #define TREE_H_
 
-#include <string>
-#include <functional>
-
-#include <etl/pool.h>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 
 #include <TreeNode.hpp>
 
+// Nodes are kept in the tree itself and linked by 16-bit indexes,
+// callbacks are kept in a small table and nodes refer to them by id
 template <std::size_t size, typename T>
 class Tree {
 public:
 	static constexpr std::size_t NODES_COUNT = size;
+	static constexpr std::size_t CALLBACKS_COUNT = 8;
 
 	using TreeNodeT = TreeNode<T>;
 	using TreeNodePtr = TreeNode<T>*;
+	using NodeId = typename TreeNodeT::NodeId;
+	using CallbackId = typename TreeNodeT::CallbackId;
 
 	using ContainerT = typename TreeNodeT::Container;
 	using CallbackT = typename TreeNodeT::CallbackT;
 	using CallbackArg = typename TreeNodeT::CallbackArg;
 
-	using PoolType = etl::pool<TreeNodeT, NODES_COUNT>;
-	using PoolPtr = PoolType*;
+	static_assert(NODES_COUNT < TreeNodeT::NO_NODE,
+				  "Nodes count doesn't fit into node id");
 
 	Tree();
-	Tree(TreeNodePtr node, PoolPtr pool);
 	virtual ~Tree();
 
-	size_t getCurrentChildNum();
+	size_t getCurrentChildNum() {
+		return _nodes[_currentNode].getPosition();
+	}
+
+	size_t getChildrenCount();
 
 	void addChild(const CallbackT callback,
 			      const CallbackArg container);
@@ -60,6 +67,10 @@ public:
 		      	     const CallbackArg container);
 	void addNeighbor(const CallbackT callback = &TreeNodeT::EMPTY_CALLBACK);
 
+	// False if the callbacks table is full, the node keeps its old callback
+	bool setCallback(const CallbackT& callback);
+	void call();
+
 	void moveLeft();
 	void moveRight();
 	void moveInto();
@@ -70,69 +81,67 @@ public:
 	void moveMostLeft();
 
 	bool isMostLeft() {
-		return (_currentNode->getLeftNeighbor() == nullptr);
+		return (_nodes[_currentNode].getLeftNeighbor() == TreeNodeT::NO_NODE);
 	}
 
 	bool isMostRight() {
-		return (_currentNode->getRightNeighbor() == nullptr);
+		return (_nodes[_currentNode].getRightNeighbor() == TreeNodeT::NO_NODE);
 	}
 
 	bool isMostTop() {
-		return (_currentNode->getParent() == nullptr);
+		return (_nodes[_currentNode].getParent() == TreeNodeT::NO_NODE);
 	}
 
 	bool isMostBottom() {
-		return (_currentNode->isEndNode());
+		return (_nodes[_currentNode].isEndNode());
 	}
 
 	TreeNodePtr getCurrentNode() {
-		return _currentNode;
+		return &_nodes[_currentNode];
 	}
 
 	bool isFull() {
-		return _pool->full();
+		return (_nodesCount == NODES_COUNT);
 	}
 
 	void destroy();
 
 private:
-	PoolPtr _pool;
-	TreeNodePtr _currentNode;
+	static constexpr NodeId FIRST_TOP_NODE = 0;  // it's made by destroy()
+	static constexpr CallbackId NO_CALLBACK = CALLBACKS_COUNT;
 
-	void _destroyNode(TreeNodePtr node);
-	void _destroyTree(TreeNodePtr tree);
-};
+	TreeNodeT _nodes[NODES_COUNT];
+	CallbackT _callbacks[CALLBACKS_COUNT];
 
-template <std::size_t size, typename T>
-Tree<size, T>::Tree() :
-	_pool(new PoolType()),
-	_currentNode(_pool->allocate())
-{ }
+	NodeId _nodesCount;
+	NodeId _currentNode;
+	NodeId _lastTopNode;  // top nodes have no parent to keep the tail
+	CallbackId _callbacksCount;
+
+	NodeId _allocate(const CallbackT& callback);
+	void _link(NodeId parent, NodeId node);
+	CallbackId _findCallback(const CallbackT& callback);
+};
 
 template <std::size_t size, typename T>
-Tree<size, T>::Tree(TreeNodePtr node, PoolPtr pool) :
-	_pool(pool),
-	_currentNode(node)
-{ }
+Tree<size, T>::Tree()
+{
+	destroy();
+}
 
 template <std::size_t size, typename T>
 Tree<size, T>::~Tree()
 { }
 
 template<std::size_t size, typename T>
-size_t Tree<size, T>::getCurrentChildNum()
+size_t Tree<size, T>::getChildrenCount()
 {
-	TreeNodePtr node = _currentNode;
-	size_t childNum = node->getParent()->getChildrenCount();
-
-	while (node != nullptr) {
-		childNum--;
-		node = node->getLeftNeighbor();
+	NodeId lastChild = _nodes[_currentNode].getLastChild();
+	if (lastChild == TreeNodeT::NO_NODE) {
+		return 0;
 	}
 
-	childNum = _currentNode->getParent()->getChildrenCount() - childNum - 1;
-
-	return childNum;
+	return (_nodes[lastChild].getPosition() + 1);
 }
 
 template<std::size_t size, typename T>
@@ -140,11 +149,10 @@ void Tree<size, T>::addChild(const CallbackT callback,
 					  	  	 const CallbackArg container)
 {
 	if (this->isFull() == false) {
-		TreeNodePtr child = _pool->allocate();
-		child->setCallback(callback);
-		child->setContainer(container);
+		NodeId child = _allocate(callback);
+		_nodes[child].setContainer(container);
 
-		_currentNode->addChild(child);
+		_link(_currentNode, child);
 	}
 }
 
@@ -152,10 +160,9 @@ template<std::size_t size, typename T>
 void Tree<size, T>::addChild(const CallbackT callback)
 {
 	if (this->isFull() == false) {
-		TreeNodePtr child = _pool->allocate();
-		child->setCallback(callback);
+		NodeId child = _allocate(callback);
 
-		_currentNode->addChild(child);
+		_link(_currentNode, child);
 	}
 }
 
@@ -164,11 +171,10 @@ void Tree<size, T>::addNeighbor(const CallbackT callback,
 							    const CallbackArg container)
 {
 	if (this->isFull() == false) {
-		TreeNodePtr neighbor = _pool->allocate();
-		neighbor->setCallback(callback);
-		neighbor->setContainer(container);
+		NodeId neighbor = _allocate(callback);
+		_nodes[neighbor].setContainer(container);
 
-		_currentNode->addRightNeighbor(neighbor);
+		_link(_nodes[_currentNode].getParent(), neighbor);
 	}
 }
 
@@ -176,19 +182,36 @@ template<std::size_t size, typename T>
 void Tree<size, T>::addNeighbor(const CallbackT callback)
 {
 	if (this->isFull() == false) {
-		TreeNodePtr neighbor = _pool->allocate();
-		neighbor->setCallback(callback);
+		NodeId neighbor = _allocate(callback);
 
-		_currentNode->addRightNeighbor(neighbor);
+		_link(_nodes[_currentNode].getParent(), neighbor);
 	}
 }
 
+template<std::size_t size, typename T>
+bool Tree<size, T>::setCallback(const CallbackT& callback)
+{
+	CallbackId id = _findCallback(callback);
+	if (id == NO_CALLBACK) {
+		return false;
+	}
+
+	_nodes[_currentNode]._callback = id;
+	return true;
+}
+
+template<std::size_t size, typename T>
+void Tree<size, T>::call()
+{
+	TreeNodeT& node = _nodes[_currentNode];
+	_callbacks[node._callback](node.getContainer());
+}
 
 template<std::size_t size, typename T>
 void Tree<size, T>::moveLeft()
 {
 	if (this->isMostLeft() == false) {
-		_currentNode = _currentNode->getLeftNeighbor();
+		_currentNode = _nodes[_currentNode].getLeftNeighbor();
 	}
 }
 
@@ -196,15 +219,15 @@ template<std::size_t size, typename T>
 void Tree<size, T>::moveRight()
 {
 	if (this->isMostRight() == false) {
-		_currentNode = _currentNode->getRightNeighbor();
+		_currentNode = _nodes[_currentNode].getRightNeighbor();
 	}
 }
 
 template<std::size_t size, typename T>
 void Tree<size, T>::moveInto()
 {
-	if (_currentNode->isEndNode() == false) {
-		_currentNode = _currentNode->getChildAt(0);
+	if (this->isMostBottom() == false) {
+		_currentNode = _nodes[_currentNode].getFirstChild();
 	}
 }
 
@@ -212,15 +235,21 @@ template<std::size_t size, typename T>
 void Tree<size, T>::moveOut()
 {
 	if (this->isMostTop() == false) {
-		_currentNode = _currentNode->getParent();
+		_currentNode = _nodes[_currentNode].getParent();
 	}
 }
 
 template<std::size_t size, typename T>
 void Tree<size, T>::destroy()
 {
-	_pool->release_all();
-	_currentNode = _pool->allocate();
+	_callbacks[TreeNodeT::EMPTY_CALLBACK_ID] = &TreeNodeT::EMPTY_CALLBACK;
+	_callbacksCount = 1;
+
+	_nodesCount = 0;
+	_lastTopNode = TreeNodeT::NO_NODE;
+
+	_currentNode = _allocate(&TreeNodeT::EMPTY_CALLBACK);
+	_link(TreeNodeT::NO_NODE, _currentNode);
 }
 
 template<std::size_t size, typename T>
@@ -234,39 +263,73 @@ void Tree<size, T>::moveInHead()
 template<std::size_t size, typename T>
 void Tree<size, T>::moveMostRight()
 {
-	while (isMostRight() == false) {
-		moveRight();
-	}
+	NodeId parent = _nodes[_currentNode].getParent();
+	_currentNode = (parent == TreeNodeT::NO_NODE) ?
+			_lastTopNode : _nodes[parent].getLastChild();
 }
 
 template<std::size_t size, typename T>
 void Tree<size, T>::moveMostLeft()
 {
-	while (isMostLeft() == false) {
-		moveLeft();
-	}
+	NodeId parent = _nodes[_currentNode].getParent();
+	_currentNode = (parent == TreeNodeT::NO_NODE) ?
+			FIRST_TOP_NODE : _nodes[parent].getFirstChild();
 }
 
 template<std::size_t size, typename T>
-void Tree<size, T>::_destroyTree(TreeNodePtr tree)
+auto Tree<size, T>::_allocate(const CallbackT& callback) -> NodeId
 {
-	const std::size_t CHILDREN_COUNT = tree->getChildrenCount();
-	for (std::size_t i = 0; i < CHILDREN_COUNT; ++i) {
-		TreeNodePtr child = tree->getChildAt(CHILDREN_COUNT - i - 1);
-		if (child->isEndNode()) {
-			_destroyNode(child);
-		}
-		else {
-			_destroyTree(child);
+	NodeId node = _nodesCount++;
+
+	_nodes[node] = TreeNodeT();
+	CallbackId id = _findCallback(callback);
+	_nodes[node]._callback = ((id == NO_CALLBACK) ? TreeNodeT::EMPTY_CALLBACK_ID : id);
+
+	return node;
+}
+
+template<std::size_t size, typename T>
+void Tree<size, T>::_link(NodeId parent, NodeId node)
+{
+	// New node is always the last one, so it's linked to the tail
+	NodeId& tail = (parent == TreeNodeT::NO_NODE) ?
+			_lastTopNode : _nodes[parent]._lastChild;
+	TreeNodeT& newNode = _nodes[node];
+
+	newNode._parent = parent;
+
+	if (tail == TreeNodeT::NO_NODE) {
+		if (parent != TreeNodeT::NO_NODE) {
+			_nodes[parent]._firstChild = node;
 		}
+		newNode._position = 0;
 	}
-	_destroyNode(tree);
+	else {
+		_nodes[tail]._rightNeighbor = node;
+		newNode._leftNeighbor = tail;
+		newNode._position = _nodes[tail]._position + 1;
+	}
+
+	tail = node;
 }
 
 template<std::size_t size, typename T>
-void Tree<size, T>::_destroyNode(TreeNodePtr node)
+auto Tree<size, T>::_findCallback(const CallbackT& callback) -> CallbackId
 {
-	destroyTreeNode(node);
+	for (CallbackId i = 0; i < _callbacksCount; ++i) {
+		if (_callbacks[i] == callback) {
+			return i;
+		}
+	}
+
+	// Every distinct callback takes a slot, more of them is a bug
+	if (_callbacksCount == CALLBACKS_COUNT) {
+		assert(!"Tree callbacks table is full, raise CALLBACKS_COUNT");
+		return NO_CALLBACK;
+	}
+
+	_callbacks[_callbacksCount] = callback;
+	return _callbacksCount++;
 }
 
 #endif /* TREE_H_ */
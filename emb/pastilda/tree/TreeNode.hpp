@@ -25,201 +25,100 @@
 #ifndef TREE_TREENODE_HPP_
 #define TREE_TREENODE_HPP_
 
-#include <string>
-#include <functional>
+#include <cstddef>
+#include <cstdint>
 
-#include <etl/vector.h>
 #include <FastDelegate.h>
 
-constexpr size_t MAX_CHILDREN_COUNT = 5;
-
 namespace fd = fastdelegate;
 
+template<std::size_t size, typename T>
+class Tree;
+
 template<typename T>
 class TreeNode {
 public:
-	using TreeNodePtr = TreeNode*;
+	// Nodes are linked by their indexes in the tree array
+	using NodeId = uint16_t;
+	using CallbackId = uint8_t;
 	using Container = T;
 
 	using CallbackArg = Container&;
 	using CallbackT = fd::FastDelegate1<CallbackArg>;
 
+	static constexpr NodeId NO_NODE = UINT16_MAX;
+	static constexpr CallbackId EMPTY_CALLBACK_ID = 0;
+
 	static void EMPTY_CALLBACK(CallbackArg) {
 		return;
 	}
 
 	TreeNode();
-	TreeNode(std::string name, TreeNodePtr parent);
-	~TreeNode();
 
 	void setContainer(const Container& container) {
 		_container = container;
 	}
 
-	void setCallback(const CallbackT& callback) {
-		_callback = callback;
-	}
-
-	void call() {
-		_callback(_container);
-	}
-
 	Container& getContainer() {
 		return _container;
 	}
 
-	void setParent(TreeNodePtr parent) {
-		_parent = parent;
-	}
-
-	TreeNodePtr getParent() {
+	NodeId getParent() const {
 		return _parent;
 	}
 
-	void addChild(TreeNodePtr child);
-	TreeNodePtr getChildAt(const std::size_t i) const;
-
-	std::size_t getChildrenCount() {
-		return _childrenCount;
+	NodeId getFirstChild() const {
+		return _firstChild;
 	}
 
-	bool isEndNode() const {
-		return (_children == nullptr);
+	NodeId getLastChild() const {
+		return _lastChild;
 	}
 
-	void addLeftNeighbor(TreeNodePtr neighbor);
-	void addRightNeighbor(TreeNodePtr neighbor);
-
-	TreeNodePtr getLeftNeighbor() const {
+	NodeId getLeftNeighbor() const {
 		return _leftNeighbor;
 	}
 
-	TreeNodePtr getRightNeighbor() const {
+	NodeId getRightNeighbor() const {
 		return _rightNeighbor;
 	}
 
-	friend void destroyTreeNode(TreeNode* node)
-	{
-		node->setParent(nullptr);
-		node->_setRightNeighbor(nullptr);
-		node->_setLeftNeighbor(nullptr);
-		node->_children = nullptr;
-		node->_childrenCount = 0;
+	// Position among neighbors, it's set when node is added
+	std::size_t getPosition() const {
+		return _position;
 	}
 
-protected:
-	Container _container;
-    CallbackT _callback;
-
-	TreeNodePtr _parent;
-	std::size_t _childrenCount;
-	TreeNodePtr _children;
-	TreeNodePtr _leftNeighbor;
-	TreeNodePtr _rightNeighbor;
-
-	void _addFirstChild(TreeNodePtr child);
-	void _setLeftNeighbor(TreeNodePtr neighbor);
-	void _setRightNeighbor(TreeNodePtr neighbor);
-};
-
-template<typename T>
-TreeNode<T>::TreeNode():
-	_callback(EMPTY_CALLBACK),
-	_parent(nullptr),
-	_childrenCount(0),
-	_children(nullptr),
-	_leftNeighbor(nullptr),
-	_rightNeighbor(nullptr)
-{ }
-
-template<typename T>
-TreeNode<T>::TreeNode(std::string name, TreeNodePtr parent):
-	_callback(EMPTY_CALLBACK),
-	_parent(parent),
-	_childrenCount(0),
-	_children(nullptr),
-	_leftNeighbor(nullptr),
-	_rightNeighbor(nullptr)
-{ }
-
-template<typename T>
-TreeNode<T>::~TreeNode()
-{
-	destroyTreeNode(this);
-}
-
-template<typename T>
-inline void TreeNode<T>::_addFirstChild(TreeNodePtr child)
-{
-	_children = child;
-}
-
-template<typename T>
-void TreeNode<T>::addChild(TreeNodePtr child)
-{
-	_childrenCount++;
-
-	child->setParent(this);
-
-	if (_childrenCount == 1) {
-		_addFirstChild(child);
-	}
-	else {
-		_children->addRightNeighbor(child);
+	bool isEndNode() const {
+		return (_firstChild == NO_NODE);
 	}
-}
 
-template<typename T>
-void TreeNode<T>::addLeftNeighbor(TreeNodePtr neighbor)
-{
-	if (_leftNeighbor == nullptr) {
-		_leftNeighbor = neighbor;
-		neighbor->_setRightNeighbor(this);
-	}
-	else {
-		_leftNeighbor->addLeftNeighbor(neighbor);
-	}
-}
+private:
+	template<std::size_t size, typename U>
+	friend class Tree;
 
-template<typename T>
-void TreeNode<T>::addRightNeighbor(TreeNodePtr neighbor)
-{
-	if (_rightNeighbor == nullptr) {
-		_rightNeighbor = neighbor;
-		neighbor->_setLeftNeighbor(this);
-	}
-	else {
-		_rightNeighbor->addRightNeighbor(neighbor);
-	}
-}
+	Container _container;
 
-template<typename T>
-inline void TreeNode<T>::_setLeftNeighbor(TreeNodePtr neighbor)
-{
-	_leftNeighbor = neighbor;
-}
+	NodeId _parent;
+	NodeId _firstChild;
+	NodeId _lastChild;
+	NodeId _leftNeighbor;
+	NodeId _rightNeighbor;
+	NodeId _position;
+	CallbackId _callback;
+};
 
 template<typename T>
-inline void TreeNode<T>::_setRightNeighbor(TreeNodePtr neighbor)
-{
-	_rightNeighbor = neighbor;
-}
+constexpr typename TreeNode<T>::NodeId TreeNode<T>::NO_NODE;
 
 template<typename T>
-typename TreeNode<T>::TreeNodePtr TreeNode<T>::getChildAt(const std::size_t childNum) const
-{
-	if (this->isEndNode()) {
-		return nullptr;
-	}
-
-	std::size_t i = 0;
-	TreeNodePtr child = _children;
-	while (i < childNum) {
-		child = child->getRightNeighbor();
-		++i;
-	}
-
-	return child;
-}
+TreeNode<T>::TreeNode():
+	_parent(NO_NODE),
+	_firstChild(NO_NODE),
+	_lastChild(NO_NODE),
+	_leftNeighbor(NO_NODE),
+	_rightNeighbor(NO_NODE),
+	_position(0),
+	_callback(EMPTY_CALLBACK_ID)
+{ }
 
 #endif /* TREE_TREENODE_HPP_ */
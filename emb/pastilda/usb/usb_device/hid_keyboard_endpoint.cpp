@@ -0,0 +1,139 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <typing_profile.h>
+#include <hid_keyboard_endpoint.h>
+
+namespace UsbPackages {
+
+HidKeyboardEndpoint::HidKeyboardEndpoint(UsbRingStandart* ring,
+										 const SendCallback& send,
+										 uint32_t pollIntervalMs) :
+	_ring(ring),
+	_send(send),
+	_scheduler(pollIntervalMs),
+	_pacer(pollIntervalMs),
+	_lastPackage(ZERO_PACKAGE),
+	_isLastBitmap(false),
+	_isReleasePending(false)
+{ }
+
+void HidKeyboardEndpoint::reset()
+{
+	_scheduler.complete();
+	_pacer.reset();
+}
+
+void HidKeyboardEndpoint::complete()
+{
+	_scheduler.complete();
+}
+
+void HidKeyboardEndpoint::process(uint32_t nowMs, uint8_t idleRate, uint8_t leds,
+								  bool isReportProtocol)
+{
+	_scheduler.setIdleRate(idleRate);
+
+	// Scroll Lock isn't pressed over keys the user holds
+	if (CURRENT_TYPING_PROFILE.isPaced && _ring->empty() && _lastPackage == ZERO_PACKAGE) {
+		_pacer.finish(nowMs, leds);
+	}
+
+	// Canceled job may leave its keys held, an empty report releases them
+	if (_ring->dropCanceled()) {
+		_isReleasePending = true;
+	}
+
+	bool hasNewReport = (!_ring->empty() || _pacer.hasProbe() || _isReleasePending);
+
+	// Only committed jobs are seen here, the next report of the front
+	// job is made when the current one is sent. When there is nothing
+	// new the endpoint NAKs until the kick or host's idle period is over.
+	switch (_scheduler.schedule(hasNewReport, nowMs)) {
+		case HidReportScheduler::Action::SEND_NEW:
+			_sendNew(nowMs, leds, isReportProtocol);
+		break;
+
+		case HidReportScheduler::Action::SEND_LAST:
+			if (_send(_lastPackage, _isLastBitmap) != 0) {
+				_scheduler.sent(nowMs);
+			}
+		break;
+
+		case HidReportScheduler::Action::NONE:
+		break;
+	}
+}
+
+void HidKeyboardEndpoint::_sendNew(uint32_t nowMs, uint8_t leds, bool isReportProtocol)
+{
+	if (_isReleasePending) {
+		if (_send(ZERO_PACKAGE, _isLastBitmap) != 0) {
+			_lastPackage = ZERO_PACKAGE;
+			_isReleasePending = false;
+
+			_scheduler.sent(nowMs);
+		}
+		return;
+	}
+
+	if (_pacer.hasProbe()) {
+		if (_send(_pacer.getProbe(), false) != 0) {
+			_lastPackage = _pacer.getProbe();
+			_isLastBitmap = false;
+
+			_scheduler.sent(nowMs);
+			_pacer.probeSent(nowMs);
+		}
+		return;
+	}
+
+	TypingJob& job = _ring->front();
+
+	// Only typing is paced, user's keys are passed through at once.
+	// Endpoint NAKs until host acknowledges the chunk, the main loop kicks it
+	bool isPaced = CURRENT_TYPING_PROFILE.isPaced &&
+				   job.getKind() != TypingJob::Kind::PACKAGE;
+	if (isPaced && _pacer.isReady(nowMs, leds) == false) {
+		return;
+	}
+
+	_lastPackage = job.getPackage();
+	_isLastBitmap = job.isBitmap();
+
+	if (_send(_lastPackage, _isLastBitmap) != 0) {
+		_scheduler.sent(nowMs);
+
+		if (isPaced) {
+			_pacer.reportSent(nowMs, _lastPackage, leds);
+		}
+
+		job.next(isReportProtocol);
+		if (job.isDone()) {
+			_ring->pop_front();
+		}
+	}
+}
+
+} /* namespace UsbPackages */
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_HID_KEYBOARD_ENDPOINT_H_
+#define USB_USB_DEVICE_HID_KEYBOARD_ENDPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <FastDelegate.h>
+
+#include <usb_ring.h>
+#include <hid_report_scheduler.h>
+#include <hid_typing_pacer.h>
+
+namespace UsbPackages {
+
+// Keyboard IN endpoint side of the typing ring, run by the endpoint
+// interrupt and by the kick of the main loop. It decides with the
+// scheduler whether a report is written, takes the report from the
+// front job, the pacer's probe or the release of canceled jobs, and
+// writes it through the send callback. USB state is passed in, so it
+// runs on the host as well.
+class HidKeyboardEndpoint
+{
+public:
+	// Report is written to the endpoint, zero is returned if it's busy
+	using SendCallback = fastdelegate::FastDelegate2<const UsbPackage&, bool, uint16_t>;
+
+	HidKeyboardEndpoint(UsbRingStandart* ring, const SendCallback& send,
+						uint32_t pollIntervalMs);
+
+	// Endpoint is configured again
+	void reset();
+	// Endpoint has sent the report
+	void complete();
+	void process(uint32_t nowMs, uint8_t idleRate, uint8_t leds, bool isReportProtocol);
+
+	const HidReportStats& getStats() const {
+		return (_scheduler.getStats());
+	}
+
+	const HidTypingPacer& getPacer() const {
+		return (_pacer);
+	}
+
+private:
+	UsbRingStandart* _ring;
+	SendCallback _send;
+
+	HidReportScheduler _scheduler;
+	HidTypingPacer _pacer;
+
+	UsbPackage _lastPackage;
+	bool _isLastBitmap;
+	bool _isReleasePending;
+
+	void _sendNew(uint32_t nowMs, uint8_t leds, bool isReportProtocol);
+};
+
+} /* namespace UsbPackages */
+
+#endif /* USB_USB_DEVICE_HID_KEYBOARD_ENDPOINT_H_ */
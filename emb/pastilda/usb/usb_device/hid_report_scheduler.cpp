@@ -0,0 +1,81 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <hid_report_scheduler.h>
+
+namespace UsbPackages {
+
+HidReportScheduler::HidReportScheduler(uint32_t pollIntervalMs) :
+	_pollIntervalMs(pollIntervalMs),
+	_idlePeriodMs(0),
+	_isBusy(false),
+	_isNaking(false),
+	_lastSentMs(0),
+	_nakStartMs(0),
+	_stats({0, 0, 0})
+{ }
+
+void HidReportScheduler::complete()
+{
+	_isBusy = false;
+}
+
+HidReportScheduler::Action HidReportScheduler::schedule(bool hasNewReport,
+														 uint32_t nowMs)
+{
+	if (_isBusy) {
+		return (Action::NONE);  // it's scheduled again on completion
+	}
+
+	if (hasNewReport) {
+		return (Action::SEND_NEW);
+	}
+
+	bool isIdleOver = (_idlePeriodMs != 0) &&
+					  (nowMs - _lastSentMs >= _idlePeriodMs);
+	if (isIdleOver) {
+		return (Action::SEND_LAST);
+	}
+
+	if (_isNaking == false) {
+		_isNaking = true;
+		_nakStartMs = nowMs;
+		_stats.nakIntervalsCount++;
+	}
+	return (Action::NONE);
+}
+
+void HidReportScheduler::sent(uint32_t nowMs)
+{
+	if (_isNaking) {
+		_isNaking = false;
+		_stats.suppressedCount += (nowMs - _nakStartMs) / _pollIntervalMs;
+	}
+
+	_isBusy = true;
+	_lastSentMs = nowMs;
+	_stats.sentCount++;
+}
+
+} /* namespace UsbPackages */
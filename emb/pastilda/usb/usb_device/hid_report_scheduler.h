@@ -0,0 +1,91 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_HID_REPORT_SCHEDULER_H_
+#define USB_USB_DEVICE_HID_REPORT_SCHEDULER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+using std::size_t;
+
+namespace UsbPackages {
+
+struct HidReportStats
+{
+	uint32_t sentCount;
+	uint32_t suppressedCount;     // duplicates host polled while NAKed,
+	                              // added when NAK interval is over
+	uint32_t nakIntervalsCount;
+};
+
+// Decides what HID IN endpoint sends: a new report, the last one when
+// host's idle period is over, or nothing, so the endpoint NAKs until
+// it's kicked. Idle rate is in 4 ms units (SET_IDLE), 0 means infinity.
+class HidReportScheduler
+{
+public:
+	static constexpr uint32_t IDLE_RATE_UNIT_MS = 4;
+
+	enum class Action : uint8_t {
+		NONE,
+		SEND_NEW,
+		SEND_LAST
+	};
+
+	HidReportScheduler(uint32_t pollIntervalMs);
+
+	void setIdleRate(uint8_t idleRate) {
+		_idlePeriodMs = idleRate * IDLE_RATE_UNIT_MS;
+	}
+
+	// Endpoint has sent the report
+	void complete();
+	Action schedule(bool hasNewReport, uint32_t nowMs);
+	// Report is written to the endpoint
+	void sent(uint32_t nowMs);
+
+	bool isBusy() const {
+		return (_isBusy);
+	}
+
+	const HidReportStats& getStats() const {
+		return (_stats);
+	}
+
+private:
+	uint32_t _pollIntervalMs;
+	uint32_t _idlePeriodMs;
+
+	bool _isBusy;
+	bool _isNaking;
+	uint32_t _lastSentMs;
+	uint32_t _nakStartMs;
+
+	HidReportStats _stats;
+};
+
+} /* namespace UsbPackages */
+
+#endif /* USB_USB_DEVICE_HID_REPORT_SCHEDULER_H_ */
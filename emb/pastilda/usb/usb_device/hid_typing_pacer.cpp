@@ -0,0 +1,193 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <hid_typing_pacer.h>
+
+namespace UsbPackages {
+
+HidTypingPacer::HidTypingPacer(uint32_t pollIntervalMs) :
+	_pollIntervalMs(pollIntervalMs),
+	_state(State::TYPING),
+	_gapMs(0),
+	_lastReportMs(0),
+	_chunkStartMs(0),
+	_chunkReportsCount(0),
+	_chunkSize(MIN_CHUNK_REPORTS_COUNT),
+	_probedReportsCount(0),
+	_expectedLed(0),
+	_userLed(0),
+	_isUserLedKnown(false),
+	_isRetried(false),
+	_probeSentMs(0),
+	_probe(ZERO_PACKAGE)
+{ }
+
+void HidTypingPacer::reset()
+{
+	_state = State::TYPING;
+	_gapMs = 0;
+	_chunkReportsCount = 0;
+	_chunkSize = MIN_CHUNK_REPORTS_COUNT;
+	_isUserLedKnown = false;
+	_isRetried = false;
+}
+
+bool HidTypingPacer::isReady(uint32_t nowMs, uint8_t leds)
+{
+	if (_isAcknowledged(nowMs, leds) == false || hasProbe()) {
+		return (false);
+	}
+
+	return (nowMs - _lastReportMs >= _gapMs);
+}
+
+void HidTypingPacer::reportSent(uint32_t nowMs, const UsbPackage& package,
+								uint8_t leds)
+{
+	if (_chunkReportsCount == 0) {
+		_chunkStartMs = nowMs;
+	}
+	_lastReportMs = nowMs;
+	_chunkReportsCount++;
+
+	// Scroll Lock is pressed only when all keys are released
+	bool isReleased = (package == ZERO_PACKAGE);
+	if (isReleased && _chunkReportsCount >= _chunkSize) {
+		_startProbe(leds);
+	}
+}
+
+void HidTypingPacer::finish(uint32_t nowMs, uint8_t leds)
+{
+	if (_isAcknowledged(nowMs, leds) == false ||
+		_state != State::TYPING || _isUserLedKnown == false)
+	{
+		return;
+	}
+
+	if ((leds & SCROLL_LOCK_LED) != _userLed) {
+		_startProbe(leds);
+	}
+	else {
+		// Next typing starts with a short chunk again
+		_isUserLedKnown = false;
+		_chunkReportsCount = 0;
+	}
+}
+
+void HidTypingPacer::probeSent(uint32_t nowMs)
+{
+	if (_state == State::PROBE_PRESS) {
+		_probe.clear();
+		_state = State::PROBE_RELEASE;
+	}
+	else if (_state == State::PROBE_RELEASE) {
+		_probeSentMs = nowMs;
+		_lastReportMs = nowMs;
+		_state = State::WAITING_ACK;
+	}
+}
+
+bool HidTypingPacer::_isAcknowledged(uint32_t nowMs, uint8_t leds)
+{
+	if (_state != State::WAITING_ACK) {
+		return (true);
+	}
+
+	uint32_t lagMs = nowMs - _probeSentMs;
+
+	if ((leds & SCROLL_LOCK_LED) == _expectedLed) {
+		// Probe which restores Scroll Lock has no chunk before it
+		bool hasChunk = (_probedReportsCount > 2);
+		_adapt(lagMs, hasChunk ? (nowMs - _chunkStartMs) / _probedReportsCount : lagMs / 2);
+		_isRetried = false;
+		_state = State::TYPING;
+		return (true);
+	}
+
+	if (lagMs < ACK_TIMEOUT_MS) {
+		return (false);
+	}
+
+	// Host may drop the probe when its queue is full, it has been
+	// drained by now, so the probe is repeated once with a short chunk
+	if (_isRetried == false) {
+		_isRetried = true;
+		_chunkSize = MIN_CHUNK_REPORTS_COUNT;
+		_state = State::TYPING;
+		_startProbe(leds);
+		return (false);
+	}
+
+	_state = State::DISABLED;
+	return (true);
+}
+
+void HidTypingPacer::_startProbe(uint8_t leds)
+{
+	if (_state != State::TYPING) {
+		return;
+	}
+
+	if (_isUserLedKnown == false) {
+		_userLed = leds & SCROLL_LOCK_LED;
+		_isUserLedKnown = true;
+	}
+
+	// Press and release of the probe are handled after the chunk
+	_probedReportsCount = _chunkReportsCount + 2;
+	_chunkReportsCount = 0;
+	_expectedLed = (leds & SCROLL_LOCK_LED) ^ SCROLL_LOCK_LED;
+
+	_probe.clear();
+	_probe.key[0] = UsbKey::KEY_SCROLL_LOCK;
+	_state = State::PROBE_PRESS;
+}
+
+void HidTypingPacer::_adapt(uint32_t lagMs, uint32_t hostGapMs)
+{
+	// Host that keeps up handles the probe in a few polls after the
+	// last report, a longer lag means it has been handling the chunk
+	// all the time, so its pace over the chunk is the gap
+	uint32_t reportMs = (_gapMs > _pollIntervalMs) ? _gapMs : _pollIntervalMs;
+	uint32_t lagLimitMs = 2 * reportMs + 4 * _pollIntervalMs;
+
+	if (lagMs > lagLimitMs) {
+		_gapMs = (hostGapMs > _gapMs) ? hostGapMs : _gapMs + 1;
+		if (_gapMs > MAX_GAP_MS) {
+			_gapMs = MAX_GAP_MS;
+		}
+
+		_chunkSize = (_chunkSize > 2 * MIN_CHUNK_REPORTS_COUNT) ?
+					 _chunkSize / 2 : MIN_CHUNK_REPORTS_COUNT;
+	}
+	else {
+		_gapMs = (_gapMs * 3) / 4;
+
+		_chunkSize = (_chunkSize < MAX_CHUNK_REPORTS_COUNT / 2) ?
+					 _chunkSize * 2 : MAX_CHUNK_REPORTS_COUNT;
+	}
+}
+
+} /* namespace UsbPackages */
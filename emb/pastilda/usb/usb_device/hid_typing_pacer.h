@@ -0,0 +1,118 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_HID_TYPING_PACER_H_
+#define USB_USB_DEVICE_HID_TYPING_PACER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <usb_package.h>
+
+using std::size_t;
+
+namespace UsbPackages {
+
+// Flow control by host's LEDs: after a chunk of typed reports Scroll
+// Lock is toggled and typing waits until host sets the LED (SET_REPORT),
+// so it has handled all keys before. User's passthrough reports aren't
+// paced nor counted. The chunk starts short and grows while host
+// answers soon after the probe. A lagging host gets a shorter chunk and
+// the gap between reports it has managed over the chunk, the gap decays
+// when host keeps up.
+// User's Scroll Lock state is restored at the end. A lost probe is
+// repeated once, then pacing is turned off for the session.
+class HidTypingPacer
+{
+public:
+	static constexpr uint8_t SCROLL_LOCK_LED = 0x04;
+
+	static constexpr size_t MIN_CHUNK_REPORTS_COUNT = 4;
+	static constexpr size_t MAX_CHUNK_REPORTS_COUNT = 32;
+	static constexpr uint32_t ACK_TIMEOUT_MS = 1000;
+	static constexpr uint32_t MAX_GAP_MS = 200;
+
+	HidTypingPacer(uint32_t pollIntervalMs);
+
+	void reset();
+
+	// Typed report may be sent now
+	bool isReady(uint32_t nowMs, uint8_t leds);
+	void reportSent(uint32_t nowMs, const UsbPackage& package, uint8_t leds);
+	// Nothing to type, Scroll Lock is restored if it's needed
+	void finish(uint32_t nowMs, uint8_t leds);
+
+	bool hasProbe() const {
+		return (_state == State::PROBE_PRESS || _state == State::PROBE_RELEASE);
+	}
+
+	const UsbPackage& getProbe() const {
+		return (_probe);
+	}
+
+	void probeSent(uint32_t nowMs);
+
+	uint32_t getGap() const {
+		return (_gapMs);
+	}
+
+	bool isEnabled() const {
+		return (_state != State::DISABLED);
+	}
+
+private:
+	enum class State : uint8_t {
+		TYPING,
+		PROBE_PRESS,
+		PROBE_RELEASE,
+		WAITING_ACK,
+		DISABLED
+	};
+
+	uint32_t _pollIntervalMs;
+	State _state;
+
+	uint32_t _gapMs;
+	uint32_t _lastReportMs;
+	uint32_t _chunkStartMs;
+	size_t _chunkReportsCount;
+	size_t _chunkSize;
+	size_t _probedReportsCount;  // reports host handles before the ack
+
+	uint8_t _expectedLed;
+	uint8_t _userLed;
+	bool _isUserLedKnown;
+	bool _isRetried;
+	uint32_t _probeSentMs;
+
+	UsbPackage _probe;
+
+	bool _isAcknowledged(uint32_t nowMs, uint8_t leds);
+	void _startProbe(uint8_t leds);
+	void _adapt(uint32_t lagMs, uint32_t hostGapMs);
+};
+
+} /* namespace UsbPackages */
+
+#endif /* USB_USB_DEVICE_HID_TYPING_PACER_H_ */
@@ -0,0 +1,173 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include <typing_job.h>
+
+namespace UsbPackages {
+
+TypingJob::TypingJob() :
+	_kind(Kind::PACKAGE),
+	_text(nullptr),
+	_cursor(0),
+	_count(0),
+	_isPress(false),
+	_isDone(true),
+	_isBitmap(false),
+	_key(UsbKey::NOT_A_KEY),
+	_package(ZERO_PACKAGE)
+{ }
+
+void TypingJob::setPackage(const UsbPackage& package)
+{
+	_start(Kind::PACKAGE, 0);
+	_package = package;
+}
+
+void TypingJob::setText(const AsciiCodeType* text, size_t length)
+{
+	if (length <= INLINE_TEXT_LENGTH) {
+		memcpy(_inlineText, text, length);
+		text = _inlineText;
+	}
+
+	_text = text;
+	_start(Kind::TEXT, length);
+}
+
+void TypingJob::setKey(const Key& key, size_t count)
+{
+	_key = key;
+	_start(Kind::KEY, count);
+}
+
+void TypingJob::next(bool isBitmap)
+{
+	// Passthrough reports are sent as they are
+	_isBitmap = HAS_BITMAP_REPORT && isBitmap && (_kind != Kind::PACKAGE);
+
+	if (_isPress && _isBitmap && _cursor < _count &&
+		_isFollowing(_getNextKey(), _package))
+	{
+		UsbPackage held = _package;
+		_makePress(held);  // old keys are released by the same report
+	}
+	else if (_isPress) {
+		_isPress = false;
+		_package.clear();  // all keys of the report are released together
+	}
+	else if (_cursor < _count) {
+		_isPress = true;
+		_makePress(ZERO_PACKAGE);
+	}
+	else {
+		_isDone = true;
+	}
+}
+
+void TypingJob::_start(Kind kind, size_t count)
+{
+	_kind = kind;
+	_cursor = 0;
+	_count = count;
+	_isPress = false;
+	_isDone = false;
+	_isBitmap = false;
+	_package.clear();
+}
+
+void TypingJob::_makePress(const UsbPackage& held)
+{
+	_key = _getNextKey();
+
+	_package.clear();
+	_package.special = _key.getUsbKeyModifier();
+	_package.key[0] = _key.getUsbKey();
+	_cursor++;
+
+	// Same key is pressed once per report only, so repeated keys
+	// are never packed
+	if (_kind != Kind::TEXT) {
+		return;
+	}
+
+	for (size_t i = 1; i < KEYS_PER_REPORT && _cursor < _count; i++) {
+		Key key(_text[_cursor]);
+		if (_isPacked(key, i, held) == false) {
+			return;
+		}
+
+		_package.key[i] = key.getUsbKey();
+		_cursor++;
+	}
+}
+
+Key TypingJob::_getNextKey() const
+{
+	return ((_kind == Kind::TEXT) ? Key(_text[_cursor]) : _key);
+}
+
+bool TypingJob::_isFollowing(const Key& key, const UsbPackage& package) const
+{
+	// Modifiers are common for all keys of the report, they are changed
+	// only by the empty report to be sure they aren't applied to keys
+	// of the previous report
+	if (key.getUsbKeyModifier().getMask() != package.special.getMask()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < USB_PACKAGE_KEY_FIELDS_LENGTH; i++) {
+		if (package.key[i] == key.getUsbKey()) {
+			return false;  // held key isn't pressed again
+		}
+	}
+	return true;
+}
+
+bool TypingJob::_isPacked(const Key& key, size_t keysCount,
+						  const UsbPackage& held) const
+{
+	if (_isFollowing(key, _package) == false) {
+		return false;
+	}
+
+	if (_isBitmap == false) {
+		return true;
+	}
+
+	// Bitmap keys are handled by host in usage order
+	if (key.getUsbKey() <= _package.key[keysCount - 1]) {
+		return false;
+	}
+
+	for (size_t i = 0; i < USB_PACKAGE_KEY_FIELDS_LENGTH; i++) {
+		if (held.key[i] == key.getUsbKey()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} /* namespace UsbPackages */
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_TYPING_JOB_H_
+#define USB_USB_DEVICE_TYPING_JOB_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <keys/Key.h>
+#include <usb_package.h>
+#include <typing_profile.h>
+
+using namespace Keys;
+using std::size_t;
+
+namespace UsbPackages {
+
+// Something to type, expanded into reports lazily: the current report
+// is made only when the previous one is sent, so memory doesn't depend
+// on text length. Text and keys are typed as [release, press] pairs
+// followed by the final release. A press report holds up to
+// keysPerReport keys of the typing profile, they are released together.
+// Bitmap report (report protocol of NKRO profile) holds them in usage
+// order, as host handles them, and the release is skipped when no key
+// is held.
+class TypingJob
+{
+public:
+	static constexpr size_t INLINE_TEXT_LENGTH = 8;
+
+	enum class Kind : uint8_t {
+		PACKAGE,
+		TEXT,
+		KEY
+	};
+
+	TypingJob();
+
+	void setPackage(const UsbPackage& package);
+	// Short text is copied, a longer one must live until it's typed
+	void setText(const AsciiCodeType* text, size_t length);
+	void setKey(const Key& key, size_t count);
+
+	Kind getKind() const {
+		return (_kind);
+	}
+
+	const UsbPackage& getPackage() const {
+		return (_package);
+	}
+
+	void next(bool isBitmap);
+
+	bool isBitmap() const {
+		return (_isBitmap);
+	}
+
+	bool isDone() const {
+		return (_isDone);
+	}
+
+private:
+	static constexpr size_t KEYS_PER_REPORT = CURRENT_TYPING_PROFILE.keysPerReport;
+	static constexpr bool HAS_BITMAP_REPORT = CURRENT_TYPING_PROFILE.hasBitmapReport;
+
+	static_assert(KEYS_PER_REPORT >= 1 && KEYS_PER_REPORT <= USB_PACKAGE_KEY_FIELDS_LENGTH,
+				  "Wrong keys per report count");
+
+	Kind _kind;
+
+	const AsciiCodeType* _text;
+	uint32_t _cursor;  // next key to press
+	uint32_t _count;
+
+	bool _isPress;
+	bool _isDone;
+	bool _isBitmap;
+
+	Key _key;
+	UsbPackage _package;
+	AsciiCodeType _inlineText[INLINE_TEXT_LENGTH];
+
+	void _start(Kind kind, size_t count);
+	void _makePress(const UsbPackage& held);
+	Key _getNextKey() const;
+	bool _isFollowing(const Key& key, const UsbPackage& package) const;
+	bool _isPacked(const Key& key, size_t keysCount, const UsbPackage& held) const;
+};
+
+} /* namespace UsbPackages */
+
+#endif /* USB_USB_DEVICE_TYPING_JOB_H_ */
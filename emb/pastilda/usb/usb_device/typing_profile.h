@@ -0,0 +1,83 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_TYPING_PROFILE_H_
+#define USB_USB_DEVICE_TYPING_PROFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Typing profile is chosen at compile time, e.g. -DTYPING_PROFILE=1
+//  CONSERVATIVE: one key per report, host polls each 16 ms, works everywhere
+//  PACKED:       up to 6 distinct keys with the same modifiers per report,
+//                host must handle keys of one report in their order
+//  TUNED:        one key per report, host polls each 4 ms
+//  PACED:        as TUNED, but typing is paced by host's LEDs feedback
+//                (see HidTypingPacer), for remote desktops and slow forms
+//  NKRO:         as PACKED with 4 ms polling, in report protocol typing
+//                goes by N-key rollover bitmap reports. Descriptor gets
+//                report IDs then, which some KVMs don't pass through
+#define TYPING_PROFILE_CONSERVATIVE  0
+#define TYPING_PROFILE_PACKED        1
+#define TYPING_PROFILE_TUNED         2
+#define TYPING_PROFILE_PACED         3
+#define TYPING_PROFILE_NKRO          4
+
+#ifndef TYPING_PROFILE
+#define TYPING_PROFILE TYPING_PROFILE_CONSERVATIVE
+#endif
+
+// Report descriptor is chosen by the preprocessor
+#define TYPING_HAS_BITMAP_REPORT (TYPING_PROFILE == TYPING_PROFILE_NKRO)
+
+namespace UsbPackages {
+
+struct TypingProfile
+{
+	size_t keysPerReport;
+	uint8_t pollInterval;  // HID endpoint bInterval, ms
+	bool isPaced;
+	bool hasBitmapReport;  // report protocol typing by bitmap reports
+};
+
+static constexpr TypingProfile TYPING_PROFILES[] =
+{
+		{1, 0x10, false, false},  // CONSERVATIVE
+		{6, 0x10, false, false},  // PACKED
+		{1, 0x04, false, false},  // TUNED
+		{1, 0x04, true,  false},  // PACED
+		{6, 0x04, false, true}    // NKRO
+};
+
+static_assert(TYPING_PROFILE < sizeof(TYPING_PROFILES) / sizeof(TYPING_PROFILES[0]),
+			  "Unknown typing profile");
+
+static constexpr TypingProfile CURRENT_TYPING_PROFILE = TYPING_PROFILES[TYPING_PROFILE];
+
+static_assert(CURRENT_TYPING_PROFILE.hasBitmapReport == TYPING_HAS_BITMAP_REPORT,
+			  "Bitmap report and descriptor don't match");
+
+} /* namespace UsbPackages */
+
+#endif /* USB_USB_DEVICE_TYPING_PROFILE_H_ */
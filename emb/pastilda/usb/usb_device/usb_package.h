@@ -83,6 +83,67 @@ static UsbPackageConst ZERO_PACKAGE = {{USB_EMPTY_FIELD}, USB_EMPTY_FIELD,
 		UsbKey::NOT_A_KEY, UsbKey::NOT_A_KEY, UsbKey::NOT_A_KEY,
 		UsbKey::NOT_A_KEY, UsbKey::NOT_A_KEY, UsbKey::NOT_A_KEY};
 
+// In report protocol every report starts with its ID
+enum UsbReportId : UsbRawData {
+	BOOT_KEYBOARD   = 1,
+	BITMAP_KEYBOARD = 2
+};
+
+constexpr static size_t USB_BITMAP_KEYS_LENGTH = 16;  // usages 0x00 - 0x7F
+
+#pragma pack(push, 1)
+struct UsbBootReport
+{
+	UsbRawData id;
+	UsbPackage package;
+
+	UsbBootReport(const UsbPackage& bootPackage) :
+		id(UsbReportId::BOOT_KEYBOARD),
+		package(bootPackage)
+	{ }
+
+	const UsbRawData* data() const {
+		return reinterpret_cast<const UsbRawData*>(this);
+	}
+
+	constexpr size_t length() const {
+		return sizeof(UsbBootReport);
+	}
+};
+
+// N-key rollover report: one bit per key, so keys are released
+// and pressed by one report
+struct UsbBitmapReport
+{
+	UsbRawData id;
+	UsbSpecialKeySequence special;
+	UsbRawData keys[USB_BITMAP_KEYS_LENGTH];
+
+	UsbBitmapReport(const UsbPackage& bootPackage) :
+		id(UsbReportId::BITMAP_KEYBOARD),
+		special(bootPackage.special)
+	{
+		memset(keys, USB_EMPTY_FIELD, USB_BITMAP_KEYS_LENGTH);
+
+		for (size_t i = 0; i < USB_PACKAGE_KEY_FIELDS_LENGTH; i++) {
+			size_t usage = static_cast<size_t>(bootPackage.key[i]);
+
+			if (usage != 0 && usage < USB_BITMAP_KEYS_LENGTH * 8) {
+				keys[usage / 8] |= (1 << (usage % 8));
+			}
+		}
+	}
+
+	const UsbRawData* data() const {
+		return reinterpret_cast<const UsbRawData*>(this);
+	}
+
+	constexpr size_t length() const {
+		return sizeof(UsbBitmapReport);
+	}
+};
+#pragma pack(pop)
+
 } // namespace UsbPackage
 
 #endif /* USB_USB_DEVICE_USB_PACKAGE_H_ */
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USB_USB_DEVICE_USB_RING_H_
+#define USB_USB_DEVICE_USB_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+#include <FastDelegate.h>
+
+#include <keys/Key.h>
+#include <typing_job.h>
+
+using namespace Keys;
+using std::size_t;
+
+namespace UsbPackages {
+
+// Single producer, single consumer ring of typing jobs. The producer
+// (PackageFactory in the main loop) reserves and fills jobs, then
+// commits the whole group. The consumer (HID endpoint interrupt)
+// sees committed jobs only and expands the front one report by report.
+// A group that doesn't fit is dropped entirely, so a half of sequence
+// is never sent. Consumer is kicked by the commit callback.
+// Committed jobs are canceled by the producer too: the consumer drops
+// them on its next run, including the one it has started.
+template <typename T, size_t USB_RING_SIZE>
+class UsbRing
+{
+public:
+	static constexpr size_t SIZE = USB_RING_SIZE;
+
+	using CommitCallback = fastdelegate::FastDelegate0<>;
+
+	static_assert((SIZE & (SIZE - 1)) == 0, "Ring size must be a power of 2");
+
+	UsbRing() :
+		_read(0),
+		_commit(0),
+		_write(0),
+		_cancel(0),
+		_isOverflowed(false),
+		_highWaterMark(0),
+		_overflowsCount(0)
+	{ }
+
+	// Producer side
+	T& push_back() {
+		uint32_t used = _write - _read.load(std::memory_order_acquire);
+
+		if (_isOverflowed || used == SIZE) {
+			_isOverflowed = true;
+			return _overflowItem;  // it's dropped by commit()
+		}
+
+		T& item = _items[_write & MASK];
+		_write++;
+
+		if (used + 1 > _highWaterMark) {
+			_highWaterMark = used + 1;
+		}
+		return item;
+	}
+
+	T& back() {
+		return (_isOverflowed ? _overflowItem : _items[(_write - 1) & MASK]);
+	}
+
+	void commit() {
+		uint32_t commit = _commit.load(std::memory_order_relaxed);
+
+		if (_isOverflowed) {
+			_write = commit;
+			_isOverflowed = false;
+			_overflowsCount++;
+			return;
+		}
+
+		_commit.store(_write, std::memory_order_release);
+
+		if (_commitCallback) {
+			_commitCallback();
+		}
+	}
+
+	// All committed jobs are dropped, nothing may be reserved
+	void cancel() {
+		_cancel.store(_commit.load(std::memory_order_relaxed),
+					  std::memory_order_release);
+
+		if (_commitCallback) {
+			_commitCallback();
+		}
+	}
+
+	void setCommitCallback(const CommitCallback& callback) {
+		_commitCallback = callback;
+	}
+
+	// Jobs which can be reserved now, consumer may free more
+	size_t getFreeCount() const {
+		return (SIZE - (_write - _read.load(std::memory_order_acquire)));
+	}
+
+	// All reserved jobs are done
+	bool isIdle() const {
+		return (_read.load(std::memory_order_acquire) == _write);
+	}
+
+	size_t getHighWaterMark() const {
+		return _highWaterMark;
+	}
+
+	size_t getOverflowsCount() const {
+		return _overflowsCount;
+	}
+
+	// Consumer side
+	bool empty() const {
+		return (_read.load(std::memory_order_relaxed) ==
+				_commit.load(std::memory_order_acquire));
+	}
+
+	T& front() {
+		return _items[_read.load(std::memory_order_relaxed) & MASK];
+	}
+
+	void pop_front() {
+		uint32_t read = _read.load(std::memory_order_relaxed);
+		_read.store(read + 1, std::memory_order_release);
+	}
+
+	// True if canceled jobs were dropped, keys of the front one may be held
+	bool dropCanceled() {
+		uint32_t cancel = _cancel.load(std::memory_order_acquire);
+		uint32_t read = _read.load(std::memory_order_relaxed);
+
+		if ((int32_t)(cancel - read) <= 0) {
+			return false;
+		}
+
+		_read.store(cancel, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static constexpr uint32_t MASK = SIZE - 1;
+
+	T _items[SIZE];
+	T _overflowItem;
+
+	std::atomic<uint32_t> _read;    // written by consumer only
+	std::atomic<uint32_t> _commit;  // written by producer only
+	uint32_t _write;                // producer's reserved end
+	std::atomic<uint32_t> _cancel;  // written by producer only
+
+	bool _isOverflowed;
+	size_t _highWaterMark;
+	size_t _overflowsCount;
+
+	CommitCallback _commitCallback;
+};
+
+
+static constexpr size_t USB_RING_STANDART_SIZE = 64;
+using UsbRingStandart = UsbRing<TypingJob, USB_RING_STANDART_SIZE>;
+
+} /* namespace UsbPackages */
+
+
+#endif /* USB_USB_DEVICE_USB_RING_H_ */
@@ -30,37 +30,37 @@
 
 using namespace GPIO_CPP_Extension;
 
+namespace fd = fastdelegate;
+
 USB_composite *usb_pointer;
 
+constexpr uint16_t USB_composite::KEYBOARD_PACKET_SIZE;
+
 void USB_composite::device_keybord_interrupt(usbd_device*, unsigned char)
 {
-	static UsbPackage lastPackage = UsbPackages::ZERO_PACKAGE;
-
-	UsbDequeStandart* usbDeque = usb_pointer->get_usb_deque();
-
-	if (usbDeque->isPopOnly() && !usbDeque->empty()) {
-		UsbPackage& package = usbDeque->front();
-
-		lastPackage = package;
+	usb_pointer->_keyboard.complete();
+	usb_pointer->_send_keyboard_report();
+}
 
-		size_t result = usb_pointer->usb_send_packet_nonblock(
-				package.data(), package.length()
-			);
+void USB_composite::_send_keyboard_report()
+{
+	_keyboard.process(get_counter_ms(), keyboard_idle, keyboard_leds,
+					  keyboard_protocol == HidProtocol::REPORT_PROTOCOL);
+}
 
-		bool packageSended = (result != 0);
-		if (packageSended) {
-			usbDeque->pop_front();
-		}
-	}
-	else {
-		usb_pointer->usb_send_packet_nonblock(
-				lastPackage.data(), lastPackage.length()
-			);
-	}
+void USB_composite::kick_keyboard()
+{
+	// Endpoint is written by the interrupt too
+	nvic_disable_irq(NVIC_OTG_FS_IRQ);
+	_send_keyboard_report();
+	nvic_enable_irq(NVIC_OTG_FS_IRQ);
 }
 
 
-USB_composite::USB_composite(UsbMemoryControlParams memoryParams)
+USB_composite::USB_composite(UsbMemoryControlParams memoryParams) :
+	_keyboard(&_usbRing,
+			  fd::MakeDelegate(this, &USB_composite::usb_send_keyboard_package),
+			  CURRENT_TYPING_PROFILE.pollInterval)
 {
 	usb_pointer = this;
 	descriptors = new UsbCompositeDescriptors();
@@ -91,15 +91,8 @@ USB_composite::USB_composite(UsbMemoryControlParams memoryParams)
 
 void USB_composite::init_hid_interrupt()
 {
-	send_zero_package();
-}
-
-void USB_composite::send_zero_package()
-{
-	usb_send_packet_nonblock(
-			UsbPackages::ZERO_PACKAGE.data(),
-			UsbPackages::ZERO_PACKAGE.length()
-		);
+	_usbRing.setCommitCallback(fd::MakeDelegate(this, &USB_composite::kick_keyboard));
+	kick_keyboard();
 }
 
 void USB_composite::usb_send_packet(const void *buf, int len)
@@ -112,6 +105,25 @@ uint16_t USB_composite::usb_send_packet_nonblock(const void *buf, int len)
     return usbd_ep_write_packet(my_usb_device, 0x81, buf, len);
 }
 
+uint16_t USB_composite::usb_send_keyboard_package(const UsbPackage& package, bool isBitmap)
+{
+	// Boot protocol host knows the boot report only, without ID. Report
+	// IDs are in the descriptor only if the profile has the bitmap report
+	if (CURRENT_TYPING_PROFILE.hasBitmapReport == false ||
+		keyboard_protocol == HidProtocol::BOOT_PROTOCOL)
+	{
+		return usb_send_packet_nonblock(package.data(), package.length());
+	}
+
+	if (isBitmap) {
+		UsbBitmapReport report(package);
+		return usb_send_packet_nonblock(report.data(), report.length());
+	}
+
+	UsbBootReport report(package);
+	return usb_send_packet_nonblock(report.data(), report.length());
+}
+
 void USB_OTG_IRQ()
 {
 	usbd_poll(usb_pointer->my_usb_device);
@@ -150,8 +162,23 @@ int USB_composite::hid_control_request(usbd_device *usbd_dev, struct usb_setup_d
 			if (req->bRequest == HidRequest::GET_REPORT)
 			{
 				static UsbPackage package = UsbPackages::ZERO_PACKAGE;
-				*buf = package.data();
-				*len = package.length();
+				static UsbBootReport bootReport(UsbPackages::ZERO_PACKAGE);
+				static UsbBitmapReport bitmapReport(UsbPackages::ZERO_PACKAGE);
+
+				if (CURRENT_TYPING_PROFILE.hasBitmapReport == false ||
+					keyboard_protocol == HidProtocol::BOOT_PROTOCOL)
+				{
+					*buf = package.data();
+					*len = package.length();
+				}
+				else if ((req->wValue & 0xFF) == UsbReportId::BITMAP_KEYBOARD) {
+					*buf = const_cast<uint8_t*>(bitmapReport.data());
+					*len = bitmapReport.length();
+				}
+				else {
+					*buf = const_cast<uint8_t*>(bootReport.data());
+					*len = bootReport.length();
+				}
 				return (USBD_REQ_HANDLED);
 			}
 			else if (req->bRequest == HidRequest::GET_IDLE)
@@ -180,6 +207,11 @@ int USB_composite::hid_control_request(usbd_device *usbd_dev, struct usb_setup_d
 				{
 					keyboard_leds = (*buf)[0];
 				}
+				else if (CURRENT_TYPING_PROFILE.hasBitmapReport &&
+						 *len == 2)  // report protocol, ID is the first
+				{
+					keyboard_leds = (*buf)[1];
+				}
 				return (USBD_REQ_HANDLED);
 			}
 			else if (req->bRequest == HidRequest::SET_IDLE)
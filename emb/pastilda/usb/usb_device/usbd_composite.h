@@ -29,7 +29,8 @@
 #include "usbd_composite_desc.h"
 #include "systick_ext.h"
 #include "gpio_ext.h"
-#include "usb_deque.h"
+#include "usb_ring.h"
+#include "hid_keyboard_endpoint.h"
 
 using namespace UsbPackages;
 
@@ -41,13 +42,16 @@ int USB_control_callback(usbd_device *usbd_dev, struct usb_setup_data *req,
 
 void USB_set_config_callback(usbd_device *usbd_dev, uint16_t wValue);
 
-static uint8_t keyboard_protocol = 1;
+static uint8_t keyboard_protocol = HidProtocol::REPORT_PROTOCOL;
 static uint8_t keyboard_idle = 0;
 static uint8_t keyboard_leds = 0;
 
 class USB_composite
 {
 public:
+	static constexpr uint16_t KEYBOARD_PACKET_SIZE =
+			CURRENT_TYPING_PROFILE.hasBitmapReport ? sizeof(UsbBitmapReport) : sizeof(UsbPackage);
+
 	uint8_t usbd_control_buffer[500];
 	UsbCompositeDescriptors *descriptors;
 	volatile uint32_t last_usb_request_time;
@@ -58,6 +62,7 @@ public:
 
 	void usb_send_packet(const void *buf, int len);
 	uint16_t usb_send_packet_nonblock(const void *buf, int len);
+	uint16_t usb_send_keyboard_package(const UsbPackage& package, bool isBitmap);
 
 	static void device_keybord_interrupt(usbd_device*, unsigned char);
 
@@ -74,18 +79,27 @@ public:
 		(void)wValue;
 		(void)usbd_dev;
 
-		usbd_ep_setup(usbd_dev, Endpoint::E_KEYBOARD, USB_ENDPOINT_ATTR_INTERRUPT, 8, device_keybord_interrupt);
+		usbd_ep_setup(usbd_dev, Endpoint::E_KEYBOARD, USB_ENDPOINT_ATTR_INTERRUPT,
+					  KEYBOARD_PACKET_SIZE, device_keybord_interrupt);
+		_keyboard.reset();
 		usbd_register_control_callback(usbd_dev, USB_REQ_TYPE_INTERFACE, USB_REQ_TYPE_RECIPIENT, USB_control_callback );
 	}
 
-	UsbDequeStandart* get_usb_deque() {
-		return &_usbDeque;
+	UsbRingStandart* get_usb_ring() {
+		return &_usbRing;
+	}
+
+	const HidReportStats& get_keyboard_stats() {
+		return _keyboard.getStats();
 	}
 
 	void init_hid_interrupt();
-	void send_zero_package();
+	void kick_keyboard();
 
 private:
-	UsbDequeStandart _usbDeque;
+	UsbRingStandart _usbRing;
+	HidKeyboardEndpoint _keyboard;
+
+	void _send_keyboard_report();
 };
 #endif
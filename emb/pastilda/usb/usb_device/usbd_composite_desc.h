@@ -32,6 +32,8 @@ extern "C"
 #include <libopencm3/usb/msc.h>
 }
 
+#include <typing_profile.h>
+
 typedef enum {
 	I_KEYBOARD     = 0,
 	I_MASS_STORAGE = 1
@@ -52,9 +54,27 @@ typedef enum {
 	SET_PROTOCOL = 11,
 } HidRequest;
 
+typedef enum {
+	BOOT_PROTOCOL = 0,
+	REPORT_PROTOCOL = 1
+} HidProtocol;
+
 class UsbCompositeDescriptors
 {
 public:
+#if TYPING_HAS_BITMAP_REPORT
+	// Report 1 has the boot keyboard layout, report 2 is N-key rollover
+	// bitmap of usages 0x00 - 0x7F. IDs are used in report protocol only.
+	static constexpr uint8_t keyboard_report_descriptor[]  =
+	{
+			0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+			0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x03,
+			0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x03, 0x91, 0x02, 0x95, 0x05, 0x75, 0x01, 0x91, 0x01,
+			0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x05, 0x07, 0x19, 0x00, 0x2A, 0xFF, 0x00,
+			0x81, 0x00, 0x85, 0x02, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01,
+			0x95, 0x08, 0x81, 0x02, 0x19, 0x00, 0x29, 0x7F, 0x95, 0x80, 0x81, 0x02, 0xC0
+	};
+#else
 	static constexpr uint8_t keyboard_report_descriptor[]  =
 	{
 			0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
@@ -63,6 +83,7 @@ public:
 			0x75, 0x08, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x05, 0x07, 0x19, 0x00, 0x2A, 0xFF, 0x00, 0x81, 0x00,
 			0xC0
 	};
+#endif
 
 	static constexpr char  usb_strings[][30] =
 	{
@@ -111,7 +132,7 @@ public:
 			USB_DT_ENDPOINT_SIZE,
 			USB_DT_ENDPOINT, Endpoint::E_KEYBOARD,
 			USB_ENDPOINT_ATTR_INTERRUPT,
-			64, 0x10
+			64, UsbPackages::CURRENT_TYPING_PROFILE.pollInterval
 	};
 
 	static constexpr struct usb_endpoint_descriptor msc_endpoint[] =
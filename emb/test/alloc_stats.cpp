@@ -0,0 +1,102 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <malloc.h>
+
+#include "alloc_stats.h"
+
+static size_t current_bytes = 0;
+static size_t peak_bytes = 0;
+
+extern "C" {
+	void* __real_malloc(size_t size);
+	void* __real_calloc(size_t count, size_t size);
+	void* __real_realloc(void* ptr, size_t size);
+	void __real_free(void* ptr);
+
+	// Usable size is what the block really takes,
+	// it also keeps blocks of unwrapped callers harmless
+	static void count_alloc(void* ptr)
+	{
+		if (ptr != nullptr) {
+			current_bytes += malloc_usable_size(ptr);
+			if (current_bytes > peak_bytes) {
+				peak_bytes = current_bytes;
+			}
+		}
+	}
+
+	static void count_free(void* ptr)
+	{
+		size_t size = (ptr != nullptr) ? malloc_usable_size(ptr) : 0;
+		current_bytes = (size < current_bytes) ? current_bytes - size : 0;
+	}
+
+	void* __wrap_malloc(size_t size)
+	{
+		void* ptr = __real_malloc(size);
+		count_alloc(ptr);
+		return ptr;
+	}
+
+	void* __wrap_calloc(size_t count, size_t size)
+	{
+		void* ptr = __real_calloc(count, size);
+		count_alloc(ptr);
+		return ptr;
+	}
+
+	void* __wrap_realloc(void* ptr, size_t size)
+	{
+		size_t oldSize = (ptr != nullptr) ? malloc_usable_size(ptr) : 0;
+		void* result = __real_realloc(ptr, size);
+
+		// Failed realloc keeps the old block
+		if (result != nullptr || size == 0) {
+			current_bytes = (oldSize < current_bytes) ? current_bytes - oldSize : 0;
+			count_alloc(result);
+		}
+		return result;
+	}
+
+	void __wrap_free(void* ptr)
+	{
+		count_free(ptr);
+		__real_free(ptr);
+	}
+}
+
+namespace AllocStats {
+	size_t current() {
+		return current_bytes;
+	}
+
+	size_t peak() {
+		return peak_bytes;
+	}
+
+	void resetPeak() {
+		peak_bytes = current_bytes;
+	}
+}
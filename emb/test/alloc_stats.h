@@ -0,0 +1,39 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_ALLOC_STATS_H
+#define HOST_ALLOC_STATS_H
+
+#include <cstddef>
+
+// Heap usage of the device code on the host. Targets linked with
+// host_alloc_stats get malloc(), calloc(), realloc() and free() wrapped
+// by the linker, so only allocations of the code under test are counted.
+namespace AllocStats {
+	size_t current();
+	size_t peak();
+	void resetPeak();
+}
+
+#endif
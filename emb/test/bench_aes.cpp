@@ -0,0 +1,69 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <keepass/keepass_aes.h>
+#include <keepass/keepass_reader_defines.h>
+
+#include "host_test.h"
+
+using namespace KeepAss;
+
+// Key transformation rounds/s and payload decryption MB/s
+// of the software backends.
+namespace {
+	template<typename Aes>
+	void bench(const char* name)
+	{
+		uint8_t key[32] = {1, 2, 3};
+		uint8_t iv[16] = {4, 5, 6};
+		uint8_t transformed[32] = {7, 8, 9};
+
+		const uint32_t rounds = 200000;
+		HostTest::Stopwatch kdf;
+		Aes::encrypt_ECB(key, transformed, sizeof(transformed), rounds);
+		double kdfSeconds = kdf.seconds();
+
+		std::vector<uint8_t> chunk(STREAM_CHUNK_SIZE_IN_BYTES);
+		const size_t total = 16 * 1024 * 1024;
+		HostTest::Stopwatch cbc;
+		for (size_t done = 0; done < total; done += chunk.size()) {
+			Aes::decrypt_CBC(key, iv, chunk.data(), chunk.size());
+		}
+		double cbcSeconds = cbc.seconds();
+
+		std::printf("%-10s %10.0f rounds/s %8.2f MB/s\n", name,
+					rounds / kdfSeconds, total / cbcSeconds / (1024 * 1024));
+	}
+}
+
+int main()
+{
+	bench<KeePassAesSoftware>("tables");
+	bench<KeePassAesBitsliced>("bitsliced");
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include <keepass/keepass_crypto.h>
+
+#include "host_test.h"
+
+using namespace KeepAss;
+
+// Throughput of the inner stream ciphers and of the hashes
+// used for the payload blocks and the ChaCha20 key.
+namespace {
+	const size_t TOTAL = 64 * 1024 * 1024;
+
+	void report(const char* name, double seconds)
+	{
+		std::printf("%-10s %8.2f MB/s\n", name, TOTAL / seconds / (1024 * 1024));
+	}
+
+	template<typename Cipher>
+	void benchCipher(const char* name)
+	{
+		uint8_t key[32] = {1, 2, 3};
+		uint8_t iv[16] = {4, 5, 6};
+		std::vector<uint8_t> stream(Cipher::BLOCK_SIZE * 4);
+
+		Cipher cipher(key);
+		cipher.setIv(iv);
+
+		HostTest::Stopwatch stopwatch;
+		for (size_t done = 0; done < TOTAL; done += stream.size()) {
+			for (size_t i = 0; i < stream.size(); i += Cipher::BLOCK_SIZE) {
+				cipher.generateKeyStream(&stream[i]);
+			}
+		}
+		report(name, stopwatch.seconds());
+	}
+
+	template<typename Context>
+	void benchHash(const char* name, void (*init)(Context*),
+				   void (*update)(Context*, const void*, size_t))
+	{
+		std::vector<uint8_t> chunk(STREAM_CHUNK_SIZE_IN_BYTES, 0x5A);
+		Context ctx;
+		init(&ctx);
+
+		HostTest::Stopwatch stopwatch;
+		for (size_t done = 0; done < TOTAL; done += chunk.size()) {
+			update(&ctx, chunk.data(), chunk.size());
+		}
+		report(name, stopwatch.seconds());
+	}
+}
+
+int main()
+{
+	benchCipher<Salsa20>("Salsa20");
+	benchCipher<ChaCha20>("ChaCha20");
+	benchHash<cf_sha256_context>("SHA-256", cf_sha256_init, cf_sha256_update);
+	benchHash<cf_sha512_context>("SHA-512", cf_sha512_init, cf_sha512_update);
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/xmlindex/XmlIndex.h>
+
+#include "alloc_stats.h"
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+// Time and heap peak of loading the decrypted xml: the whole DOM built
+// by mxmlLoadString() as it was before, against SAX events into the
+// XmlIndex and the EntryStore built from it, which is what is kept.
+namespace {
+	void benchDom(const std::string& xml)
+	{
+		size_t heapBefore = AllocStats::current();
+		AllocStats::resetPeak();
+
+		HostTest::Stopwatch stopwatch;
+		mxml_node_t* tree = mxmlLoadString(nullptr, xml.c_str(), MXML_OPAQUE_CALLBACK);
+		double seconds = stopwatch.seconds();
+		size_t peakBytes = AllocStats::peak() - heapBefore;
+		mxmlDelete(tree);
+
+		std::printf("  DOM          %8.2f ms, peak %9zu B%s\n",
+					seconds * 1000.0, peakBytes, tree != nullptr ? "" : " (not parsed!)");
+	}
+
+	void benchIndex(const std::string& xml)
+	{
+		size_t heapBefore = AllocStats::current();
+		AllocStats::resetPeak();
+
+		HostTest::Stopwatch stopwatch;
+		DB::XmlIndex* index = new DB::XmlIndex();
+		mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+						  DB::XmlIndex::saxCallback, index);
+		double parseSeconds = stopwatch.seconds();
+
+		DB::EntryStore store;
+		bool isBuilt = index->isComplete() && store.build(*index);
+		delete index;
+		double seconds = stopwatch.seconds();
+		size_t peakBytes = AllocStats::peak() - heapBefore;
+		size_t keptBytes = AllocStats::current() - heapBefore;
+
+		std::printf("  index+store  %8.2f ms (parse %.2f ms), peak %9zu B, kept %8zu B%s\n",
+					seconds * 1000.0, parseSeconds * 1000.0, peakBytes, keptBytes,
+					isBuilt ? "" : " (not built!)");
+	}
+
+	void bench(size_t entriesCount)
+	{
+		HostKdbx::Options options;
+		options.seed = entriesCount;
+		HostKdbx::Group root = HostKdbx::makeCorpus(entriesCount, 64, options.seed);
+		uint8_t streamKey[32] = {1, 2, 3};
+		std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+		std::printf("%6zu entries, xml %8zu B\n", entriesCount, xml.size());
+		benchDom(xml);
+		benchIndex(xml);
+	}
+}
+
+int main()
+{
+	const size_t ENTRIES[] = {100, 1000, 10000};
+	for (size_t entriesCount : ENTRIES) {
+		bench(entriesCount);
+	}
+
+	return 0;
+}
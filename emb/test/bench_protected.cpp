@@ -0,0 +1,98 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <keepass/keepass_crypto.h>
+#include <menu/AutoType.h>
+
+#include "host_test.h"
+
+using namespace KeepAss;
+
+// Protected values revealed per second: base64 decoding and
+// the inner stream xor, values lie one after another in the stream.
+// Values are revealed by parts into a buffer of the auto-type runner
+// size, as when they are typed, longer values take several parts.
+namespace {
+	const uint32_t VALUES_COUNT = 4096;
+
+	void bench(InnerRandomStream algorithm, const char* name, uint32_t plainLength)
+	{
+		uint8_t key[64] = {1, 2, 3};
+		uint8_t iv[16] = {4, 5, 6};
+		KeePassCrypto::init_inner_stream(algorithm, key, iv);
+
+		// Values are encrypted and encoded as KeePass writes them
+		std::vector<std::string> encoded(VALUES_COUNT);
+		std::vector<uint8_t> plain(plainLength);
+		for (uint32_t i = 0; i < VALUES_COUNT; ++i) {
+			for (uint32_t j = 0; j < plainLength; ++j) {
+				plain[j] = 'a' + (i + j) % 26;
+			}
+			KeePassCrypto::seek_inner_stream(i * plainLength);
+			KeePassCrypto::eval_inner_stream(plain.data(), plainLength);
+			Base64::Encode(std::string(plain.begin(), plain.end()), &encoded[i]);
+		}
+
+		uint8_t buffer[Logic::AutoTypeRunner::PASSWORD_PART_LENGTH];
+		bool isValid = true;
+
+		HostTest::Stopwatch stopwatch;
+		for (uint32_t i = 0; i < VALUES_COUNT; ++i) {
+			uint32_t position = 0;
+			uint32_t length = 0;
+			do {
+				isValid &= KeePassCrypto::decode_protected_part(
+						(const uint8_t*)encoded[i].data(), encoded[i].size(),
+						i * plainLength, position, buffer, sizeof(buffer), &length);
+				isValid &= (length == 0 || buffer[0] == 'a' + (i + position) % 26);
+				position += length;
+			} while (length != 0);
+			isValid &= (position == plainLength);
+		}
+		double seconds = stopwatch.seconds();
+
+		std::printf("%-8s %5u B: %10.0f values/s %8.2f MB/s%s\n", name, plainLength,
+					VALUES_COUNT / seconds,
+					(double)VALUES_COUNT * plainLength / seconds / (1024 * 1024),
+					isValid ? "" : " (wrong values!)");
+	}
+}
+
+int main()
+{
+	const uint32_t LENGTHS[] = {16, 64, 255, 1024, 4096};
+
+	for (uint32_t length : LENGTHS) {
+		bench(SALSA20_STREAM, "Salsa20", length);
+	}
+	for (uint32_t length : LENGTHS) {
+		bench(CHACHA20_STREAM, "ChaCha20", length);
+	}
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/searchindex/FuzzyMatcher.h>
+#include <database/searchindex/SearchIndex.h>
+#include <database/xmlindex/XmlIndex.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+// Search mode keystrokes: the prefix index narrows a sorted range by
+// binary search, the fuzzy matcher filters all entries of the query.
+// Query is typed char by char and then erased, as a user does.
+namespace {
+	const size_t REPEATS = 200;
+
+	size_t getFound(const DB::SearchIndex& searchIndex)
+	{
+		return (searchIndex.getMatchesCount());
+	}
+
+	size_t getFound(const DB::FuzzyMatcher& matcher)
+	{
+		return (matcher.getResultsCount());
+	}
+
+	template<typename Search>
+	double typeQuery(Search& search, const char* query, size_t* found)
+	{
+		size_t length = std::strlen(query);
+
+		HostTest::Stopwatch stopwatch;
+		for (size_t repeat = 0; repeat < REPEATS; ++repeat) {
+			search.reset();
+			for (size_t i = 1; i <= length; ++i) {
+				search.search((const uint8_t*)query, i);
+			}
+			for (size_t i = length; i > 0; --i) {
+				search.search((const uint8_t*)query, i - 1);
+			}
+		}
+		double seconds = stopwatch.seconds();
+
+		search.search((const uint8_t*)query, length);
+		*found = getFound(search);
+
+		return (seconds * 1e6 / (REPEATS * length * 2));
+	}
+
+	void bench(size_t entriesCount)
+	{
+		HostKdbx::Options options;
+		HostKdbx::Group root = HostKdbx::makeCorpus(entriesCount, 0, entriesCount);
+		uint8_t streamKey[32] = {1, 2, 3};
+		std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+		DB::XmlIndex index;
+		mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+						  DB::XmlIndex::saxCallback, &index);
+		DB::EntryStore store;
+		if (!index.isComplete() || !store.build(index)) {
+			std::printf("%7zu entries: store is not built\n", entriesCount);
+			return;
+		}
+		index.clear();
+
+		DB::SearchIndex searchIndex;
+		DB::FuzzyMatcher matcher;
+
+		HostTest::Stopwatch stopwatch;
+		searchIndex.build(&store);
+		double indexMs = stopwatch.seconds() * 1000.0;
+		stopwatch = HostTest::Stopwatch();
+		matcher.build(&store);
+		double matcherMs = stopwatch.seconds() * 1000.0;
+
+		std::printf("%7zu entries: prefix index %6.2f ms %7zu B, fuzzy %6.2f ms %7zu B\n",
+					entriesCount, indexMs, searchIndex.getUsedMemory(),
+					matcherMs, matcher.getUsedMemory());
+
+		const char* QUERIES[] = {"mail12", "user42@ex", "bnk 1"};
+		for (const char* query : QUERIES) {
+			size_t prefixFound = 0;
+			size_t fuzzyFound = 0;
+			double prefixUs = typeQuery(searchIndex, query, &prefixFound);
+			double fuzzyUs = typeQuery(matcher, query, &fuzzyFound);
+
+			std::printf("  %-10s prefix %8.3f us/key (%5zu found), "
+						"fuzzy %8.3f us/key (%5zu found)\n",
+						query, prefixUs, prefixFound, fuzzyUs, fuzzyFound);
+		}
+	}
+}
+
+int main()
+{
+	const size_t ENTRIES[] = {1000, 5000, 10000};
+	for (size_t entriesCount : ENTRIES) {
+		bench(entriesCount);
+	}
+
+	return 0;
+}
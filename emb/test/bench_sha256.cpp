@@ -0,0 +1,85 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "host_test.h"
+#include "sha256_baseline.h"
+
+// SHA-256 of 1 MB by the original one block at a time update and by
+// the current one, best of the repeats. Built for SHA-NI as well.
+namespace {
+	const size_t SIZE = 1024 * 1024;
+	const int REPEATS_COUNT = 50;
+
+	typedef void (*Update)(cf_sha256_context*, const void*, size_t);
+
+	double bench(Update update, const std::vector<uint8_t>& data,
+				 uint8_t hash[CF_SHA256_HASHSZ])
+	{
+		double best = 0;
+		for (int i = 0; i < REPEATS_COUNT; ++i) {
+			cf_sha256_context ctx;
+			cf_sha256_init(&ctx);
+
+			HostTest::Stopwatch stopwatch;
+			update(&ctx, data.data(), data.size());
+			cf_sha256_digest_final(&ctx, hash);
+			double seconds = stopwatch.seconds();
+
+			if (i == 0 || seconds < best) {
+				best = seconds;
+			}
+		}
+		return best;
+	}
+}
+
+int main()
+{
+	std::vector<uint8_t> data(SIZE);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] = (uint8_t)(i * 131 + (i >> 8));
+	}
+
+	uint8_t baselineHash[CF_SHA256_HASHSZ];
+	uint8_t currentHash[CF_SHA256_HASHSZ];
+	double baseline = bench(baseline_sha256_update, data, baselineHash);
+	double current = bench(cf_sha256_update, data, currentHash);
+
+	std::printf("SHA-256 of 1 MB%s: baseline %.3f ms (%.1f MB/s), "
+				"current %.3f ms (%.1f MB/s), x%.2f%s\n",
+#if HOST_SHA_NI
+				" (SHA-NI)",
+#else
+				"",
+#endif
+				baseline * 1000.0, 1.0 / baseline, current * 1000.0, 1.0 / current,
+				baseline / current,
+				std::memcmp(baselineHash, currentHash, CF_SHA256_HASHSZ) == 0 ?
+				"" : " (digests differ!)");
+	return 0;
+}
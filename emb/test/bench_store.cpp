@@ -0,0 +1,130 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/xmlindex/XmlIndex.h>
+#include <database/xmltree/XmlTree.h>
+
+#include "alloc_stats.h"
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+// Heap per entry of packing the parsed index into the store: the
+// transient peak of EntryStore::build() above the index and the store
+// which is kept after the index is freed. Then the time of XmlTree
+// moveLeft()/moveRight() with getCurrentNodeInfo() at every step, as
+// the menu scrolls, over the levels down the leftmost path.
+namespace {
+	const size_t NAVIGATION_STEPS = 5000;
+
+	// Returns the count of steps, names are summed up to check that
+	// the node info really changes with the current node
+	size_t benchNavigation(const DB::EntryStore& store, double* seconds, size_t* namesLength)
+	{
+		DB::XmlTree tree(&store);
+		size_t steps = 0;
+		size_t passSteps = 1;
+		*namesLength = 0;
+
+		HostTest::Stopwatch stopwatch;
+		while (steps < NAVIGATION_STEPS && passSteps != 0) {
+			passSteps = 0;
+			tree.moveInHead();
+			while (true) {
+				while (tree.isMostRight() == false) {
+					tree.moveRight();
+					*namesLength += tree.getCurrentNodeInfo().name.size();
+					++passSteps;
+				}
+				while (tree.isMostLeft() == false) {
+					tree.moveLeft();
+					*namesLength += tree.getCurrentNodeInfo().name.size();
+					++passSteps;
+				}
+				if (tree.isEndNode() || tree.isMostBottom()) {
+					break;
+				}
+				tree.moveInto();
+			}
+			steps += passSteps;
+		}
+		*seconds = stopwatch.seconds();
+
+		return (steps);
+	}
+
+	void bench(size_t entriesCount)
+	{
+		HostKdbx::Options options;
+		options.seed = entriesCount;
+		HostKdbx::Group root = HostKdbx::makeCorpus(entriesCount, 64, options.seed);
+		uint8_t streamKey[32] = {1, 2, 3};
+		std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+		DB::XmlIndex index;
+		mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+						  DB::XmlIndex::saxCallback, &index);
+		if (!index.isComplete()) {
+			std::printf("%7zu entries: xml is not indexed\n", entriesCount);
+			return;
+		}
+
+		DB::EntryStore store;
+		size_t nodesCount = index.getRecordsCount();
+		size_t heapBefore = AllocStats::current();
+		AllocStats::resetPeak();
+
+		HostTest::Stopwatch stopwatch;
+		bool isBuilt = store.build(index);
+		double seconds = stopwatch.seconds();
+
+		size_t storeBytes = store.getUsedMemory();
+		size_t peakBytes = AllocStats::peak() - heapBefore;
+		std::printf("%7zu nodes: %6.2f ms, index %8zu B, store %8zu B (%5.1f B/node), "
+					"build peak %8zu B (%5.1f B/node above store)%s\n",
+					nodesCount, seconds * 1000.0, index.getUsedMemory(), storeBytes,
+					(double)storeBytes / nodesCount, peakBytes,
+					(double)(peakBytes - storeBytes) / nodesCount,
+					isBuilt ? "" : " (not built!)");
+
+		size_t namesLength = 0;
+		size_t steps = benchNavigation(store, &seconds, &namesLength);
+		std::printf("%7s        %zu moves with node info: %6.1f ns/move%s\n",
+					"", steps, seconds * 1e9 / steps,
+					namesLength != 0 ? "" : " (no names!)");
+	}
+}
+
+int main()
+{
+	const size_t ENTRIES[] = {100, 1000, 3800, 20000};
+	for (size_t entriesCount : ENTRIES) {
+		bench(entriesCount);
+	}
+
+	return 0;
+}
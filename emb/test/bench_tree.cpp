@@ -0,0 +1,118 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+
+#include <Tree.hpp>
+
+#include "host_test.h"
+
+// Time of building a full menu tree of groups with entries, as the
+// menu is built from the database, and of walking it: into every
+// group, across its entries and out again.
+namespace {
+	const size_t GROUPS_COUNT = 64;
+	const size_t ROUNDS = 100;
+
+	using BenchTree = Tree<4096, int>;
+	static_assert(BenchTree::NODES_COUNT % GROUPS_COUNT == 0, "Groups don't fill the tree");
+
+	const size_t ENTRIES_COUNT = BenchTree::NODES_COUNT / GROUPS_COUNT - 1;
+
+	BenchTree tree;
+
+	void build()
+	{
+		tree.destroy();
+		int value = 0;
+		tree.getCurrentNode()->setContainer(value);
+		for (size_t group = 1; group < GROUPS_COUNT; ++group) {
+			tree.addNeighbor(&BenchTree::TreeNodeT::EMPTY_CALLBACK, ++value);
+		}
+
+		for (size_t group = 0; group < GROUPS_COUNT; ++group) {
+			for (size_t entry = 0; entry < ENTRIES_COUNT; ++entry) {
+				tree.addChild(&BenchTree::TreeNodeT::EMPTY_CALLBACK, ++value);
+			}
+			tree.moveRight();
+		}
+		tree.moveInHead();
+		tree.moveMostLeft();
+	}
+
+	// Returns the count of moves, the sum of values checks the walk
+	size_t walk(long long* sum)
+	{
+		size_t moves = 0;
+		tree.moveMostLeft();
+		while (true) {
+			tree.moveInto();
+			*sum += tree.getCurrentNode()->getContainer();
+			while (tree.isMostRight() == false) {
+				tree.moveRight();
+				*sum += tree.getCurrentNode()->getContainer();
+				++moves;
+			}
+			tree.moveMostLeft();
+			tree.moveOut();
+			*sum += tree.getChildrenCount();
+			moves += 3;
+
+			if (tree.isMostRight()) {
+				break;
+			}
+			tree.moveRight();
+			++moves;
+		}
+		return (moves);
+	}
+}
+
+int main()
+{
+	HostTest::Stopwatch stopwatch;
+	for (size_t round = 0; round < ROUNDS; ++round) {
+		build();
+	}
+	double buildSeconds = stopwatch.seconds() / ROUNDS;
+
+	long long sum = 0;
+	size_t moves = 0;
+	stopwatch = HostTest::Stopwatch();
+	for (size_t round = 0; round < ROUNDS; ++round) {
+		moves += walk(&sum);
+	}
+	double walkSeconds = stopwatch.seconds();
+
+	long long values = BenchTree::NODES_COUNT - 1;
+	long long expected = (values * (values + 1) / 2 - GROUPS_COUNT * (GROUPS_COUNT - 1) / 2 +
+						  GROUPS_COUNT * ENTRIES_COUNT) * ROUNDS;
+	std::printf("%zu nodes (%zu groups of %zu), %zu B: build %.1f us, %.1f ns/node\n",
+				BenchTree::NODES_COUNT, GROUPS_COUNT, ENTRIES_COUNT, sizeof(tree),
+				buildSeconds * 1e6, buildSeconds * 1e9 / BenchTree::NODES_COUNT);
+	std::printf("walk %zu moves: %.1f ns/move%s\n", moves / ROUNDS, walkSeconds * 1e9 / moves,
+				tree.isFull() && sum == expected ? "" : " (wrong tree!)");
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <keepass/keepass_reader.h>
+
+#include "alloc_stats.h"
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+using namespace KeepAss;
+
+// Unlock of the same generated database stored plain and gzipped: file
+// size, wall time and peak heap, so the cost of the inflate is seen
+// against the smaller payload to decrypt and hash.
+namespace {
+	const char* DB_NAME = "db.kdb";
+	const char* PASSWORD = "corpus password";
+	const int REPEATS_COUNT = 5;
+
+	// Best of the repeats, returns false if unlock fails
+	bool unlock(double& ms, size_t& peakBytes)
+	{
+		ms = 0;
+		peakBytes = 0;
+
+		for (int i = 0; i < REPEATS_COUNT; ++i) {
+			KeePassReader* reader = new KeePassReader();
+			reader->set_password(PASSWORD, std::strlen(PASSWORD));
+
+			AllocStats::resetPeak();
+			size_t heapBefore = AllocStats::current();
+			HostTest::Stopwatch stopwatch;
+
+			DecryptionResult result = reader->decrypt_database(DB_NAME);
+			while (result == IN_PROGRESS) {
+				result = reader->continue_decryption();
+			}
+
+			double runMs = stopwatch.seconds() * 1000.0;
+			peakBytes = AllocStats::peak() - heapBefore;
+			delete reader;
+
+			if (result != SUCCESS) {
+				return false;
+			}
+			if (i == 0 || runMs < ms) {
+				ms = runMs;
+			}
+		}
+		return true;
+	}
+
+	void bench(size_t entriesCount, bool isGzip)
+	{
+		HostKdbx::Options options;
+		options.isGzip = isGzip;
+		options.seed = entriesCount;
+
+		HostKdbx::Group root = HostKdbx::makeCorpus(entriesCount, 64, options.seed);
+		std::vector<uint8_t> file = HostKdbx::write(root, PASSWORD, options);
+		FileSystem::host_write_file(DB_NAME, file.data(), file.size());
+
+		double ms;
+		size_t peakBytes;
+		if (!unlock(ms, peakBytes)) {
+			std::printf("%7zu entries %-5s: unlock failed\n", entriesCount,
+						isGzip ? "gzip" : "plain");
+			return;
+		}
+
+		std::printf("%7zu entries %-5s: %8zu B file, %7.2f ms, peak heap %8zu B\n",
+					entriesCount, isGzip ? "gzip" : "plain", file.size(), ms, peakBytes);
+	}
+}
+
+int main()
+{
+	if (!HostKdbx::hasGzip()) {
+		std::printf("zlib isn't found, gzip files can't be written\n");
+	}
+
+	const size_t ENTRIES[] = {100, 1000, 3800};
+	for (size_t entriesCount : ENTRIES) {
+		bench(entriesCount, false);
+		if (HostKdbx::hasGzip()) {
+			bench(entriesCount, true);
+		}
+	}
+
+	FileSystem::host_remove_file(DB_NAME);
+	return 0;
+}
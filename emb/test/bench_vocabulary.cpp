@@ -0,0 +1,130 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <database/xmlindex/XmlVocabulary.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+using DB::XmlVocabulary;
+using DB::XmlWord;
+
+// Lookups per second of the tag and key names of a generated database,
+// in document order: the perfect hash against the chain of strcmp()
+// the index used before.
+namespace {
+	const size_t ROUNDS = 20;
+
+	struct Word {
+		const char* text;
+		XmlWord word;
+	};
+
+	const Word WORDS[] = {
+		{"Group", XmlWord::GROUP},
+		{"Entry", XmlWord::ENTRY},
+		{"String", XmlWord::STRING},
+		{"Key", XmlWord::KEY},
+		{"Value", XmlWord::VALUE},
+		{"Name", XmlWord::NAME},
+		{"AutoType", XmlWord::AUTO_TYPE},
+		{"DefaultSequence", XmlWord::DEFAULT_SEQUENCE},
+		{"DefaultAutoTypeSequence", XmlWord::DEFAULT_AUTO_TYPE_SEQUENCE},
+		{"Title", XmlWord::TITLE},
+		{"UserName", XmlWord::USER_NAME},
+		{"Password", XmlWord::PASSWORD},
+		{"Type", XmlWord::TYPE}
+	};
+
+	XmlWord findByStrcmp(const char* text)
+	{
+		for (const Word& word : WORDS) {
+			if (std::strcmp(text, word.text) == 0) {
+				return (word.word);
+			}
+		}
+		return (XmlWord::UNKNOWN);
+	}
+
+	// Opening tags and the text of <Key> elements
+	std::vector<std::string> names(const std::string& xml)
+	{
+		std::vector<std::string> result;
+		size_t pos = 0;
+		while ((pos = xml.find('<', pos)) != std::string::npos) {
+			++pos;
+			if (xml[pos] == '/' || xml[pos] == '?' || xml[pos] == '!') {
+				continue;
+			}
+			size_t end = xml.find_first_of(" />", pos);
+			result.push_back(xml.substr(pos, end - pos));
+			if (result.back() == "Key" && xml[end] == '>') {
+				size_t close = xml.find('<', end);
+				result.push_back(xml.substr(end + 1, close - end - 1));
+			}
+		}
+		return (result);
+	}
+
+	double bench(const std::vector<std::string>& names, XmlWord (*find)(const char*),
+				 size_t* found)
+	{
+		*found = 0;
+		HostTest::Stopwatch stopwatch;
+		for (size_t round = 0; round < ROUNDS; ++round) {
+			for (const std::string& name : names) {
+				*found += (find(name.c_str()) != XmlWord::UNKNOWN);
+			}
+		}
+		return (stopwatch.seconds());
+	}
+}
+
+int main()
+{
+	HostKdbx::Options options;
+	HostKdbx::Group root = HostKdbx::makeCorpus(1000, 64, options.seed);
+	uint8_t streamKey[32] = {1, 2, 3};
+	std::vector<std::string> xmlNames = names(HostKdbx::makeXml(root, options, streamKey));
+
+	size_t hashFound = 0;
+	size_t strcmpFound = 0;
+	double hashSeconds = bench(xmlNames, XmlVocabulary::find, &hashFound);
+	double strcmpSeconds = bench(xmlNames, findByStrcmp, &strcmpFound);
+	double lookups = (double)xmlNames.size() * ROUNDS;
+
+	std::printf("%zu names, %.0f%% known\n", xmlNames.size(),
+				100.0 * hashFound / lookups);
+	std::printf("perfect hash %8.1f ns/lookup\n", hashSeconds * 1e9 / lookups);
+	std::printf("strcmp chain %8.1f ns/lookup (x%.2f)%s\n", strcmpSeconds * 1e9 / lookups,
+				strcmpSeconds / hashSeconds,
+				hashFound == strcmpFound ? "" : " (different words found!)");
+
+	return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "host_keyboard.h"
+
+using namespace UsbPackages;
+
+namespace HostReports {
+	HostKeyboard::HostKeyboard(Ring& ring, const HostOptions& options) :
+		_ring(ring),
+		_options(options),
+		_endpoint(&ring,
+				  HidKeyboardEndpoint::SendCallback(this, &HostKeyboard::_write),
+				  CURRENT_TYPING_PROFILE.pollInterval),
+		_nowMs(0),
+		_isWritten(false),
+		_written(ZERO_PACKAGE),
+		_lastHandledMs(0),
+		_handled(ZERO_PACKAGE),
+		_lostCount(0),
+		_leds(0),
+		_hostLeds(0),
+		_ledsSetMs(0),
+		_isLedsPending(false)
+	{
+		_ring.setCommitCallback(Ring::CommitCallback(this, &HostKeyboard::_kick));
+	}
+
+	void HostKeyboard::step()
+	{
+		_nowMs++;
+
+		if (_isLedsPending && _nowMs - _ledsSetMs >= _options.ledLatencyMs) {
+			_leds = _hostLeds;
+			_isLedsPending = false;
+		}
+
+		// Poll takes the written report, the endpoint interrupt writes the next one
+		if (_nowMs % CURRENT_TYPING_PROFILE.pollInterval == 0 && _isWritten) {
+			_isWritten = false;
+			_reports.push_back(_written);
+
+			if (_queue.size() < _options.queueSize) {
+				_queue.push_back(_written);
+			}
+			else {
+				_lostCount++;
+			}
+
+			_endpoint.complete();
+			_kick();
+		}
+
+		while (!_queue.empty() &&
+			   (_options.handleIntervalMs == 0 ||
+				_nowMs - _lastHandledMs >= _options.handleIntervalMs))
+		{
+			_lastHandledMs = _nowMs;
+			_handle(_queue.front());
+			_queue.pop_front();
+		}
+
+		// Main loop kicks the endpoint, e.g. when the pacer waits for LEDs
+		_kick();
+	}
+
+	bool HostKeyboard::run(uint32_t maxMs)
+	{
+		uint32_t endMs = _nowMs + maxMs;
+
+		while (!isDone()) {
+			if (_nowMs == endMs) {
+				return false;
+			}
+			step();
+		}
+		return true;
+	}
+
+	bool HostKeyboard::isDone() const
+	{
+		return (_ring.isIdle() && !_isWritten && _queue.empty() &&
+				!_isLedsPending && !_endpoint.getPacer().hasProbe());
+	}
+
+	uint16_t HostKeyboard::_write(const UsbPackage& package, bool isBitmap)
+	{
+		if (_isWritten) {
+			return 0;
+		}
+
+		_isWritten = true;
+		_written = package;
+		return (isBitmap ? sizeof(UsbBitmapReport) : package.length());
+	}
+
+	void HostKeyboard::_kick()
+	{
+		_endpoint.process(_nowMs, 0, _leds, _options.isReportProtocol);
+	}
+
+	void HostKeyboard::_handle(const UsbPackage& report)
+	{
+		bool isScrollLockHeld = false;
+		bool wasScrollLockHeld = false;
+		for (size_t i = 0; i < USB_PACKAGE_KEY_FIELDS_LENGTH; ++i) {
+			isScrollLockHeld |= (report.key[i] == UsbKey::KEY_SCROLL_LOCK);
+			wasScrollLockHeld |= (_handled.key[i] == UsbKey::KEY_SCROLL_LOCK);
+		}
+
+		if (isScrollLockHeld && !wasScrollLockHeld) {
+			_hostLeds ^= HidTypingPacer::SCROLL_LOCK_LED;
+			_ledsSetMs = _nowMs;
+			_isLedsPending = true;
+		}
+
+		decode(_handled, report, _text);
+		_handled = report;
+	}
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_KEYBOARD_H
+#define HOST_KEYBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include <hid_keyboard_endpoint.h>
+#include <typing_profile.h>
+
+#include "report_stream.h"
+
+// USB host with a keyboard on the endpoint, simulated in 1 ms steps.
+// Host polls the endpoint each bInterval of the typing profile, the
+// main loop kicks it each step. Received reports go to the host's
+// queue and are handled one per handleIntervalMs, a report which
+// doesn't fit into the queue is lost. Scroll Lock toggles the LED,
+// which is set by SET_REPORT ledLatencyMs later.
+namespace HostReports {
+	struct HostOptions {
+		uint32_t handleIntervalMs = 0;  // 0 handles all at once
+		size_t queueSize = SIZE_MAX;
+		uint32_t ledLatencyMs = 1;
+		bool isReportProtocol = false;
+	};
+
+	class HostKeyboard {
+	public:
+		HostKeyboard(Ring& ring, const HostOptions& options);
+
+		void step();
+		// Steps until all is typed and handled, false on timeout
+		bool run(uint32_t maxMs);
+
+		uint32_t getNowMs() const {
+			return _nowMs;
+		}
+
+		const std::string& getText() const {
+			return _text;
+		}
+
+		const Reports& getReports() const {
+			return _reports;
+		}
+
+		size_t getLostCount() const {
+			return _lostCount;
+		}
+
+		uint8_t getLeds() const {
+			return _leds;
+		}
+
+		const UsbPackages::HidKeyboardEndpoint& getEndpoint() const {
+			return _endpoint;
+		}
+
+		bool isDone() const;
+
+	private:
+		Ring& _ring;
+		HostOptions _options;
+		UsbPackages::HidKeyboardEndpoint _endpoint;
+
+		uint32_t _nowMs;
+		bool _isWritten;
+		UsbPackages::UsbPackage _written;
+
+		std::deque<UsbPackages::UsbPackage> _queue;
+		uint32_t _lastHandledMs;
+		UsbPackages::UsbPackage _handled;
+		std::string _text;
+		Reports _reports;
+		size_t _lostCount;
+
+		uint8_t _leds;
+		uint8_t _hostLeds;
+		uint32_t _ledsSetMs;
+		bool _isLedsPending;
+
+		uint16_t _write(const UsbPackages::UsbPackage& package, bool isBitmap);
+		void _kick();
+		void _handle(const UsbPackages::UsbPackage& report);
+	};
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+// Minimal checks for host tests, a failed check is reported
+// and counted, main() returns the result of HostTest::exit()
+namespace HostTest {
+	inline int& failures() {
+		static int count = 0;
+		return count;
+	}
+
+	inline bool check(bool isPassed, const char* expression,
+					  const char* file, int line)
+	{
+		if (!isPassed) {
+			std::printf("%s:%d: check failed: %s\n", file, line, expression);
+			failures()++;
+		}
+		return isPassed;
+	}
+
+	inline int exit() {
+		if (failures() != 0) {
+			std::printf("%d check(s) failed\n", failures());
+			return EXIT_FAILURE;
+		}
+		std::printf("all checks passed\n");
+		return EXIT_SUCCESS;
+	}
+
+	// Wall time of benchmarks
+	class Stopwatch {
+	public:
+		Stopwatch() : _start(std::chrono::steady_clock::now()) { }
+
+		double seconds() const {
+			std::chrono::duration<double> elapsed =
+					std::chrono::steady_clock::now() - _start;
+			return elapsed.count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point _start;
+	};
+}
+
+#define CHECK(expression) \
+	HostTest::check((expression), #expression, __FILE__, __LINE__)
+
+#define CHECK_EQUAL(expected, actual) \
+	HostTest::check((expected) == (actual), #expected " == " #actual, __FILE__, __LINE__)
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#ifdef HOST_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include <lib/crypto/base64.h>
+#include <lib/crypto/salsa20.h>
+#include <lib/crypto/chacha20.h>
+#include <keepass/keepass_crypto.h>
+
+#include "kdbx_writer.h"
+
+using namespace KeepAss;
+
+namespace HostKdbx {
+
+namespace {
+	const uint8_t AES_CIPHER_ID[16] = {
+		0x31, 0xC1, 0xF2, 0xE6, 0xBF, 0x71, 0x43, 0x50,
+		0xBE, 0x58, 0x05, 0x21, 0x6A, 0xFC, 0x5A, 0xFF
+	};
+	const uint8_t IV_SALSA[8] = {0xE8, 0x30, 0x09, 0x4B, 0x97, 0x20, 0x5D, 0x2A};
+	const uint32_t FILE_VERSION = 0x00030001;
+
+	// Deterministic bytes, every corpus is the same on every run
+	class Random {
+	public:
+		explicit Random(uint32_t seed) : _state(seed * 2654435761u + 1) { }
+
+		uint32_t next() {
+			_state ^= _state << 13;
+			_state ^= _state >> 17;
+			_state ^= _state << 5;
+			return _state;
+		}
+
+		void fill(uint8_t* data, size_t length) {
+			for (size_t i = 0; i < length; ++i) {
+				data[i] = next() >> 24;
+			}
+		}
+
+	private:
+		uint32_t _state;
+	};
+
+	class InnerStream {
+	public:
+		InnerStream(InnerRandomStream algorithm, const uint8_t* protectedStreamKey) :
+			_algorithm(algorithm),
+			_pos(sizeof(_block))
+		{
+			if (_algorithm == CHACHA20_STREAM) {
+				uint8_t hash[64];
+				KeePassCrypto::evalSHA512(protectedStreamKey, HASH_LENGTH, hash);
+				_chacha.setKey(&hash[0]);
+				_chacha.setIv(&hash[ChaCha20::KEY_SIZE]);
+			}
+			else {
+				uint8_t hash[HASH_LENGTH];
+				KeePassCrypto::evalSHA256(protectedStreamKey, HASH_LENGTH, hash);
+				_salsa.setKey(hash);
+				_salsa.setIv(IV_SALSA);
+			}
+		}
+
+		std::string encrypt(const std::string& value) {
+			std::string result = value;
+			for (char& symbol : result) {
+				if (_pos == sizeof(_block)) {
+					if (_algorithm == CHACHA20_STREAM) {
+						_chacha.generateKeyStream(_block);
+					}
+					else {
+						_salsa.generateKeyStream(_block);
+					}
+					_pos = 0;
+				}
+				symbol ^= _block[_pos++];
+			}
+			return result;
+		}
+
+	private:
+		InnerRandomStream _algorithm;
+		Salsa20 _salsa;
+		ChaCha20 _chacha;
+		uint8_t _block[64];
+		size_t _pos;
+	};
+
+	std::string escape(const std::string& text) {
+		std::string result;
+		for (char symbol : text) {
+			switch (symbol) {
+				case '&': result += "&amp;"; break;
+				case '<': result += "&lt;"; break;
+				case '>': result += "&gt;"; break;
+				case '"': result += "&quot;"; break;
+				default: result += symbol; break;
+			}
+		}
+		return result;
+	}
+
+	std::string uuid(Random& random) {
+		uint8_t bytes[16];
+		std::string encoded;
+		random.fill(bytes, sizeof(bytes));
+		Base64::Encode(std::string(bytes, bytes + sizeof(bytes)), &encoded);
+		return encoded;
+	}
+
+	const char* TIMES =
+			"<Times><CreationTime>2016-09-01T10:00:00Z</CreationTime>"
+			"<LastModificationTime>2016-09-01T10:00:00Z</LastModificationTime>"
+			"<LastAccessTime>2016-09-01T10:00:00Z</LastAccessTime>"
+			"<ExpiryTime>2016-09-01T10:00:00Z</ExpiryTime><Expires>False</Expires>"
+			"<UsageCount>0</UsageCount></Times>";
+
+	class XmlWriter {
+	public:
+		XmlWriter(const Options& options, const uint8_t* protectedStreamKey) :
+			_options(options),
+			_stream(options.innerStream, protectedStreamKey),
+			_random(options.seed)
+		{ }
+
+		std::string write(const Group& root) {
+			_xml = "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>\n"
+				   "<KeePassFile>\n\t<Meta>\n"
+				   "\t\t<Generator>KeePass</Generator>\n"
+				   "\t\t<DatabaseName>Host</DatabaseName>\n"
+				   "\t\t<MemoryProtection><ProtectPassword>True</ProtectPassword>"
+				   "</MemoryProtection>\n"
+				   "\t</Meta>\n\t<Root>\n";
+			_writeGroup(root, "\t\t");
+			_xml += "\t\t<DeletedObjects />\n\t</Root>\n</KeePassFile>";
+			return _xml;
+		}
+
+	private:
+		const Options& _options;
+		InnerStream _stream;
+		Random _random;
+		std::string _xml;
+
+		void _writeString(const std::string& indent, const char* key,
+						  const std::string& value, bool isProtected)
+		{
+			_xml += indent + "<String><Key>" + key + "</Key>";
+			if (isProtected) {
+				std::string encoded;
+				Base64::Encode(_stream.encrypt(value), &encoded);
+				_xml += "<Value Protected=\"True\">" + encoded + "</Value>";
+			}
+			else if (value.empty()) {
+				_xml += "<Value />";
+			}
+			else {
+				_xml += "<Value>" + escape(value) + "</Value>";
+			}
+			_xml += "</String>\n";
+		}
+
+		void _writeEntry(const Entry& entry, const std::string& indent, bool isHistory) {
+			std::string inner = indent + "\t";
+
+			_xml += indent + "<Entry>\n";
+			_xml += inner + "<UUID>" + uuid(_random) + "</UUID>\n";
+			_xml += inner + "<IconID>0</IconID>\n";
+			_xml += inner + TIMES + "\n";
+			_writeString(inner, "Notes", entry.notes, false);
+			_writeString(inner, "Password", entry.password, _options.isPasswordProtected);
+			_writeString(inner, "Title", entry.title, false);
+			_writeString(inner, "URL", "https://" + entry.title + ".example", false);
+			_writeString(inner, "UserName", entry.login, false);
+
+			_xml += inner + "<AutoType><Enabled>True</Enabled>"
+					"<DataTransferObfuscation>0</DataTransferObfuscation>";
+			if (!entry.sequence.empty()) {
+				_xml += "<DefaultSequence>" + escape(entry.sequence) + "</DefaultSequence>";
+			}
+			_xml += "</AutoType>\n";
+
+			// History moves the inner stream too, but isn't indexed
+			if (!isHistory) {
+				_xml += inner + "<History>\n";
+				if ((_random.next() & 7) == 0) {
+					Entry old = entry;
+					old.password += "-old";
+					_writeEntry(old, inner + "\t", true);
+				}
+				_xml += inner + "</History>\n";
+			}
+			_xml += indent + "</Entry>\n";
+		}
+
+		void _writeGroup(const Group& group, const std::string& indent) {
+			std::string inner = indent + "\t";
+
+			_xml += indent + "<Group>\n";
+			_xml += inner + "<UUID>" + uuid(_random) + "</UUID>\n";
+			_xml += inner + "<Name>" + escape(group.name) + "</Name>\n";
+			_xml += inner + "<Notes />\n";
+			_xml += inner + "<IconID>48</IconID>\n";
+			_xml += inner + TIMES + "\n";
+			_xml += inner + "<IsExpanded>True</IsExpanded>\n";
+			if (!group.sequence.empty()) {
+				_xml += inner + "<DefaultAutoTypeSequence>" + escape(group.sequence) +
+						"</DefaultAutoTypeSequence>\n";
+			}
+			_xml += inner + "<EnableAutoType>null</EnableAutoType>\n";
+
+			for (const Entry& entry : group.entries) {
+				_writeEntry(entry, inner, false);
+			}
+			for (const Group& child : group.groups) {
+				_writeGroup(child, inner);
+			}
+			_xml += indent + "</Group>\n";
+		}
+	};
+
+	void appendField(std::vector<uint8_t>& file, HeaderFieldName name,
+					 const void* data, uint16_t size)
+	{
+		file.push_back(name);
+		file.push_back(size & 0xFF);
+		file.push_back(size >> 8);
+		file.insert(file.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+	}
+
+	template<typename T>
+	void appendValue(std::vector<uint8_t>& data, T value) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	std::vector<uint8_t> gzip(const std::string& data) {
+#ifdef HOST_HAS_ZLIB
+		z_stream stream;
+		std::memset(&stream, 0, sizeof(stream));
+		deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+		std::vector<uint8_t> result(deflateBound(&stream, data.size()) + 64);
+		stream.next_in = (Bytef*)data.data();
+		stream.avail_in = data.size();
+		stream.next_out = result.data();
+		stream.avail_out = result.size();
+		deflate(&stream, Z_FINISH);
+		result.resize(stream.total_out);
+		deflateEnd(&stream);
+		return result;
+#else
+		return std::vector<uint8_t>(data.begin(), data.end());
+#endif
+	}
+
+	void encryptCbc(uint8_t* key, const uint8_t* iv, std::vector<uint8_t>& data) {
+		uint8_t previous[AES_BLOCK_SIZE_IN_BYTES];
+		std::memcpy(previous, iv, sizeof(previous));
+
+		for (size_t offset = 0; offset < data.size(); offset += AES_BLOCK_SIZE_IN_BYTES) {
+			uint8_t* block = &data[offset];
+			for (size_t i = 0; i < AES_BLOCK_SIZE_IN_BYTES; ++i) {
+				block[i] ^= previous[i];
+			}
+			KeePassCrypto::encrypt_AES_EBC(key, block, AES_BLOCK_SIZE_IN_BYTES, 1);
+			std::memcpy(previous, block, sizeof(previous));
+		}
+	}
+}
+
+bool hasGzip()
+{
+#ifdef HOST_HAS_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+std::string makeXml(const Group& root, const Options& options,
+					const uint8_t* protectedStreamKey)
+{
+	XmlWriter writer(options, protectedStreamKey);
+	return writer.write(root);
+}
+
+std::vector<uint8_t> write(const Group& root, const std::string& password,
+						   const Options& options)
+{
+	Random random(options.seed);
+	uint8_t masterSeed[32], transformSeed[32], iv[16], protectedStreamKey[32], startBytes[32];
+	random.fill(masterSeed, sizeof(masterSeed));
+	random.fill(transformSeed, sizeof(transformSeed));
+	random.fill(iv, sizeof(iv));
+	random.fill(protectedStreamKey, sizeof(protectedStreamKey));
+	random.fill(startBytes, sizeof(startBytes));
+
+	std::vector<uint8_t> file;
+	appendValue(file, SIGNATURE_1);
+	appendValue(file, SIGNATURE_2_2X_POST_RELEASE);
+	appendValue(file, FILE_VERSION);
+
+	uint32_t compression = options.isGzip ? GZIP_COMPRESSION : NO_COMPRESSION;
+	uint32_t innerStream = options.innerStream;
+	appendField(file, CIPHER_ID, AES_CIPHER_ID, sizeof(AES_CIPHER_ID));
+	appendField(file, COMPRESSION_FLAGS, &compression, sizeof(compression));
+	appendField(file, MASTER_SEED, masterSeed, sizeof(masterSeed));
+	appendField(file, TRANSFORM_SEED, transformSeed, sizeof(transformSeed));
+	appendField(file, TRANSFORM_ROUNDS, &options.rounds, sizeof(options.rounds));
+	appendField(file, ENCRYPTION_IV, iv, sizeof(iv));
+	appendField(file, PROTECTED_STREAM_KEY, protectedStreamKey, sizeof(protectedStreamKey));
+	appendField(file, STREAM_START_BYTES, startBytes, sizeof(startBytes));
+	appendField(file, INNER_RANDOM_STREAM_ID, &innerStream, sizeof(innerStream));
+	appendField(file, END_OF_HEADER, "\r\n\r\n", 4);
+
+	// Master key: SHA256(seed || SHA256(AES-KDF(SHA256(SHA256(password)))))
+	uint8_t key[HASH_LENGTH];
+	uint8_t transformed[HASH_LENGTH];
+	KeePassCrypto::evalSHA256((const uint8_t*)password.data(), password.size(), key);
+	KeePassCrypto::evalSHA256(key, HASH_LENGTH, transformed);
+	KeePassCrypto::encrypt_AES_EBC(transformSeed, transformed, HASH_LENGTH, options.rounds);
+
+	uint8_t finalKey[MASTER_KEY_LENGTH_2X];
+	std::memcpy(finalKey, masterSeed, sizeof(masterSeed));
+	KeePassCrypto::evalSHA256(transformed, HASH_LENGTH, &finalKey[sizeof(masterSeed)]);
+	KeePassCrypto::evalSHA256(finalKey, sizeof(finalKey), key);
+
+	std::string xml = makeXml(root, options, protectedStreamKey);
+	std::vector<uint8_t> content = options.isGzip ?
+			gzip(xml) : std::vector<uint8_t>(xml.begin(), xml.end());
+
+	std::vector<uint8_t> payload(startBytes, startBytes + sizeof(startBytes));
+	uint32_t blockId = 0;
+	for (size_t offset = 0; offset < content.size(); offset += options.blockSize) {
+		uint32_t length = std::min<size_t>(options.blockSize, content.size() - offset);
+		uint8_t hash[HASH_LENGTH];
+
+		KeePassCrypto::evalSHA256(&content[offset], length, hash);
+		appendValue(payload, blockId++);
+		payload.insert(payload.end(), hash, hash + HASH_LENGTH);
+		appendValue(payload, length);
+		payload.insert(payload.end(), &content[offset], &content[offset] + length);
+	}
+
+	// The last block has zero size and zero hash
+	uint8_t zeroHash[HASH_LENGTH] = {0};
+	appendValue(payload, blockId);
+	payload.insert(payload.end(), zeroHash, zeroHash + HASH_LENGTH);
+	appendValue(payload, (uint32_t)0);
+
+	uint8_t padding = AES_BLOCK_SIZE_IN_BYTES - (payload.size() % AES_BLOCK_SIZE_IN_BYTES);
+	payload.insert(payload.end(), padding, padding);
+
+	encryptCbc(key, iv, payload);
+	file.insert(file.end(), payload.begin(), payload.end());
+	return file;
+}
+
+Group makeCorpus(size_t entriesCount, size_t notesLength, uint32_t seed)
+{
+	static const char* WORDS[] = {
+		"mail", "bank", "Work", "home", "git", "Server", "shop", "forum",
+		"cloud", "VPN", "router", "wiki", "Backup", "games", "travel", "tax"
+	};
+	const size_t WORDS_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+	const size_t ENTRIES_PER_GROUP = 24;
+
+	Random random(seed);
+	Group root;
+	root.name = "Root";
+
+	// Groups are two levels deep, as in a usual database
+	bool isSubgroup = false;
+	for (size_t i = 0; i < entriesCount; ++i) {
+		if (i % ENTRIES_PER_GROUP == 0) {
+			size_t number = i / ENTRIES_PER_GROUP;
+			isSubgroup = (number % 4 != 0);
+			if (isSubgroup) {
+				root.groups.back().groups.push_back(Group());
+				root.groups.back().groups.back().name =
+						std::string(WORDS[(number * 7) % WORDS_COUNT]) + " " + std::to_string(number);
+			}
+			else {
+				root.groups.push_back(Group());
+				root.groups.back().name = WORDS[number % WORDS_COUNT];
+			}
+		}
+		Group& group = isSubgroup ? root.groups.back().groups.back() : root.groups.back();
+
+		Entry entry;
+		entry.title = std::string(WORDS[random.next() % WORDS_COUNT]) + std::to_string(i);
+		entry.login = "user" + std::to_string(random.next() % 1000) + "@example.com";
+		entry.password.resize(8 + random.next() % 24);
+		for (char& symbol : entry.password) {
+			symbol = '!' + random.next() % ('~' - '!');
+		}
+		entry.notes.resize(notesLength);
+		for (char& symbol : entry.notes) {
+			symbol = 'a' + random.next() % 26;
+		}
+		if (i % 10 == 0) {
+			entry.sequence = "{USERNAME}{TAB}{PASSWORD}{ENTER}";
+		}
+		group.entries.push_back(entry);
+	}
+
+	return root;
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_KDBX_WRITER_H
+#define HOST_KDBX_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <keepass/keepass_reader_defines.h>
+
+// Writer of KeePass 2.x (KDBX 3.1) files for host tests. Protected
+// values are encrypted by the inner stream in document order, the
+// payload is split into hashed blocks and encrypted with AES-256-CBC.
+namespace HostKdbx {
+	struct Entry {
+		std::string title;
+		std::string login;
+		std::string password;
+		std::string sequence;
+		std::string notes;
+	};
+
+	struct Group {
+		std::string name;
+		std::string sequence;
+		std::vector<Entry> entries;
+		std::vector<Group> groups;
+	};
+
+	struct Options {
+		uint64_t rounds = 100;
+		bool isGzip = false;
+		bool isPasswordProtected = true;
+		KeepAss::InnerRandomStream innerStream = KeepAss::SALSA20_STREAM;
+		uint32_t blockSize = 1024 * 1024;
+		uint32_t seed = 1;
+	};
+
+	// True when gzip is compiled in (zlib found on the host)
+	bool hasGzip();
+
+	std::string makeXml(const Group& root, const Options& options,
+						const uint8_t* protectedStreamKey);
+
+	std::vector<uint8_t> write(const Group& root, const std::string& password,
+							   const Options& options);
+
+	// Generated database of entriesCount entries in nested groups,
+	// every entry has notes of notesLength chars like real databases do
+	Group makeCorpus(size_t entriesCount, size_t notesLength, uint32_t seed);
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <utility>
+
+#include <keys/Key.h>
+
+#include "report_stream.h"
+
+using namespace UsbPackages;
+
+namespace HostReports {
+	namespace {
+		using KeyCode = std::pair<uint8_t, bool>;
+
+		const uint8_t SHIFT_MASK = static_cast<uint8_t>(UsbSpecialKey::LEFT_SHIFT) |
+								   static_cast<uint8_t>(UsbSpecialKey::RIGHT_SHIFT);
+
+		// Printable chars are found by the keys they are typed with
+		const std::map<KeyCode, char>& getChars()
+		{
+			static std::map<KeyCode, char> chars;
+			if (!chars.empty()) {
+				return chars;
+			}
+
+			for (int symbol = ' '; symbol <= '~'; ++symbol) {
+				Key key(static_cast<AsciiCodeType>(symbol));
+				bool isShifted = (key.getUsbKeyModifier().getMask() & SHIFT_MASK) != 0;
+				chars.insert({KeyCode(key.getUsbKeyCode(), isShifted), (char)symbol});
+			}
+			return chars;
+		}
+
+		bool isHeld(const UsbPackage& report, UsbKey key)
+		{
+			for (UsbKey held : report.key) {
+				if (held == key) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		char getChar(UsbKey key, bool isShifted)
+		{
+			switch (key) {
+				case UsbKey::KEY_TAB:
+					return '\t';
+				case UsbKey::KEY_ENTER:
+					return '\n';
+				case UsbKey::KEY_BACKSPACE:
+					return '\b';
+				default:
+				break;
+			}
+
+			const std::map<KeyCode, char>& chars = getChars();
+			auto found = chars.find(KeyCode(static_cast<uint8_t>(key), isShifted));
+			return ((found == chars.end()) ? '?' : found->second);
+		}
+	}
+
+	size_t drain(Ring& ring, Reports& reports, size_t maxCount, bool isBitmap)
+	{
+		size_t count = 0;
+
+		while (count < maxCount) {
+			if (ring.dropCanceled()) {
+				reports.push_back(ZERO_PACKAGE);
+				count++;
+				continue;
+			}
+			if (ring.empty()) {
+				break;
+			}
+
+			TypingJob& job = ring.front();
+			reports.push_back(job.getPackage());
+			count++;
+
+			job.next(isBitmap);
+			if (job.isDone()) {
+				ring.pop_front();
+			}
+		}
+
+		return count;
+	}
+
+	std::string decode(const Reports& reports)
+	{
+		std::string text;
+		UsbPackage previous = ZERO_PACKAGE;
+
+		for (const UsbPackage& report : reports) {
+			decode(previous, report, text);
+			previous = report;
+		}
+
+		return text;
+	}
+
+	void decode(const UsbPackage& previous, const UsbPackage& report, std::string& text)
+	{
+		bool isShifted = (report.special.getMask() & SHIFT_MASK) != 0;
+
+		for (UsbKey key : report.key) {
+			if (key != UsbKey::NOT_A_KEY && key != UsbKey::KEY_SCROLL_LOCK &&
+				!isHeld(previous, key))
+			{
+				text += getChar(key, isShifted);
+			}
+		}
+	}
+
+	bool isReleased(const Reports& reports)
+	{
+		return (reports.empty() || reports.back() == ZERO_PACKAGE);
+	}
+}
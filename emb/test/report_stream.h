@@ -0,0 +1,58 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_REPORT_STREAM_H
+#define HOST_REPORT_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <usb_ring.h>
+
+// Keyboard reports of the typing jobs as the HID endpoint sends them,
+// and the text the host gets from them.
+namespace HostReports {
+	using Ring = UsbPackages::UsbRingStandart;
+	using Reports = std::vector<UsbPackages::UsbPackage>;
+
+	// Reports of committed jobs are appended until the ring is empty or
+	// maxCount reports are sent. Canceled jobs are dropped and released
+	// by an empty report, as the endpoint does. Sent count is returned.
+	size_t drain(Ring& ring, Reports& reports, size_t maxCount = SIZE_MAX,
+				 bool isBitmap = false);
+
+	// Key is typed when it's pressed: Tab, Enter and Backspace
+	// are '\t', '\n' and '\b', other control keys are '?'.
+	// Scroll Lock is the pacer's probe, it isn't typed.
+	std::string decode(const Reports& reports);
+	void decode(const UsbPackages::UsbPackage& previous,
+				const UsbPackages::UsbPackage& report, std::string& text);
+
+	// All keys are released by the last report
+	bool isReleased(const Reports& reports);
+}
+
+#endif
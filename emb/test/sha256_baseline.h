@@ -0,0 +1,31 @@
+/*
+ * cifra - embedded cryptography library
+ * Written in 2014 by Joseph Birr-Pixton <jpixton@gmail.com>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to the
+ * public domain worldwide. This software is distributed without any
+ * warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software. If not, see
+ * <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+#ifndef SHA256_BASELINE_H
+#define SHA256_BASELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sha2.h>
+
+/* Update of the original cifra SHA-256, one block at a time */
+void baseline_sha256_update(cf_sha256_context *ctx, const void *data, size_t nbytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
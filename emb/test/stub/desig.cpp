@@ -0,0 +1,41 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/desig.h>
+
+static uint32_t unique_id[3] = {0x00440021, 0x34365101, 0x30353236};
+
+void desig_get_unique_id(uint32_t *result)
+{
+	result[0] = unique_id[0];
+	result[1] = unique_id[1];
+	result[2] = unique_id[2];
+}
+
+void host_set_unique_id(uint32_t word0, uint32_t word1, uint32_t word2)
+{
+	unique_id[0] = word0;
+	unique_id[1] = word1;
+	unique_id[2] = word2;
+}
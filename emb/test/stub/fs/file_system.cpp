@@ -0,0 +1,98 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fs/file_system.h>
+
+static std::map<std::string, std::vector<uint8_t>> files;
+static std::map<const FIL*, const std::vector<uint8_t>*> opened;
+static uint32_t write_count = 0;
+static uint32_t read_count = 0;
+
+FRESULT FileSystem::open_file_to_read(FIL *file, const char *name)
+{
+	auto found = files.find(name);
+	if (found == files.end()) {
+		return (FR_NO_FILE);
+	}
+
+	memset(file, 0, sizeof(FIL));
+	file->fsize = found->second.size();
+	opened[file] = &found->second;
+	return (FR_OK);
+}
+
+FRESULT FileSystem::close_file(FIL *file)
+{
+	return ((opened.erase(file) == 1) ? FR_OK : FR_INVALID_OBJECT);
+}
+
+FRESULT FileSystem::read_next_file_chunk(FIL *file, void *buffer, uint32_t size)
+{
+	auto found = opened.find(file);
+	if (found == opened.end()) {
+		return (FR_INVALID_OBJECT);
+	}
+
+	// As f_read() does, the end of file only shortens the read
+	const std::vector<uint8_t>& data = *found->second;
+	if (file->fptr + size > data.size()) {
+		size = data.size() - file->fptr;
+	}
+
+	memcpy(buffer, data.data() + file->fptr, size);
+	file->fptr += size;
+	read_count++;
+	return (FR_OK);
+}
+
+uint32_t FileSystem::get_file_tell(FIL *file)
+{
+	return (file->fptr);
+}
+
+uint32_t FileSystem::get_write_count()
+{
+	return (write_count);
+}
+
+void FileSystem::host_write_file(const char *name, const uint8_t *data, uint32_t size)
+{
+	files[name].assign(data, data + size);
+	write_count++;
+}
+
+void FileSystem::host_remove_file(const char *name)
+{
+	files.erase(name);
+	write_count++;
+}
+
+uint32_t FileSystem::host_get_read_count()
+{
+	return (read_count);
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOST_FILE_SYSTEM_H
+#define HOST_FILE_SYSTEM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fs/fatfs/ff.h>
+
+// Host replacement of the flash file system: files are kept
+// in memory, only the read interface of the device is provided.
+class FileSystem
+{
+public:
+	static FRESULT open_file_to_read(FIL *file, const char *name);
+	static FRESULT close_file(FIL *file);
+	static FRESULT read_next_file_chunk(FIL *file, void *buffer, uint32_t size);
+	static uint32_t get_file_tell(FIL *file);
+	static uint32_t get_write_count();
+
+	// Test side, every write is counted as the mass storage would do
+	static void host_write_file(const char *name, const uint8_t *data, uint32_t size);
+	static void host_remove_file(const char *name);
+	static uint32_t host_get_read_count();
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "systick_ext.h"
+
+static uint32_t counter_ms = 0;
+static uint32_t step_ms = 0;
+
+void delay_ms(uint32_t ms)
+{
+	counter_ms += ms;
+}
+
+uint32_t get_counter_ms()
+{
+	uint32_t now = counter_ms;
+	counter_ms += step_ms;
+	return (now);
+}
+
+void host_set_counter_ms(uint32_t ms)
+{
+	counter_ms = ms;
+}
+
+void host_advance_counter_ms(uint32_t ms)
+{
+	counter_ms += ms;
+}
+
+void host_set_counter_step(uint32_t ms)
+{
+	step_ms = ms;
+}
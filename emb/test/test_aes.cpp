@@ -0,0 +1,136 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <keepass/keepass_aes.h>
+
+#include "host_test.h"
+
+using namespace KeepAss;
+
+// FIPS-197 and SP 800-38A vectors for both software backends,
+// the constant-time one is also compared with the table one.
+namespace {
+	std::vector<uint8_t> hex(const char* text)
+	{
+		std::vector<uint8_t> bytes;
+		for (size_t i = 0; text[i] != '\0' && text[i + 1] != '\0'; i += 2) {
+			char byte[3] = {text[i], text[i + 1], '\0'};
+			bytes.push_back((uint8_t)std::strtoul(byte, nullptr, 16));
+		}
+		return bytes;
+	}
+
+	std::vector<uint8_t> random(size_t length, uint32_t& seed)
+	{
+		std::vector<uint8_t> bytes(length);
+		for (uint8_t& byte : bytes) {
+			seed = seed * 1103515245 + 12345;
+			byte = seed >> 16;
+		}
+		return bytes;
+	}
+
+	const char* SP800_KEY = "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4";
+	const char* SP800_IV = "000102030405060708090a0b0c0d0e0f";
+	const char* SP800_PLAIN =
+			"6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+			"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+	const char* SP800_CBC =
+			"f58c4c04d6e5f1ba779eabfb5f7bfbd69cfc4e967edb808d679f777bc6702c7d"
+			"39f23369a9d9bacfa530e26304231461b2eb05e2c39be9fcda6c19078c6a9d1b";
+	const char* SP800_ECB =
+			"f3eed1bdb5d2a03c064b5a7e3db181f8591ccb10d410ed26dc5ba74a31362870"
+			"b6ed21b99ca6f4f9f153e7b1beafed1d23304b7a39f9f3ff067d8d8f9e24ecc7";
+
+	template<typename Aes>
+	void checkVectors()
+	{
+		std::vector<uint8_t> key = hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+		std::vector<uint8_t> block = hex("00112233445566778899aabbccddeeff");
+
+		// Single block goes without a pair in the bit-sliced backend
+		Aes::encrypt_ECB(key.data(), block.data(), block.size(), 1);
+		CHECK(block == hex("8ea2b7ca516745bfeafc49904b496089"));
+
+		key = hex(SP800_KEY);
+		std::vector<uint8_t> iv = hex(SP800_IV);
+
+		for (size_t blocks = 1; blocks <= 4; ++blocks) {
+			std::vector<uint8_t> plain = hex(SP800_PLAIN);
+			plain.resize(blocks * 16);
+			std::vector<uint8_t> ecb = hex(SP800_ECB);
+			ecb.resize(blocks * 16);
+			std::vector<uint8_t> cbc = hex(SP800_CBC);
+			cbc.resize(blocks * 16);
+
+			std::vector<uint8_t> data = plain;
+			Aes::encrypt_ECB(key.data(), data.data(), data.size(), 1);
+			CHECK(data == ecb);
+
+			Aes::decrypt_CBC(key.data(), iv.data(), cbc.data(), cbc.size());
+			CHECK(cbc == plain);
+		}
+
+		// Cached schedule is rebuilt after wipe
+		Aes::wipe();
+		std::vector<uint8_t> data = hex(SP800_PLAIN);
+		Aes::encrypt_ECB(key.data(), data.data(), data.size(), 1);
+		CHECK(data == hex(SP800_ECB));
+	}
+
+	void checkBackendsMatch()
+	{
+		uint32_t seed = 5;
+
+		for (int i = 0; i < 32; ++i) {
+			std::vector<uint8_t> key = random(32, seed);
+			std::vector<uint8_t> iv = random(16, seed);
+			std::vector<uint8_t> data = random(16 * (1 + i % 9), seed);
+
+			// Key transformation of KeePass: two blocks, many rounds
+			std::vector<uint8_t> table = data;
+			std::vector<uint8_t> sliced = data;
+			KeePassAesSoftware::encrypt_ECB(key.data(), table.data(), table.size(), 1 + i * 37);
+			KeePassAesBitsliced::encrypt_ECB(key.data(), sliced.data(), sliced.size(), 1 + i * 37);
+			CHECK(table == sliced);
+
+			KeePassAesSoftware::decrypt_CBC(key.data(), iv.data(), table.data(), table.size());
+			KeePassAesBitsliced::decrypt_CBC(key.data(), iv.data(), sliced.data(), sliced.size());
+			CHECK(table == sliced);
+		}
+	}
+}
+
+int main()
+{
+	checkVectors<KeePassAesSoftware>();
+	checkVectors<KeePassAesBitsliced>();
+	checkBackendsMatch();
+
+	return HostTest::exit();
+}
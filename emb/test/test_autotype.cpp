@@ -0,0 +1,282 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <AutoType.h>
+
+#include "host_test.h"
+#include "report_stream.h"
+#include "systick_ext.h"
+
+using namespace Logic;
+
+// Auto-Type sequences typed into the report ring: the text the host
+// gets, delays, limits of arguments, refused sequences and abort.
+namespace {
+	const char* PASSWORD = "Secret password, 40 chars long........!";
+
+	// Password the callback reveals, by parts of the runner's buffer
+	std::string password = PASSWORD;
+	bool isRevealFailing = false;
+	uint8_t* revealedBuffer = nullptr;
+	size_t revealsCount = 0;
+
+	bool reveal(const DB::Entry&, size_t position, uint8_t* buffer, size_t size,
+				size_t* length)
+	{
+		revealedBuffer = buffer;
+		revealsCount++;
+
+		*length = 0;
+		if (isRevealFailing) {
+			return false;
+		}
+		if (position < password.size()) {
+			*length = std::min(password.size() - position, size);
+			std::memcpy(buffer, &password[position], *length);
+		}
+		return true;
+	}
+
+	DB::Entry makeEntry()
+	{
+		DB::Entry entry;
+		entry.setName((const uint8_t*)"Mail", 4);
+		entry.setLogin((const uint8_t*)"User.Name@example.com", 21);
+		return entry;
+	}
+
+	bool compile(AutoTypeProgram& program, const char* sequence)
+	{
+		return program.compile(DB::StringField((const uint8_t*)sequence, std::strlen(sequence)));
+	}
+
+	bool isWiped()
+	{
+		for (size_t i = 0; i < AutoTypeRunner::PASSWORD_PART_LENGTH; ++i) {
+			if (revealedBuffer[i] != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string type(const char* sequence, HostReports::Reports& reports)
+	{
+		HostReports::Ring ring;
+		UsbPackages::PackageFactory factory(&ring);
+		AutoTypeRunner runner(&factory, AutoTypeRunner::PasswordCallback(&reveal));
+		AutoTypeProgram program;
+		DB::Entry entry = makeEntry();
+
+		CHECK(compile(program, sequence));
+		runner.start(program, entry);
+		while (runner.isRunning()) {
+			runner.process();
+			HostReports::drain(ring, reports);
+			host_advance_counter_ms(1);
+		}
+
+		return HostReports::decode(reports);
+	}
+
+	void checkStreams()
+	{
+		HostReports::Reports reports;
+		CHECK(type("{USERNAME}{TAB}{PASSWORD}{ENTER}", reports) ==
+			  std::string("User.Name@example.com\t") + PASSWORD + "\n");
+		CHECK(HostReports::isReleased(reports));
+		CHECK(isWiped());
+
+		reports.clear();
+		CHECK(type("{TITLE} {tab 3}x~{{}{}}{BS 2}", reports) == "Mail \t\t\tx\n{}\b\b");
+		CHECK(HostReports::isReleased(reports));
+
+		// Keys go as [release, press] pairs, same key twice is released between
+		reports.clear();
+		CHECK(type("ll{ENTER 2}", reports) == "ll\n\n");
+		CHECK_EQUAL(UsbPackages::ZERO_PACKAGE, reports[2]);
+	}
+
+	void checkLongPassword()
+	{
+		// Longer than the buffer, typed by parts which are wiped in turn
+		password.clear();
+		for (size_t i = 0; i < 1000; ++i) {
+			password += (char)('!' + i % 94);
+		}
+		revealsCount = 0;
+
+		HostReports::Reports reports;
+		CHECK(type("{PASSWORD}{ENTER}", reports) == password + "\n");
+		CHECK(HostReports::isReleased(reports));
+		CHECK(isWiped());
+
+		size_t partsCount = (password.size() + AutoTypeRunner::PASSWORD_PART_LENGTH - 1) /
+							AutoTypeRunner::PASSWORD_PART_LENGTH;
+		CHECK_EQUAL(partsCount + 1, revealsCount);
+
+		// Empty password is typed as nothing
+		password.clear();
+		reports.clear();
+		CHECK(type("{PASSWORD}{ENTER}", reports) == "\n");
+
+		password = PASSWORD;
+	}
+
+	void checkRevealError()
+	{
+		HostReports::Ring ring;
+		UsbPackages::PackageFactory factory(&ring);
+		AutoTypeRunner runner(&factory, AutoTypeRunner::PasswordCallback(&reveal));
+		AutoTypeProgram program;
+		DB::Entry entry = makeEntry();
+		HostReports::Reports reports;
+
+		// Form isn't submitted with a blank password
+		CHECK(compile(program, "{USERNAME}{TAB}{PASSWORD}{ENTER}"));
+		isRevealFailing = true;
+		runner.start(program, entry);
+		while (runner.isRunning()) {
+			runner.process();
+			HostReports::drain(ring, reports);
+		}
+		isRevealFailing = false;
+
+		CHECK(runner.isFailed());
+		CHECK(HostReports::decode(reports) == "User.Name@example.com\t");
+		CHECK(HostReports::isReleased(reports));
+
+		// Next program starts clean
+		reports.clear();
+		CHECK(compile(program, "{PASSWORD}"));
+		runner.start(program, entry);
+		while (runner.isRunning()) {
+			runner.process();
+			HostReports::drain(ring, reports);
+		}
+		CHECK(!runner.isFailed());
+		CHECK(HostReports::decode(reports) == PASSWORD);
+	}
+
+	void checkDelay()
+	{
+		HostReports::Ring ring;
+		UsbPackages::PackageFactory factory(&ring);
+		AutoTypeRunner runner(&factory, AutoTypeRunner::PasswordCallback(&reveal));
+		AutoTypeProgram program;
+		DB::Entry entry = makeEntry();
+		HostReports::Reports reports;
+
+		CHECK(compile(program, "a{DELAY 300}b"));
+		host_set_counter_ms(1000);
+		runner.start(program, entry);
+
+		runner.process();
+		HostReports::drain(ring, reports);
+		CHECK(HostReports::decode(reports) == "a");
+
+		// Delay is counted from the moment the reports are sent
+		runner.process();
+		host_set_counter_ms(1299);
+		runner.process();
+		HostReports::drain(ring, reports);
+		CHECK(HostReports::decode(reports) == "a");
+		CHECK(runner.isRunning());
+
+		host_set_counter_ms(1300);
+		runner.process();
+		HostReports::drain(ring, reports);
+		runner.process();
+		CHECK(HostReports::decode(reports) == "ab");
+		CHECK(!runner.isRunning());
+	}
+
+	void checkLimits()
+	{
+		AutoTypeProgram program;
+
+		CHECK(compile(program, "{TAB 64}"));
+		CHECK(!compile(program, "{TAB 65}"));
+		CHECK(compile(program, "{DELAY 10000}"));
+		CHECK(!compile(program, "{DELAY 10001}"));
+		CHECK(!compile(program, "{DELAY 99999999}"));
+		CHECK(!compile(program, "{USERNAME 2}"));
+
+		// Modifiers, groups and unknown or broken placeholders are refused
+		CHECK(!compile(program, "^v"));
+		CHECK(!compile(program, "+(ab)"));
+		CHECK(!compile(program, "{CLEARFIELD}"));
+		CHECK(!compile(program, "{TAB"));
+		CHECK(!compile(program, "{DELAY}"));
+		CHECK(!compile(program, ""));
+	}
+
+	void checkAbort()
+	{
+		HostReports::Ring ring;
+		UsbPackages::PackageFactory factory(&ring);
+		AutoTypeRunner runner(&factory, AutoTypeRunner::PasswordCallback(&reveal));
+		AutoTypeProgram program;
+		DB::Entry entry = makeEntry();
+		HostReports::Reports reports;
+
+		CHECK(compile(program, "{PASSWORD}{ENTER}"));
+		runner.start(program, entry);
+		runner.process();
+
+		// Password is being typed, its key is held when it's stopped
+		HostReports::drain(ring, reports, 12);
+		CHECK(reports.back() != UsbPackages::ZERO_PACKAGE);
+		runner.stop();
+		CHECK(!runner.isRunning());
+		CHECK(isWiped());
+
+		HostReports::drain(ring, reports);
+		std::string typed = HostReports::decode(reports);
+		CHECK(typed.size() < 8);
+		CHECK(typed == std::string(PASSWORD).substr(0, typed.size()));
+		CHECK(HostReports::isReleased(reports));
+		CHECK(ring.isIdle());
+
+		// Nothing is left to type
+		runner.process();
+		CHECK_EQUAL(0u, HostReports::drain(ring, reports));
+	}
+}
+
+int main()
+{
+	checkStreams();
+	checkLongPassword();
+	checkRevealError();
+	checkDelay();
+	checkLimits();
+	checkAbort();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <keepass/keepass_crypto.h>
+
+#include "host_test.h"
+
+using namespace KeepAss;
+
+// Known answers of the inner stream ciphers and SHA-512: eSTREAM
+// Salsa20 set 1, RFC 7539 ChaCha20 and FIPS 180-2 SHA-512 vectors.
+// Seeking the inner stream must give the same bytes as reading it.
+namespace {
+	std::vector<uint8_t> hex(const char* text)
+	{
+		std::vector<uint8_t> bytes;
+		for (size_t i = 0; text[i] != '\0' && text[i + 1] != '\0'; i += 2) {
+			char byte[3] = {text[i], text[i + 1], '\0'};
+			bytes.push_back((uint8_t)std::strtoul(byte, nullptr, 16));
+		}
+		return bytes;
+	}
+
+	void checkSalsa20()
+	{
+		std::vector<uint8_t> key(32, 0);
+		key[0] = 0x80;
+		uint8_t iv[Salsa20::IV_SIZE] = {0};
+		uint8_t block[Salsa20::BLOCK_SIZE * 2];
+
+		Salsa20 salsa(key.data());
+		salsa.setIv(iv);
+		salsa.generateKeyStream(block);
+		salsa.generateKeyStream(&block[Salsa20::BLOCK_SIZE]);
+		CHECK(std::memcmp(block, hex(
+				"e3be8fdd8beca2e3ea8ef9475b29a6e7003951e1097a5c38d23b7a5fad9f6844"
+				"b22c97559e2723c7cbbd3fe4fc8d9a0744652a83e72a9c461876af4d7ef1a117").data(),
+				Salsa20::BLOCK_SIZE) == 0);
+
+		uint8_t second[Salsa20::BLOCK_SIZE];
+		salsa.setCounter(1);
+		salsa.generateKeyStream(second);
+		CHECK(std::memcmp(second, &block[Salsa20::BLOCK_SIZE], sizeof(second)) == 0);
+	}
+
+	void checkChaCha20()
+	{
+		std::vector<uint8_t> key = hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+		std::vector<uint8_t> nonce = hex("000000000000004a00000000");
+		std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you "
+						   "only one tip for the future, sunscreen would be it.";
+		std::vector<uint8_t> expected = hex(
+				"6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0b"
+				"f91b65c5524733ab8f593dabcd62b3571639d624e65152ab8f530c359f0861d8"
+				"07ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+				"5af90bbf74a35be6b40b8eedf2785e42874d");
+
+		uint8_t stream[ChaCha20::BLOCK_SIZE * 2];
+		ChaCha20 chacha(key.data());
+		chacha.setIv(nonce.data());
+		chacha.setCounter(1);
+		chacha.generateKeyStream(stream);
+		chacha.generateKeyStream(&stream[ChaCha20::BLOCK_SIZE]);
+
+		CHECK_EQUAL(expected.size(), text.size());
+		for (size_t i = 0; i < text.size(); ++i) {
+			CHECK_EQUAL(expected[i], (uint8_t)(text[i] ^ stream[i]));
+		}
+	}
+
+	void checkSHA512()
+	{
+		uint8_t hash[CF_SHA512_HASHSZ];
+
+		KeePassCrypto::evalSHA512((const uint8_t*)"abc", 3, hash);
+		CHECK(std::memcmp(hash, hex(
+				"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+				"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f").data(),
+				sizeof(hash)) == 0);
+
+		KeePassCrypto::evalSHA512(nullptr, 0, hash);
+		CHECK(std::memcmp(hash, hex(
+				"cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+				"47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e").data(),
+				sizeof(hash)) == 0);
+
+		const char* twoBlocks =
+				"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+				"ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+		KeePassCrypto::evalSHA512((const uint8_t*)twoBlocks, std::strlen(twoBlocks), hash);
+		CHECK(std::memcmp(hash, hex(
+				"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+				"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909").data(),
+				sizeof(hash)) == 0);
+
+		// Updates of odd sizes cross the block boundaries
+		std::vector<uint8_t> million(1000000, 'a');
+		cf_sha512_context ctx;
+		cf_sha512_init(&ctx);
+		for (size_t done = 0; done < million.size(); ) {
+			size_t length = std::min<size_t>(1 + done % 251, million.size() - done);
+			cf_sha512_update(&ctx, &million[done], length);
+			done += length;
+		}
+		cf_sha512_digest_final(&ctx, hash);
+		CHECK(std::memcmp(hash, hex(
+				"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+				"de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b").data(),
+				sizeof(hash)) == 0);
+	}
+
+	void checkInnerStreamSeek(InnerRandomStream algorithm)
+	{
+		uint8_t key[64] = {9, 8, 7};
+		uint8_t iv[16] = {6, 5, 4};
+		std::vector<uint8_t> sequential(3000, 0);
+
+		KeePassCrypto::init_inner_stream(algorithm, key, iv);
+		for (size_t done = 0; done < sequential.size(); done += 37) {
+			KeePassCrypto::eval_inner_stream(&sequential[done],
+					std::min<size_t>(37, sequential.size() - done));
+		}
+
+		const uint32_t OFFSETS[] = {0, 1, 63, 64, 65, 255, 256, 1000, 2999};
+		for (uint32_t offset : OFFSETS) {
+			uint8_t byte = 0;
+			KeePassCrypto::seek_inner_stream(offset);
+			KeePassCrypto::eval_inner_stream(&byte, 1);
+			CHECK_EQUAL(sequential[offset], byte);
+		}
+	}
+}
+
+int main()
+{
+	checkSalsa20();
+	checkChaCha20();
+	checkSHA512();
+	checkInnerStreamSeek(SALSA20_STREAM);
+	checkInnerStreamSeek(CHACHA20_STREAM);
+
+	return HostTest::exit();
+}
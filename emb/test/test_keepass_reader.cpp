@@ -0,0 +1,270 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <keepass/keepass_reader.h>
+
+#include "alloc_stats.h"
+#include "host_test.h"
+#include "kdbx_writer.h"
+#include "systick_ext.h"
+
+using namespace KeepAss;
+
+// Full unlock of generated databases from 10 KB to 4 MB, plain and
+// gzipped: every entry of the store is compared with the source and
+// protected passwords are revealed. Peak heap of the unlock is reported.
+namespace {
+	const char* DB_NAME = "db.kdb";
+	const char* PASSWORD = "corpus password";
+
+	struct Case {
+		size_t entriesCount;
+		bool isGzip;
+		InnerRandomStream innerStream;
+	};
+
+	const Case CASES[] = {
+		{10, false, SALSA20_STREAM},
+		{100, false, SALSA20_STREAM},
+		{1000, false, CHACHA20_STREAM},
+		{3800, false, SALSA20_STREAM},
+		{100, true, CHACHA20_STREAM},
+		{3800, true, SALSA20_STREAM}
+	};
+
+	// Every case gets a new reader, the heap of the previous one is freed
+	KeePassReader* reader = nullptr;
+
+	DecryptionResult unlock(const char* password)
+	{
+		reader->set_password(password, std::strlen(password));
+
+		DecryptionResult result = reader->decrypt_database(DB_NAME);
+		while (result == IN_PROGRESS) {
+			result = reader->continue_decryption();
+		}
+		return result;
+	}
+
+	void collect(const HostKdbx::Group& group, std::vector<const HostKdbx::Entry*>& entries,
+				 size_t& groupsCount)
+	{
+		groupsCount++;
+		for (const HostKdbx::Entry& entry : group.entries) {
+			entries.push_back(&entry);
+		}
+		for (const HostKdbx::Group& child : group.groups) {
+			collect(child, entries, groupsCount);
+		}
+	}
+
+	bool isEqual(const DB::StringField& field, const std::string& text)
+	{
+		return (field.length() == text.size() &&
+				std::memcmp(field.data(), text.data(), text.size()) == 0);
+	}
+
+	void checkStore(const HostKdbx::Group& root)
+	{
+		std::vector<const HostKdbx::Entry*> entries;
+		size_t groupsCount = 0;
+		collect(root, entries, groupsCount);
+
+		const DB::EntryStore* store = reader->get_store();
+		CHECK_EQUAL(entries.size() + groupsCount, store->getNodesCount());
+
+		size_t entry = 0;
+		for (size_t node = 0; node < store->getNodesCount(); ++node) {
+			if (!store->isEntry(node) || entry == entries.size()) {
+				continue;
+			}
+
+			const HostKdbx::Entry& source = *entries[entry++];
+			CHECK(isEqual(store->getName(node), source.title));
+			CHECK(isEqual(store->getLogin(node), source.login));
+
+			if (entry % 97 != 1 && entry != entries.size()) {
+				continue;
+			}
+
+			// Value is revealed into a buffer, the store is left as it is
+			DB::StringField password = store->getPassword(node);
+			std::vector<uint8_t> encoded(password.begin(), password.end());
+			uint8_t value[256];
+			uint32_t length = reader->reveal_protected(password.data(), password.length(),
+													  store->getPasswordOffset(node),
+													  value, sizeof(value));
+			CHECK(store->isPasswordProtected(node));
+			CHECK(length == source.password.size() &&
+				  std::memcmp(value, source.password.data(), length) == 0);
+			CHECK(std::equal(encoded.begin(), encoded.end(), password.begin()));
+
+			// By parts of a small buffer, as Auto-Type does for long values
+			std::string parts;
+			uint32_t partLength = 0;
+			for (uint32_t position = 0; ; position += partLength) {
+				CHECK(reader->reveal_protected_part(password.data(), password.length(),
+													store->getPasswordOffset(node), position,
+													value, 6, &partLength));
+				if (partLength == 0) {
+					break;
+				}
+				parts.append((const char*)value, partLength);
+			}
+			CHECK(parts == source.password);
+			CHECK(!reader->reveal_protected_part(password.data(), password.length(),
+												 store->getPasswordOffset(node), 1,
+												 value, 6, &partLength));
+
+			// Too small buffer gets nothing
+			CHECK_EQUAL(0u, reader->reveal_protected(password.data(), password.length(),
+													 store->getPasswordOffset(node),
+													 value, length - 1));
+		}
+		CHECK_EQUAL(entries.size(), entry);
+	}
+
+	void checkCase(const Case& testCase)
+	{
+		HostKdbx::Options options;
+		options.isGzip = testCase.isGzip;
+		options.innerStream = testCase.innerStream;
+		options.seed = testCase.entriesCount;
+
+		HostKdbx::Group root = HostKdbx::makeCorpus(testCase.entriesCount, 64, options.seed);
+		std::vector<uint8_t> file = HostKdbx::write(root, PASSWORD, options);
+		FileSystem::host_write_file(DB_NAME, file.data(), file.size());
+
+		AllocStats::resetPeak();
+		size_t heapBefore = AllocStats::current();
+		HostTest::Stopwatch stopwatch;
+
+		DecryptionResult result = unlock(PASSWORD);
+		double seconds = stopwatch.seconds();
+		CHECK_EQUAL(SUCCESS, result);
+		if (result != SUCCESS) {
+			return;
+		}
+		checkStore(root);
+
+		size_t storeBytes = reader->get_store()->getUsedMemory();
+		std::printf("%7zu entries %-5s %8zu B file: %6.1f ms, peak heap %8zu B, "
+					"store %7zu B (%5.1f B/entry)\n",
+					testCase.entriesCount, testCase.isGzip ? "gzip" : "plain",
+					file.size(), seconds * 1000.0, AllocStats::peak() - heapBefore,
+					storeBytes, (double)storeBytes / testCase.entriesCount);
+	}
+
+	struct YieldStats {
+		size_t count;
+		uint8_t progress;
+		bool isMonotonic;
+	} yieldStats;
+
+	void onYield()
+	{
+		uint8_t progress = reader->get_progress();
+
+		yieldStats.count++;
+		yieldStats.isMonotonic &= (progress >= yieldStats.progress);
+		yieldStats.progress = progress;
+	}
+
+	void checkYield()
+	{
+		// Parser pulls the whole payload in one call, USB is served between chunks
+		HostKdbx::Options options;
+		HostKdbx::Group root = HostKdbx::makeCorpus(1000, 64, 11);
+		std::vector<uint8_t> file = HostKdbx::write(root, PASSWORD, options);
+		FileSystem::host_write_file(DB_NAME, file.data(), file.size());
+
+		yieldStats = {0, 0, true};
+		reader->set_yield_callback(KeePassStream::YieldCallback(&onYield));
+
+		host_set_counter_step(1);
+		CHECK_EQUAL(SUCCESS, unlock(PASSWORD));
+		host_set_counter_step(0);
+
+		size_t chunksCount = file.size() / STREAM_CHUNK_SIZE_IN_BYTES;
+		CHECK(yieldStats.count >= chunksCount / 4);
+		CHECK(yieldStats.isMonotonic);
+		CHECK(yieldStats.progress > 90 && yieldStats.progress < 100);
+		std::printf("payload of %zu chunks yielded %zu times\n", chunksCount, yieldStats.count);
+
+		reader->set_yield_callback(KeePassStream::YieldCallback());
+	}
+
+	void checkErrors()
+	{
+		HostKdbx::Options options;
+		HostKdbx::Group root = HostKdbx::makeCorpus(200, 64, 7);
+		std::vector<uint8_t> file = HostKdbx::write(root, PASSWORD, options);
+
+		FileSystem::host_write_file(DB_NAME, file.data(), file.size());
+		CHECK_EQUAL(MASTER_KEY_ERROR, unlock("wrong password"));
+
+		// CBC spreads the flipped bit into the data of the hashed block
+		std::vector<uint8_t> corrupted = file;
+		corrupted[corrupted.size() / 2] ^= 0x01;
+		FileSystem::host_write_file(DB_NAME, corrupted.data(), corrupted.size());
+		CHECK_EQUAL(DATA_HASH_ERROR, unlock(PASSWORD));
+
+		std::vector<uint8_t> truncated(file.begin(), file.end() - AES_BLOCK_SIZE_IN_BYTES * 4);
+		FileSystem::host_write_file(DB_NAME, truncated.data(), truncated.size());
+		CHECK(unlock(PASSWORD) != SUCCESS);
+
+		std::vector<uint8_t> signature = file;
+		signature[0] ^= 0xFF;
+		FileSystem::host_write_file(DB_NAME, signature.data(), signature.size());
+		CHECK_EQUAL(SIGNATURE_ERROR, unlock(PASSWORD));
+
+		FileSystem::host_remove_file(DB_NAME);
+		CHECK_EQUAL(DB_FILE_ERROR, unlock(PASSWORD));
+	}
+}
+
+int main()
+{
+	std::printf("reader object %zu B\n", sizeof(KeePassReader));
+
+	for (const Case& testCase : CASES) {
+		if (testCase.isGzip && !HostKdbx::hasGzip()) {
+			continue;
+		}
+		reader = new KeePassReader();
+		checkCase(testCase);
+		delete reader;
+	}
+
+	reader = new KeePassReader();
+	checkYield();
+	checkErrors();
+	delete reader;
+
+	return HostTest::exit();
+}
@@ -0,0 +1,353 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/xmlindex/XmlIndex.h>
+#include <database/xmltree/XmlTree.h>
+#include <menu/LevelCursor.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+using Logic::LevelCursor;
+
+// Menu levels over a database: the top level goes on from the last
+// database point to the fixed points and back, moveTo() restores the
+// path of parents, the cursor reaches the deepest point the index
+// takes, and an empty database leaves the fixed points only.
+namespace {
+	struct Database {
+		DB::EntryStore store;
+		DB::XmlTree tree;
+		LevelCursor::FixedTreeT fixedTree;
+		LevelCursor cursor;
+
+		// False if the xml isn't taken by the index
+		bool load(const HostKdbx::Group& root)
+		{
+			HostKdbx::Options options;
+			uint8_t streamKey[32] = {1, 2, 3};
+			std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+			DB::XmlIndex index;
+			mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+							  DB::XmlIndex::saxCallback, &index);
+			if (!index.isComplete() || !store.build(index)) {
+				return (false);
+			}
+
+			// Fixed points as TildaLogic makes them
+			fixedTree.destroy();
+			setName("Settings");
+			fixedTree.addChild();
+			fixedTree.moveInto();
+			setName("Format");
+			fixedTree.moveOut();
+			fixedTree.addNeighbor();
+			fixedTree.moveRight();
+			setName("Exit");
+
+			tree.init(&store);
+			cursor.init(&tree, &fixedTree);
+			return (true);
+		}
+
+		LevelCursor::NodeId find(const char* name) const
+		{
+			for (size_t node = 0; node < store.getNodesCount(); ++node) {
+				DB::StringField field = store.getName(node);
+				if (std::string(field.begin(), field.end()) == name) {
+					return (node);
+				}
+			}
+			return (DB::EntryStore::NO_NODE);
+		}
+
+		std::string name()
+		{
+			DB::StringFieldConst& field = cursor.getCurrentContainer().getName();
+			return (std::string(field.begin(), field.end()));
+		}
+
+	private:
+		void setName(const char* name)
+		{
+			fixedTree.getCurrentNode()->getContainer().setName(
+					reinterpret_cast<const DB::StringFieldChar*>(name), std::strlen(name));
+		}
+	};
+
+	HostKdbx::Entry entry(const char* title)
+	{
+		HostKdbx::Entry entry;
+		entry.title = title;
+		entry.login = "login";
+		entry.password = "password";
+		return (entry);
+	}
+
+	HostKdbx::Group group(const char* name)
+	{
+		HostKdbx::Group group;
+		group.name = name;
+		return (group);
+	}
+
+	// Top level: Bank, Work, Home and the fixed Settings, Exit
+	// Work: GitLab, GitHub, Servers; Servers: db1, db2
+	HostKdbx::Group makeRoot()
+	{
+		HostKdbx::Group root = group("Root");
+		root.entries.push_back(entry("Bank"));
+
+		HostKdbx::Group work = group("Work");
+		work.entries.push_back(entry("GitLab"));
+		work.entries.push_back(entry("GitHub"));
+		HostKdbx::Group servers = group("Servers");
+		servers.entries.push_back(entry("db1"));
+		servers.entries.push_back(entry("db2"));
+		work.groups.push_back(servers);
+		root.groups.push_back(work);
+
+		HostKdbx::Group home = group("Home");
+		home.entries.push_back(entry("Mail"));
+		root.groups.push_back(home);
+
+		return (root);
+	}
+
+	void checkTopLevel()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+		LevelCursor& cursor = db.cursor;
+
+		CHECK(db.name() == "Bank");
+		CHECK(cursor.isMostTop() && cursor.isMostLeft() && !cursor.isMostRight());
+		cursor.moveLeft();
+		CHECK(db.name() == "Bank");
+
+		// The last database point is followed by the fixed points
+		cursor.moveRight();
+		cursor.moveRight();
+		CHECK(db.name() == "Home");
+		CHECK_EQUAL(2u, cursor.getCurrentChildNum());
+		CHECK(!cursor.isMostRight());
+		cursor.moveRight();
+		CHECK(db.name() == "Settings");
+		CHECK_EQUAL(3u, cursor.getCurrentChildNum());
+		CHECK(cursor.isMostTop() && !cursor.isMostLeft() && !cursor.isMostRight());
+		cursor.moveRight();
+		CHECK(db.name() == "Exit");
+		CHECK_EQUAL(4u, cursor.getCurrentChildNum());
+		CHECK(cursor.isMostRight());
+		cursor.moveRight();
+		CHECK(db.name() == "Exit");
+
+		// And back from the first fixed point to the last database one
+		cursor.moveLeft();
+		cursor.moveLeft();
+		CHECK(db.name() == "Home");
+		CHECK_EQUAL(2u, cursor.getCurrentChildNum());
+		cursor.moveLeft();
+		CHECK(db.name() == "Work");
+
+		// Ends of the whole top level
+		cursor.moveMostRight();
+		CHECK(db.name() == "Exit");
+		cursor.moveMostLeft();
+		CHECK(db.name() == "Bank");
+		CHECK_EQUAL(0u, cursor.getCurrentChildNum());
+
+		// Children of a fixed point don't go on to the database
+		cursor.moveMostRight();
+		cursor.moveLeft();
+		cursor.moveInto();
+		CHECK(db.name() == "Format");
+		CHECK_EQUAL(0u, cursor.getCurrentChildNum());
+		CHECK(!cursor.isMostTop() && cursor.isMostLeft() && cursor.isMostRight());
+		cursor.moveLeft();
+		cursor.moveMostLeft();
+		CHECK(db.name() == "Format");
+		cursor.moveOut();
+		CHECK(db.name() == "Settings");
+
+		// Nor do the children of a database group
+		cursor.moveLeft();
+		cursor.moveLeft();
+		cursor.moveInto();
+		CHECK(db.name() == "GitLab");
+		cursor.moveMostRight();
+		CHECK(db.name() == "Servers");
+		CHECK(cursor.isMostRight());
+		cursor.moveRight();
+		CHECK(db.name() == "Servers");
+		cursor.moveOut();
+		CHECK(db.name() == "Work");
+		CHECK_EQUAL(1u, cursor.getCurrentChildNum());
+	}
+
+	void checkMoveTo()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+		LevelCursor& cursor = db.cursor;
+
+		// From the fixed points into the depth
+		cursor.moveMostRight();
+		cursor.moveTo(db.find("db2"));
+		CHECK(db.name() == "db2");
+		CHECK_EQUAL(1u, cursor.getCurrentChildNum());
+		CHECK(!cursor.isMostTop() && cursor.isMostRight());
+
+		// moveOut() comes through every parent to the top
+		cursor.moveOut();
+		CHECK(db.name() == "Servers");
+		CHECK_EQUAL(2u, cursor.getCurrentChildNum());
+		cursor.moveOut();
+		CHECK(db.name() == "Work");
+		CHECK_EQUAL(1u, cursor.getCurrentChildNum());
+		CHECK(cursor.isMostTop());
+		cursor.moveOut();
+		CHECK(db.name() == "Work");
+		cursor.moveRight();
+		cursor.moveRight();
+		CHECK(db.name() == "Settings");
+
+		// moveInHead() too
+		cursor.moveTo(db.find("db1"));
+		CHECK(db.name() == "db1");
+		cursor.moveInHead();
+		CHECK(db.name() == "Work");
+		CHECK(cursor.isMostTop());
+
+		// Top level point
+		cursor.moveTo(db.find("Home"));
+		CHECK(db.name() == "Home");
+		CHECK_EQUAL(2u, cursor.getCurrentChildNum());
+		CHECK(cursor.isMostTop());
+		cursor.moveRight();
+		CHECK(db.name() == "Settings");
+
+		// The root group isn't a menu point
+		cursor.moveTo(db.find("Root"));
+		CHECK(db.name() == "Settings");
+	}
+
+	// Nested groups, the innermost one keeps the entry
+	HostKdbx::Group makeChain(size_t groupsCount)
+	{
+		HostKdbx::Group chain = group("Level");
+		chain.entries.push_back(entry("Deepest"));
+		for (size_t i = 1; i < groupsCount; ++i) {
+			HostKdbx::Group parent = group("Level");
+			parent.groups.push_back(chain);
+			chain = parent;
+		}
+
+		HostKdbx::Group root = group("Root");
+		root.groups.push_back(chain);
+		return (root);
+	}
+
+	void checkMaxDepth()
+	{
+		// The deepest database the index takes
+		size_t groupsCount = 1;
+		while (true) {
+			Database db;
+			if (!db.load(makeChain(groupsCount + 1))) {
+				break;
+			}
+			++groupsCount;
+		}
+		CHECK(groupsCount > 1);
+		CHECK(groupsCount < LevelCursor::MAX_DEPTH);
+
+		Database db;
+		CHECK(db.load(makeChain(groupsCount)));
+		LevelCursor& cursor = db.cursor;
+
+		// Every level of it is walked by the cursor
+		size_t depth = 0;
+		while (!cursor.isMostBottom()) {
+			cursor.moveInto();
+			++depth;
+			CHECK(depth <= LevelCursor::MAX_DEPTH);
+			if (depth > LevelCursor::MAX_DEPTH) {
+				break;
+			}
+		}
+		CHECK_EQUAL(groupsCount, depth);
+		CHECK(db.name() == "Deepest");
+		cursor.moveInto();
+		CHECK(db.name() == "Deepest");
+
+		// and its path is restored from the deepest point
+		cursor.moveInHead();
+		cursor.moveMostRight();
+		cursor.moveTo(db.find("Deepest"));
+		for (size_t i = 0; i < depth; ++i) {
+			CHECK(!cursor.isMostTop());
+			cursor.moveOut();
+			CHECK(db.name() == "Level");
+		}
+		CHECK(cursor.isMostTop());
+		CHECK_EQUAL(0u, cursor.getCurrentChildNum());
+	}
+
+	void checkEmpty()
+	{
+		Database db;
+		CHECK(db.load(group("Root")));
+		LevelCursor& cursor = db.cursor;
+
+		CHECK(db.name() == "Settings");
+		CHECK_EQUAL(0u, cursor.getCurrentChildNum());
+		CHECK(cursor.isMostTop() && cursor.isMostLeft());
+		cursor.moveLeft();
+		cursor.moveMostLeft();
+		CHECK(db.name() == "Settings");
+
+		cursor.moveRight();
+		CHECK(db.name() == "Exit");
+		CHECK_EQUAL(1u, cursor.getCurrentChildNum());
+		cursor.moveTo(0);
+		CHECK(db.name() == "Exit");
+		cursor.moveMostLeft();
+		CHECK(db.name() == "Settings");
+	}
+}
+
+int main()
+{
+	checkTopLevel();
+	checkMoveTo();
+	checkMaxDepth();
+	checkEmpty();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,210 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <libopencm3/stm32/desig.h>
+#include <keepass/keepass_reader.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+#include "systick_ext.h"
+
+using namespace KeepAss;
+
+// PIN quick unlock: the PIN is chosen after a full unlock, its key
+// is derived in time slices and bound to the chip ID and the file.
+namespace {
+	const char* DB_NAME = "db.kdb";
+	const char* PASSWORD = "master password";
+	const char* PIN = "2468";
+
+	KeePassReader reader;
+	size_t nodesCount = 0;
+
+	DecryptionResult finish(DecryptionResult result, size_t* slices = nullptr)
+	{
+		uint8_t progress = 0;
+		bool isMonotonic = true;
+
+		while (result == IN_PROGRESS) {
+			result = reader.continue_decryption();
+			if (slices != nullptr) {
+				(*slices)++;
+			}
+			if (result == IN_PROGRESS) {
+				isMonotonic &= (reader.get_progress() >= progress);
+				progress = reader.get_progress();
+			}
+		}
+
+		CHECK(isMonotonic);
+		return result;
+	}
+
+	DecryptionResult unlock(const char* password)
+	{
+		reader.set_password(password, std::strlen(password));
+		return finish(reader.decrypt_database(DB_NAME));
+	}
+
+	DecryptionResult quickUnlock(const char* pin)
+	{
+		reader.set_password(pin, std::strlen(pin));
+		return finish(reader.quick_decrypt_database(DB_NAME));
+	}
+
+	void writeDatabase(uint32_t seed)
+	{
+		HostKdbx::Options options;
+		options.rounds = 500;
+		options.seed = seed;
+
+		HostKdbx::Group root = HostKdbx::makeCorpus(50, 16, seed);
+		std::vector<uint8_t> file = HostKdbx::write(root, PASSWORD, options);
+		FileSystem::host_write_file(DB_NAME, file.data(), file.size());
+	}
+
+	bool sealPin(const char* pin)
+	{
+		if (unlock(PASSWORD) != SUCCESS || !reader.is_quick_unlock_pin_expected()) {
+			return false;
+		}
+		nodesCount = reader.get_store()->getNodesCount();
+
+		if (!reader.set_quick_unlock_pin(pin, std::strlen(pin))) {
+			return false;
+		}
+		return (finish(IN_PROGRESS) == SUCCESS && reader.is_quick_unlock_ready());
+	}
+
+	void checkSeal()
+	{
+		writeDatabase(1);
+
+		CHECK_EQUAL(SUCCESS, unlock(PASSWORD));
+		CHECK(reader.is_quick_unlock_pin_expected());
+		CHECK(!reader.is_quick_unlock_ready());
+		CHECK(!reader.is_quick_unlocked());
+
+		// Too short and too long PINs are refused, the key still waits
+		CHECK(!reader.set_quick_unlock_pin("123", 3));
+		CHECK(!reader.set_quick_unlock_pin("12345678901234567", 17));
+		CHECK(reader.is_quick_unlock_pin_expected());
+
+		// Derivation is sliced as the KDF, the main loop isn't blocked
+		size_t slices = 0;
+		host_set_counter_step(1);
+		CHECK(reader.set_quick_unlock_pin(PIN, std::strlen(PIN)));
+		CHECK(!reader.is_quick_unlock_pin_expected());
+		CHECK_EQUAL(SUCCESS, finish(IN_PROGRESS, &slices));
+		host_set_counter_step(0);
+		CHECK(slices > 4);
+		std::printf("PIN key derived in %zu slices\n", slices);
+
+		CHECK(reader.is_quick_unlock_ready());
+		CHECK_EQUAL(SUCCESS, quickUnlock(PIN));
+		CHECK(reader.is_quick_unlocked());
+		CHECK(reader.get_store()->getNodesCount() > 0);
+
+		// Quick unlock doesn't ask for a new PIN, the old one stays
+		CHECK(!reader.is_quick_unlock_pin_expected());
+		CHECK_EQUAL(SUCCESS, quickUnlock(PIN));
+	}
+
+	void checkMasterPasswordPrefix()
+	{
+		// Neither the master password nor its beginning is the PIN
+		CHECK(sealPin(PIN));
+		CHECK_EQUAL(MASTER_KEY_ERROR, quickUnlock("mast"));
+		CHECK_EQUAL(MASTER_KEY_ERROR, quickUnlock(PASSWORD));
+		CHECK_EQUAL(SUCCESS, quickUnlock(PIN));
+	}
+
+	void checkAttempts()
+	{
+		CHECK(sealPin(PIN));
+
+		for (uint32_t i = 0; i < QUICK_UNLOCK_MAX_ATTEMPTS - 1; ++i) {
+			CHECK_EQUAL(MASTER_KEY_ERROR, quickUnlock("1111"));
+			CHECK(reader.is_quick_unlock_ready());
+		}
+		CHECK_EQUAL(MASTER_KEY_ERROR, quickUnlock("1111"));
+		CHECK(!reader.is_quick_unlock_ready());
+		CHECK_EQUAL(CREDENTIALS_ERROR, quickUnlock(PIN));
+	}
+
+	void checkDeviceBinding()
+	{
+		uint32_t id[3];
+		desig_get_unique_id(id);
+
+		// Sealed key taken to another chip doesn't open with the right PIN
+		CHECK(sealPin(PIN));
+		host_set_unique_id(id[0], id[1], id[2] ^ 1);
+		CHECK_EQUAL(MASTER_KEY_ERROR, quickUnlock(PIN));
+		host_set_unique_id(id[0], id[1], id[2]);
+		CHECK_EQUAL(SUCCESS, quickUnlock(PIN));
+	}
+
+	void checkDrop()
+	{
+		// Any write to the flash may change the database
+		CHECK(sealPin(PIN));
+		writeDatabase(2);
+		CHECK(!reader.is_quick_unlock_ready());
+		CHECK_EQUAL(CREDENTIALS_ERROR, quickUnlock(PIN));
+
+		CHECK(sealPin(PIN));
+		reader.forget_quick_unlock();
+		CHECK(!reader.is_quick_unlock_ready());
+
+		CHECK(sealPin(PIN));
+		reader.lock();
+		CHECK(!reader.is_quick_unlock_ready());
+		CHECK_EQUAL(0, reader.get_store()->getNodesCount());
+
+		CHECK_EQUAL(SUCCESS, unlock(PASSWORD));
+		reader.discard_quick_unlock_pin();
+		CHECK(!reader.is_quick_unlock_pin_expected());
+		CHECK(!reader.set_quick_unlock_pin(PIN, std::strlen(PIN)));
+		CHECK(!reader.is_quick_unlock_ready());
+
+		// Failed unlock doesn't wait for a PIN
+		CHECK_EQUAL(MASTER_KEY_ERROR, unlock("wrong password"));
+		CHECK(!reader.is_quick_unlock_pin_expected());
+	}
+}
+
+int main()
+{
+	checkSeal();
+	checkMasterPasswordPrefix();
+	checkAttempts();
+	checkDeviceBinding();
+	checkDrop();
+
+	return HostTest::exit();
+}
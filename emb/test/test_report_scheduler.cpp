@@ -0,0 +1,154 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+
+#include <hid_report_scheduler.h>
+
+#include "host_test.h"
+
+using namespace UsbPackages;
+
+// HID IN endpoint decisions: a new report goes at once, the last one is
+// repeated only when host's idle period is over, otherwise the endpoint
+// NAKs. Host is polling each bInterval, the counters are checked against
+// what it has seen.
+namespace {
+	using Action = HidReportScheduler::Action;
+
+	constexpr uint32_t POLL_INTERVAL_MS = 4;
+
+	// Host polls for periodMs with no new reports, returns reports it got
+	uint32_t poll(HidReportScheduler& scheduler, uint32_t& nowMs, uint32_t periodMs)
+	{
+		uint32_t sentCount = 0;
+
+		for (uint32_t endMs = nowMs + periodMs; nowMs != endMs; nowMs += POLL_INTERVAL_MS) {
+			scheduler.complete();
+
+			Action action = scheduler.schedule(false, nowMs);
+			CHECK(action != Action::SEND_NEW);
+
+			if (action == Action::SEND_LAST) {
+				scheduler.sent(nowMs);
+				sentCount++;
+			}
+		}
+		return sentCount;
+	}
+
+	void checkNewReports()
+	{
+		HidReportScheduler scheduler(POLL_INTERVAL_MS);
+
+		CHECK(scheduler.schedule(true, 0) == Action::SEND_NEW);
+		scheduler.sent(0);
+		CHECK(scheduler.isBusy());
+
+		// Kick while the report is in the endpoint waits for completion
+		CHECK(scheduler.schedule(true, 1) == Action::NONE);
+		CHECK(scheduler.schedule(false, 1) == Action::NONE);
+		CHECK_EQUAL(0u, scheduler.getStats().nakIntervalsCount);
+
+		scheduler.complete();
+		CHECK(scheduler.isBusy() == false);
+		CHECK(scheduler.schedule(true, 4) == Action::SEND_NEW);
+		scheduler.sent(4);
+
+		CHECK_EQUAL(2u, scheduler.getStats().sentCount);
+		CHECK_EQUAL(0u, scheduler.getStats().suppressedCount);
+	}
+
+	void checkInfiniteIdle()
+	{
+		HidReportScheduler scheduler(POLL_INTERVAL_MS);
+		uint32_t nowMs = 0;
+
+		CHECK(scheduler.schedule(true, nowMs) == Action::SEND_NEW);
+		scheduler.sent(nowMs);
+		nowMs += POLL_INTERVAL_MS;
+
+		// Idle rate 0: the last report is never repeated
+		CHECK_EQUAL(0u, poll(scheduler, nowMs, 1000));
+		CHECK_EQUAL(1u, scheduler.getStats().nakIntervalsCount);
+		CHECK_EQUAL(0u, scheduler.getStats().suppressedCount);
+
+		// Duplicates are counted when NAK interval is over
+		scheduler.complete();
+		CHECK(scheduler.schedule(true, nowMs) == Action::SEND_NEW);
+		scheduler.sent(nowMs);
+
+		const HidReportStats& stats = scheduler.getStats();
+		CHECK_EQUAL(2u, stats.sentCount);
+		CHECK_EQUAL(1u, stats.nakIntervalsCount);
+		CHECK_EQUAL(1000u / POLL_INTERVAL_MS, stats.suppressedCount);
+	}
+
+	void checkIdleRate()
+	{
+		HidReportScheduler scheduler(POLL_INTERVAL_MS);
+		uint32_t nowMs = 0;
+
+		// 25 * 4 ms = 100 ms
+		scheduler.setIdleRate(25);
+		CHECK(scheduler.schedule(true, nowMs) == Action::SEND_NEW);
+		scheduler.sent(nowMs);
+		scheduler.complete();
+
+		CHECK(scheduler.schedule(false, 99) == Action::NONE);
+		CHECK(scheduler.schedule(false, 100) == Action::SEND_LAST);
+
+		nowMs = POLL_INTERVAL_MS;
+		CHECK_EQUAL(10u, poll(scheduler, nowMs, 1000));
+		CHECK_EQUAL(11u, scheduler.getStats().sentCount);
+		CHECK_EQUAL(10u, scheduler.getStats().nakIntervalsCount);
+
+		// Host turns idle reports off
+		scheduler.setIdleRate(0);
+		CHECK_EQUAL(0u, poll(scheduler, nowMs, 1000));
+	}
+
+	void checkCounterWrap()
+	{
+		HidReportScheduler scheduler(POLL_INTERVAL_MS);
+		uint32_t nowMs = UINT32_MAX - 40 + 1;
+
+		scheduler.setIdleRate(25);
+		CHECK(scheduler.schedule(true, nowMs) == Action::SEND_NEW);
+		scheduler.sent(nowMs);
+		nowMs += POLL_INTERVAL_MS;
+
+		CHECK_EQUAL(2u, poll(scheduler, nowMs, 200));
+	}
+}
+
+int main()
+{
+	checkNewReports();
+	checkInfiniteIdle();
+	checkIdleRate();
+	checkCounterWrap();
+
+	return HostTest::exit();
+}
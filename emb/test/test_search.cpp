@@ -0,0 +1,231 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/searchindex/FuzzyMatcher.h>
+#include <database/xmlindex/XmlIndex.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+using DB::FuzzyMatcher;
+
+// Fuzzy search as it's typed: words of the query may be split,
+// results are ranked by word boundaries and contiguous chars,
+// erased chars give back the survivors of the shorter query, and
+// only MAX_RESULTS_COUNT best entries are kept for Tab to cycle.
+namespace {
+	using Nodes = std::vector<FuzzyMatcher::NodeId>;
+
+	struct Database {
+		DB::EntryStore store;
+		FuzzyMatcher matcher;
+
+		bool load(const HostKdbx::Group& root)
+		{
+			HostKdbx::Options options;
+			uint8_t streamKey[32] = {1, 2, 3};
+			std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+			DB::XmlIndex index;
+			mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+							  DB::XmlIndex::saxCallback, &index);
+			return (index.isComplete() && store.build(index) && matcher.build(&store));
+		}
+
+		FuzzyMatcher::NodeId find(const std::string& title) const
+		{
+			for (size_t node = 0; node < store.getNodesCount(); ++node) {
+				DB::StringField field = store.getName(node);
+				if (store.isEntry(node) && std::string(field.begin(), field.end()) == title) {
+					return (node);
+				}
+			}
+			return (DB::EntryStore::NO_NODE);
+		}
+	};
+
+	HostKdbx::Entry entry(const std::string& title, const std::string& login)
+	{
+		HostKdbx::Entry entry;
+		entry.title = title;
+		entry.login = login;
+		entry.password = "password";
+		return (entry);
+	}
+
+	// Query is typed char by char
+	size_t type(FuzzyMatcher& matcher, const std::string& query)
+	{
+		size_t count = 0;
+		for (size_t length = 1; length <= query.size(); ++length) {
+			count = matcher.search((const uint8_t*)query.data(), length);
+		}
+		return (count);
+	}
+
+	Nodes results(const FuzzyMatcher& matcher)
+	{
+		Nodes nodes;
+		for (size_t i = 0; i < matcher.getResultsCount(); ++i) {
+			nodes.push_back(matcher.getResult(i));
+		}
+		CHECK_EQUAL(DB::EntryStore::NO_NODE, matcher.getResult(matcher.getResultsCount()));
+		return (nodes);
+	}
+
+	// The same query searched at once by another matcher
+	void checkFresh(const Database& db, const FuzzyMatcher& matcher, const std::string& query)
+	{
+		FuzzyMatcher fresh;
+		fresh.build(&db.store);
+		fresh.search((const uint8_t*)query.data(), query.size());
+
+		CHECK_EQUAL(fresh.getSurvivorsCount(), matcher.getSurvivorsCount());
+		if (!CHECK(results(fresh) == results(matcher))) {
+			std::printf("  results of \"%s\" differ\n", query.c_str());
+		}
+	}
+
+	HostKdbx::Group makeWorkRoot()
+	{
+		HostKdbx::Group root = HostKdbx::makeCorpus(500, 0, 17);
+		root.entries.push_back(entry("Getting help at work", "me"));
+		root.entries.push_back(entry("GitHub (work account)", "me"));
+		root.entries.push_back(entry("Graph homework", "me"));
+		root.entries.push_back(entry("GitHub", "personal"));
+		return (root);
+	}
+
+	void checkRanking()
+	{
+		Database db;
+		CHECK(db.load(makeWorkRoot()));
+
+		// Boundaries of GitHub (work account) beat contiguous "help"
+		CHECK(type(db.matcher, "gh work") > 1);
+		CHECK_EQUAL(db.find("GitHub (work account)"), db.matcher.getResult(0));
+		checkFresh(db, db.matcher, "gh work");
+	}
+
+	void checkBackspace()
+	{
+		Database db;
+		CHECK(db.load(makeWorkRoot()));
+		FuzzyMatcher& matcher = db.matcher;
+
+		const std::string QUERY = "gh work";
+		std::vector<size_t> survivors;
+		for (size_t length = 1; length <= QUERY.size(); ++length) {
+			matcher.search((const uint8_t*)QUERY.data(), length);
+			survivors.push_back(matcher.getSurvivorsCount());
+		}
+
+		// Erased chars restore survivors of the shorter query
+		for (size_t length = QUERY.size() - 1; length > 0; --length) {
+			matcher.search((const uint8_t*)QUERY.data(), length);
+			CHECK_EQUAL(survivors[length - 1], matcher.getSurvivorsCount());
+			checkFresh(db, matcher, QUERY.substr(0, length));
+		}
+
+		// And narrowing again matches the fresh search
+		CHECK(type(matcher, "gh home") > 0);
+		checkFresh(db, matcher, "gh home");
+
+		// Changed char in the middle
+		matcher.search((const uint8_t*)"gx", 2);
+		checkFresh(db, matcher, "gx");
+		CHECK(type(matcher, "git") > 0);
+		checkFresh(db, matcher, "git");
+
+		matcher.reset();
+		CHECK_EQUAL(0u, matcher.getResultsCount());
+		CHECK(type(matcher, "gh work") > 0);
+		checkFresh(db, matcher, "gh work");
+	}
+
+	void checkScoreOrder()
+	{
+		// Scores of "gh": gh-pages 56, GitHub 54, Graph 45, high ground 40
+		HostKdbx::Group root;
+		root.name = "Root";
+		root.entries.push_back(entry("high ground", "me"));
+		root.entries.push_back(entry("Graph", "me"));
+		root.entries.push_back(entry("GitHub", "me"));
+		root.entries.push_back(entry("gh-pages", "me"));
+		root.entries.push_back(entry("Mail", "me"));
+
+		Database db;
+		CHECK(db.load(root));
+		CHECK_EQUAL(4u, type(db.matcher, "gh"));
+
+		const char* const ORDER[] = {"gh-pages", "GitHub", "Graph", "high ground"};
+
+		// Tab goes to the next result and from the last to the first
+		size_t result = 0;
+		for (size_t tab = 0; tab < 2 * 4; ++tab) {
+			CHECK_EQUAL(db.find(ORDER[tab % 4]), db.matcher.getResult(result));
+			result = (result + 1) % db.matcher.getResultsCount();
+		}
+	}
+
+	void checkResultsCap()
+	{
+		Database db;
+		CHECK(db.load(HostKdbx::makeCorpus(2000, 0, 5)));
+		FuzzyMatcher& matcher = db.matcher;
+
+		// Many survivors, the best few of them are kept
+		CHECK_EQUAL(FuzzyMatcher::MAX_RESULTS_COUNT, type(matcher, "e"));
+		CHECK(matcher.getSurvivorsCount() > 10 * FuzzyMatcher::MAX_RESULTS_COUNT);
+
+		Nodes nodes = results(matcher);
+		CHECK_EQUAL(FuzzyMatcher::MAX_RESULTS_COUNT, nodes.size());
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			for (size_t j = i + 1; j < nodes.size(); ++j) {
+				CHECK(nodes[i] != nodes[j]);
+			}
+		}
+
+		// Every longer query keeps the cap
+		CHECK(type(matcher, "e1") <= FuzzyMatcher::MAX_RESULTS_COUNT);
+		checkFresh(db, matcher, "e1");
+		matcher.search((const uint8_t*)"e", 1);
+		CHECK_EQUAL(FuzzyMatcher::MAX_RESULTS_COUNT, matcher.getResultsCount());
+		checkFresh(db, matcher, "e");
+	}
+}
+
+int main()
+{
+	checkRanking();
+	checkBackspace();
+	checkScoreOrder();
+	checkResultsCap();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,212 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <set>
+#include <string>
+
+#include <database/entrystore/EntryStore.h>
+#include <database/searchindex/SearchIndex.h>
+#include <database/xmlindex/XmlIndex.h>
+
+#include "host_test.h"
+#include "kdbx_writer.h"
+
+using DB::SearchIndex;
+
+// Prefix search over titles and logins: every char narrows the range
+// of the last one, the case is folded, a node whose title and login
+// both match is found once, and the prefix is cut at MAX_PREFIX_LENGTH.
+namespace {
+	const std::string LONG_TITLE(70, 'x');
+
+	struct Database {
+		DB::EntryStore store;
+		SearchIndex index;
+
+		bool load(const HostKdbx::Group& root)
+		{
+			HostKdbx::Options options;
+			uint8_t streamKey[32] = {1, 2, 3};
+			std::string xml = HostKdbx::makeXml(root, options, streamKey);
+
+			DB::XmlIndex xmlIndex;
+			mxmlSAXLoadString(nullptr, xml.c_str(), DB::XmlIndex::typeCallback,
+							  DB::XmlIndex::saxCallback, &xmlIndex);
+			return (xmlIndex.isComplete() && store.build(xmlIndex) && index.build(&store));
+		}
+
+		SearchIndex::NodeId find(const std::string& login) const
+		{
+			for (size_t node = 0; node < store.getNodesCount(); ++node) {
+				DB::StringField field = store.getLogin(node);
+				if (std::string(field.begin(), field.end()) == login) {
+					return (node);
+				}
+			}
+			return (DB::EntryStore::NO_NODE);
+		}
+
+		bool search(const std::string& prefix)
+		{
+			return (index.search((const uint8_t*)prefix.data(), prefix.size()));
+		}
+
+		// Found nodes as logins, every node must be found once
+		std::set<std::string> found() const
+		{
+			std::set<std::string> logins;
+			for (size_t i = 0; i < index.getMatchesCount(); ++i) {
+				SearchIndex::NodeId node = index.getMatch(i);
+				DB::StringField field = store.getLogin(node);
+				CHECK(logins.insert(std::string(field.begin(), field.end())).second);
+			}
+			CHECK_EQUAL(DB::EntryStore::NO_NODE, index.getMatch(index.getMatchesCount()));
+			return (logins);
+		}
+	};
+
+	HostKdbx::Entry entry(const std::string& title, const std::string& login)
+	{
+		HostKdbx::Entry entry;
+		entry.title = title;
+		entry.login = login;
+		entry.password = "password";
+		return (entry);
+	}
+
+	HostKdbx::Group makeRoot()
+	{
+		HostKdbx::Group root;
+		root.name = "Root";
+		root.entries.push_back(entry("GitHub", "octocat"));
+		root.entries.push_back(entry("GitLab admin", "root"));
+		root.entries.push_back(entry("gitea", "Git-user"));
+		root.entries.push_back(entry("user42", "user42@ex"));
+		root.entries.push_back(entry("Mail", "user7"));
+		root.entries.push_back(entry("", "nobody"));
+		root.entries.push_back(entry(LONG_TITLE + "a", "long-a"));
+
+		HostKdbx::Group group;
+		group.name = "Work";
+		group.entries.push_back(entry(LONG_TITLE + "b", "long-b"));
+		root.groups.push_back(group);
+		return (root);
+	}
+
+	using Logins = std::set<std::string>;
+
+	void checkNarrowing()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+
+		// Empty title isn't a key, the group isn't either
+		CHECK_EQUAL(15u, db.index.getKeysCount());
+		CHECK_EQUAL(8u, db.index.getMatchesCount());
+
+		CHECK(db.search("g"));
+		CHECK(db.found() == Logins({"octocat", "root", "Git-user"}));
+		CHECK(db.search("gitl"));
+		CHECK(db.found() == Logins({"root"}));
+		CHECK_EQUAL(db.find("root"), db.index.getBestMatch());
+		CHECK(!db.search("gitlx"));
+		CHECK_EQUAL(0u, db.index.getMatchesCount());
+		CHECK_EQUAL(DB::EntryStore::NO_NODE, db.index.getBestMatch());
+
+		// Erased and changed chars give what a fresh search gives
+		CHECK(db.search("git"));
+		CHECK(db.found() == Logins({"octocat", "root", "Git-user"}));
+		CHECK(db.search("git-"));
+		CHECK(db.found() == Logins({"Git-user"}));
+		CHECK(db.search("no"));
+		CHECK(db.found() == Logins({"nobody"}));
+		CHECK(db.search(""));
+		CHECK_EQUAL(8u, db.index.getMatchesCount());
+
+		db.index.reset();
+		CHECK(db.search("m"));
+		CHECK(db.found() == Logins({"user7"}));
+	}
+
+	void checkCaseFolding()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+
+		CHECK(db.search("GIT"));
+		CHECK(db.found() == Logins({"octocat", "root", "Git-user"}));
+		CHECK(db.search("gIt-U"));
+		CHECK(db.found() == Logins({"Git-user"}));
+		CHECK(db.search("OCTO"));
+		CHECK(db.found() == Logins({"octocat"}));
+		CHECK(db.search("mAiL"));
+		CHECK(db.found() == Logins({"user7"}));
+	}
+
+	void checkDuplicates()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+
+		// Title and login of user42 share the prefix up to "@"
+		CHECK(db.search("u"));
+		CHECK(db.found() == Logins({"user42@ex", "user7"}));
+		CHECK(db.search("user42"));
+		CHECK(db.found() == Logins({"user42@ex"}));
+		CHECK(db.search("user42@"));
+		CHECK(db.found() == Logins({"user42@ex"}));
+		CHECK(db.search("user4"));
+		CHECK(db.found() == Logins({"user42@ex"}));
+	}
+
+	void checkLongPrefix()
+	{
+		Database db;
+		CHECK(db.load(makeRoot()));
+
+		// Both long titles differ after the searched part
+		std::string prefix = LONG_TITLE;
+		CHECK(db.search(prefix));
+		CHECK(db.found() == Logins({"long-a", "long-b"}));
+		CHECK(db.search(prefix + "a"));
+		CHECK(db.found() == Logins({"long-a", "long-b"}));
+
+		std::string cut(SearchIndex::MAX_PREFIX_LENGTH, 'x');
+		CHECK(db.search(cut + "yyy"));
+		CHECK(db.found() == Logins({"long-a", "long-b"}));
+		CHECK(!db.search(cut.substr(1) + "y"));
+		CHECK_EQUAL(0u, db.index.getMatchesCount());
+	}
+}
+
+int main()
+{
+	checkNarrowing();
+	checkCaseFolding();
+	checkDuplicates();
+	checkLongPrefix();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,155 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if HOST_SHA_NI
+#include <cpuid.h>
+#endif
+
+extern "C" {
+#include <sha2.h>
+}
+
+#include "host_test.h"
+
+// FIPS 180-2 SHA-256 vectors through the one-shot, the streaming and
+// the multi-block update, at odd split points and unaligned inputs.
+// The test is built once more with -msha -msse4.1 for the SHA-NI
+// block function, it's skipped when the CPU doesn't have it.
+namespace {
+	const int SKIP_CODE = 77;
+
+	const char* ABC = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+	const char* TWO_BLOCKS = "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1";
+	const char* MILLION = "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+
+	std::string toHex(const uint8_t* bytes, size_t length)
+	{
+		std::string text;
+		char byte[3];
+		for (size_t i = 0; i < length; ++i) {
+			std::snprintf(byte, sizeof(byte), "%02x", bytes[i]);
+			text += byte;
+		}
+		return text;
+	}
+
+	std::string digest(cf_sha256_context& ctx)
+	{
+		uint8_t hash[CF_SHA256_HASHSZ];
+		cf_sha256_digest_final(&ctx, hash);
+		return toHex(hash, sizeof(hash));
+	}
+
+	std::string hash(const void* data, size_t length)
+	{
+		cf_sha256_context ctx;
+		cf_sha256_init(&ctx);
+		cf_sha256_update(&ctx, data, length);
+		return digest(ctx);
+	}
+
+	void checkVectors()
+	{
+		const char* twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+		CHECK(hash("abc", 3) == ABC);
+		CHECK(hash(twoBlocks, std::strlen(twoBlocks)) == TWO_BLOCKS);
+		CHECK(hash("", 0) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+		std::vector<uint8_t> million(1000000, 'a');
+		CHECK(hash(million.data(), million.size()) == MILLION);
+
+		// Byte by byte, every block goes through the partial buffer
+		cf_sha256_context ctx;
+		cf_sha256_init(&ctx);
+		for (size_t i = 0; i < std::strlen(twoBlocks); ++i) {
+			cf_sha256_update(&ctx, &twoBlocks[i], 1);
+		}
+		CHECK(digest(ctx) == TWO_BLOCKS);
+	}
+
+	void checkUpdateBlocks()
+	{
+		// 1000000 is 15625 whole blocks, hashed by one call
+		std::vector<uint8_t> million(1000000 + 1, 'a');
+		cf_sha256_context ctx;
+		cf_sha256_init(&ctx);
+		cf_sha256_update_blocks(&ctx, million.data(), million.size() / CF_SHA256_BLOCKSZ);
+		CHECK(digest(ctx) == MILLION);
+
+		// Unaligned input
+		cf_sha256_init(&ctx);
+		cf_sha256_update_blocks(&ctx, &million[1], million.size() / CF_SHA256_BLOCKSZ);
+		CHECK(digest(ctx) == MILLION);
+
+		// Odd updates around multi-block ones: a partial block is topped up
+		// first, then whole blocks go straight from the buffer
+		const size_t SPLITS[] = {1, 63, 64, 65, 127, 129, 1000, 4093, 64 * 17 + 5};
+		cf_sha256_init(&ctx);
+		size_t done = 0;
+		for (size_t i = 0; done < 1000000; ++i) {
+			size_t length = std::min<size_t>(SPLITS[i % 9], 1000000 - done);
+			cf_sha256_update(&ctx, &million[done], length);
+			done += length;
+		}
+		CHECK(digest(ctx) == MILLION);
+
+		// Blocks after a flushed partial block
+		cf_sha256_init(&ctx);
+		cf_sha256_update(&ctx, million.data(), 3 * CF_SHA256_BLOCKSZ);
+		cf_sha256_update_blocks(&ctx, &million[3 * CF_SHA256_BLOCKSZ + 1],
+								(1000000 - 3 * CF_SHA256_BLOCKSZ) / CF_SHA256_BLOCKSZ);
+		CHECK(digest(ctx) == MILLION);
+	}
+
+#if HOST_SHA_NI
+	bool hasShaNi()
+	{
+		unsigned int eax, ebx, ecx, edx;
+		return (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29)) != 0);
+	}
+#endif
+}
+
+int main()
+{
+#if HOST_SHA_NI
+	if (!hasShaNi()) {
+		std::printf("CPU has no SHA extensions\n");
+		return SKIP_CODE;
+	}
+#endif
+
+	checkVectors();
+	checkUpdateBlocks();
+
+	return HostTest::exit();
+}
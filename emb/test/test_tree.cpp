@@ -0,0 +1,216 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <initializer_list>
+
+#include <Tree.hpp>
+
+#include "host_test.h"
+
+// Callbacks of the menu tree: distinct callbacks share a small table,
+// one more than the table takes is refused and the node keeps its own.
+// Links of the index array: every parent and the top level keep their
+// own tail, positions and children count follow from it, and nodes
+// over the array size are dropped.
+namespace {
+	using TestTree = Tree<16, int>;
+
+	// Nodes of the link checks hold their values as containers
+	template<typename TreeT>
+	void addChild(TreeT& tree, int value)
+	{
+		tree.addChild(&TreeT::TreeNodeT::EMPTY_CALLBACK, value);
+	}
+
+	template<typename TreeT>
+	void addNeighbor(TreeT& tree, int value)
+	{
+		tree.addNeighbor(&TreeT::TreeNodeT::EMPTY_CALLBACK, value);
+	}
+
+	int calls[TestTree::CALLBACKS_COUNT + 1];
+
+	template<int number>
+	void count(int&)
+	{
+		calls[number]++;
+	}
+
+	template<int number>
+	bool setCount(TestTree& tree)
+	{
+		return tree.setCallback(TestTree::CallbackT(&count<number>));
+	}
+
+	void checkCallbacksTable()
+	{
+		TestTree tree;
+		tree.destroy();
+
+		// Empty callback takes the first slot
+		CHECK(setCount<1>(tree));
+		CHECK(setCount<2>(tree));
+		CHECK(setCount<3>(tree));
+		CHECK(setCount<4>(tree));
+		CHECK(setCount<5>(tree));
+		CHECK(setCount<6>(tree));
+		CHECK(setCount<7>(tree));
+		CHECK(setCount<1>(tree));
+
+		CHECK(!setCount<8>(tree));
+		tree.call();
+		CHECK_EQUAL(1, calls[1]);
+		CHECK_EQUAL(0, calls[8]);
+	}
+
+	// Container values of the children of the current node, in order
+	void checkChildren(TestTree& tree, std::initializer_list<int> values)
+	{
+		CHECK_EQUAL(values.size(), tree.getChildrenCount());
+		if (values.size() == 0) {
+			CHECK(tree.isMostBottom());
+			return;
+		}
+
+		tree.moveInto();
+		CHECK(tree.isMostLeft());
+
+		size_t position = 0;
+		for (int value : values) {
+			TestTree::TreeNodePtr node = tree.getCurrentNode();
+			CHECK_EQUAL(value, node->getContainer());
+			CHECK_EQUAL(position, tree.getCurrentChildNum());
+			CHECK_EQUAL(position + 1 == values.size(), tree.isMostRight());
+			tree.moveRight();
+			++position;
+		}
+
+		// Back through the left links
+		for (size_t i = 1; i < values.size(); ++i) {
+			tree.moveLeft();
+		}
+		CHECK(tree.isMostLeft());
+		tree.moveOut();
+	}
+
+	void checkLinks()
+	{
+		TestTree tree;
+		tree.getCurrentNode()->setContainer(0);
+		addNeighbor(tree, 1);
+		addNeighbor(tree, 2);
+
+		// Children of two parents are added in turns, every
+		// parent links the new one after its own tail
+		addChild(tree, 10);
+		addChild(tree, 11);
+		tree.moveRight();
+		addChild(tree, 20);
+		tree.moveLeft();
+		addChild(tree, 12);
+		tree.moveRight();
+		addChild(tree, 21);
+
+		tree.moveMostLeft();
+		CHECK_EQUAL(0, tree.getCurrentNode()->getContainer());
+		checkChildren(tree, {10, 11, 12});
+		tree.moveRight();
+		checkChildren(tree, {20, 21});
+		tree.moveRight();
+		checkChildren(tree, {});
+
+		// A neighbor added from a child goes to its parent
+		tree.moveMostLeft();
+		tree.moveInto();
+		tree.moveRight();
+		addNeighbor(tree, 13);
+		CHECK_EQUAL(11, tree.getCurrentNode()->getContainer());
+		tree.moveMostRight();
+		CHECK_EQUAL(13, tree.getCurrentNode()->getContainer());
+		CHECK_EQUAL(3u, tree.getCurrentChildNum());
+		tree.moveOut();
+		CHECK(tree.isMostTop());
+		checkChildren(tree, {10, 11, 12, 13});
+
+		// Top nodes have no parent, their tail is kept by the tree
+		tree.moveMostRight();
+		CHECK_EQUAL(2, tree.getCurrentNode()->getContainer());
+		CHECK_EQUAL(2u, tree.getCurrentChildNum());
+		tree.moveMostLeft();
+		addNeighbor(tree, 3);
+		tree.moveMostRight();
+		CHECK_EQUAL(3, tree.getCurrentNode()->getContainer());
+		CHECK_EQUAL(3u, tree.getCurrentChildNum());
+		CHECK(tree.isMostRight());
+		tree.moveLeft();
+		CHECK_EQUAL(2, tree.getCurrentNode()->getContainer());
+		tree.moveMostLeft();
+		CHECK_EQUAL(0, tree.getCurrentNode()->getContainer());
+		CHECK(tree.isMostLeft());
+
+		// moveInHead() comes back to the top level from any depth
+		tree.moveInto();
+		tree.moveMostRight();
+		tree.moveInHead();
+		CHECK(tree.isMostTop());
+		CHECK_EQUAL(0, tree.getCurrentNode()->getContainer());
+	}
+
+	void checkFull()
+	{
+		Tree<4, int> tree;
+		CHECK(!tree.isFull());
+
+		tree.getCurrentNode()->setContainer(0);
+		addChild(tree, 1);
+		addChild(tree, 2);
+		CHECK(!tree.isFull());
+		addNeighbor(tree, 3);
+		CHECK(tree.isFull());
+
+		// Nodes over the size are dropped, links stay as they were
+		addChild(tree, 4);
+		addNeighbor(tree, 5);
+		CHECK(tree.isFull());
+		CHECK_EQUAL(2u, tree.getChildrenCount());
+		tree.moveMostRight();
+		CHECK_EQUAL(3, tree.getCurrentNode()->getContainer());
+		CHECK(tree.isMostBottom());
+
+		// destroy() leaves the only top node
+		tree.destroy();
+		CHECK(!tree.isFull());
+		CHECK(tree.isMostTop() && tree.isMostLeft() && tree.isMostRight());
+		CHECK_EQUAL(0u, tree.getChildrenCount());
+	}
+}
+
+int main()
+{
+	checkCallbacksTable();
+	checkLinks();
+	checkFull();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+
+#include <UsbPackageFactory.h>
+
+#include "alloc_stats.h"
+#include "host_test.h"
+#include "report_stream.h"
+
+using namespace UsbPackages;
+
+// 64 KB of text typed as one lazy job: every report of the stream is
+// compared with the one made from its char, the job takes no heap
+// and a single ring slot whatever the text length is.
+namespace {
+	const size_t TEXT_LENGTH = 64 * 1024;
+
+	std::string makeText()
+	{
+		std::string text(TEXT_LENGTH, ' ');
+		uint32_t state = 12345;
+		for (char& symbol : text) {
+			state = state * 1103515245u + 12345u;
+			symbol = ' ' + (state >> 16) % ('~' - ' ' + 1);
+		}
+		return text;
+	}
+
+	UsbPackage makePress(char symbol)
+	{
+		Key key(static_cast<AsciiCodeType>(symbol));
+
+		UsbPackage report = ZERO_PACKAGE;
+		report.special = key.getUsbKeyModifier();
+		report.key[0] = key.getUsbKey();
+		return report;
+	}
+
+	void checkText()
+	{
+		static_assert(CURRENT_TYPING_PROFILE.keysPerReport == 1,
+					  "Reports are made for one key per report");
+
+		std::string text = makeText();
+		HostReports::Ring ring;
+		PackageFactory factory(&ring);
+		HostReports::Reports reports;
+		reports.reserve(TEXT_LENGTH * 2 + 1);
+
+		size_t heapBefore = AllocStats::current();
+		factory.processData(text.data(), text.size());
+		CHECK_EQUAL(1u, ring.getHighWaterMark());
+		CHECK_EQUAL(heapBefore, AllocStats::current());
+
+		HostTest::Stopwatch stopwatch;
+		HostReports::drain(ring, reports);
+		double seconds = stopwatch.seconds();
+
+		// Every char is [release, press], the last press is released
+		CHECK_EQUAL(TEXT_LENGTH * 2 + 1, reports.size());
+		size_t mismatchesCount = 0;
+		for (size_t i = 0; i < TEXT_LENGTH && reports.size() == TEXT_LENGTH * 2 + 1; ++i) {
+			mismatchesCount += (reports[i * 2] != ZERO_PACKAGE);
+			mismatchesCount += (reports[i * 2 + 1] != makePress(text[i]));
+		}
+		CHECK_EQUAL(0u, mismatchesCount);
+		CHECK(HostReports::isReleased(reports));
+		CHECK(HostReports::decode(reports) == text);
+		CHECK(ring.isIdle());
+
+		std::printf("%zu chars: %zu reports, %.1f ns per report\n",
+					text.size(), reports.size(), seconds * 1e9 / reports.size());
+	}
+}
+
+int main()
+{
+	checkText();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,271 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <UsbPackageFactory.h>
+
+#include "host_keyboard.h"
+#include "host_test.h"
+
+using namespace UsbPackages;
+
+// Typing speed of the profile this test is built with: text is typed
+// through the endpoint to a simulated host which handles reports at
+// once, in boot and report protocol. Host must get the text exactly.
+// A slow host with a short queue loses reports unless typing is paced,
+// user's passthrough reports are never paced. A search step replaces
+// only the changed tail of the shown point.
+namespace {
+	const char* PROFILE_NAMES[] = {"CONSERVATIVE", "PACKED", "TUNED", "PACED", "NKRO"};
+
+	std::string makeText()
+	{
+		const char* PHRASES[] = {
+			"The quick brown fox jumps over the lazy dog. ",
+			"Mississippi bookkeeper 0123456789 ",
+			"P@ssw0rd!#$%^&*()_+{}|:\"<>? ",
+			"user.name@example.com\t"
+		};
+
+		std::string text;
+		for (size_t i = 0; text.size() < 4000; ++i) {
+			text += PHRASES[i % 4];
+		}
+		return text;
+	}
+
+	double type(const std::string& text, bool isReportProtocol)
+	{
+		HostReports::Ring ring;
+		PackageFactory factory(&ring);
+		HostReports::HostOptions options;
+		options.isReportProtocol = isReportProtocol;
+		HostReports::HostKeyboard host(ring, options);
+
+		factory.processData(text.data(), text.size());
+		CHECK(host.run(10 * 60 * 1000));
+		CHECK(host.getText() == text);
+		CHECK_EQUAL(0u, host.getLostCount());
+		CHECK(HostReports::isReleased(host.getReports()));
+
+		double cps = text.size() * 1000.0 / host.getNowMs();
+
+		// Nothing new and infinite idle: the endpoint NAKs, no duplicates
+		size_t reportsCount = host.getReports().size();
+		for (uint32_t i = 0; i < 1000; ++i) {
+			host.step();
+		}
+		CHECK_EQUAL(reportsCount, host.getReports().size());
+		CHECK_EQUAL(reportsCount, (size_t)host.getEndpoint().getStats().sentCount);
+		std::printf("%-12s %-6s protocol: %6zu reports, %7.1f chars/s\n",
+					PROFILE_NAMES[TYPING_PROFILE], isReportProtocol ? "report" : "boot",
+					host.getReports().size(), cps);
+		return cps;
+	}
+
+	void checkProfile()
+	{
+		std::string text = makeText();
+
+		// One key per report is a press and a release per poll each
+		double oneKeyCps = 1000.0 / (2 * CURRENT_TYPING_PROFILE.pollInterval);
+
+		double bootCps = type(text, false);
+		double reportCps = type(text, true);
+
+		if (CURRENT_TYPING_PROFILE.isPaced) {
+			CHECK(bootCps > oneKeyCps * 0.5);
+		}
+		else if (CURRENT_TYPING_PROFILE.keysPerReport == 1) {
+			CHECK(bootCps > oneKeyCps * 0.95 && bootCps <= oneKeyCps);
+		}
+		else {
+			CHECK(bootCps > oneKeyCps * 1.2);
+		}
+
+		// Report protocol differs by the bitmap report only
+		if (CURRENT_TYPING_PROFILE.hasBitmapReport) {
+			CHECK(reportCps > oneKeyCps * 1.2);
+		}
+		else {
+			CHECK(reportCps == bootCps);
+		}
+	}
+
+	void checkSlowHost()
+	{
+		std::string text = makeText();
+
+		// Remote desktop handles a report each 20 ms and drops what
+		// doesn't fit into its queue
+		HostReports::Ring ring;
+		PackageFactory factory(&ring);
+		HostReports::HostOptions options;
+		options.handleIntervalMs = 20;
+		options.queueSize = 16;
+		HostReports::HostKeyboard host(ring, options);
+
+		factory.processData(text.data(), text.size());
+		CHECK(host.run(10 * 60 * 1000));
+
+		std::printf("%-12s slow host:       %6zu lost,    %7.1f chars/s\n",
+					PROFILE_NAMES[TYPING_PROFILE], host.getLostCount(),
+					text.size() * 1000.0 / host.getNowMs());
+
+		if (CURRENT_TYPING_PROFILE.isPaced) {
+			CHECK(host.getText() == text);
+			CHECK_EQUAL(0u, host.getLostCount());
+			CHECK_EQUAL(0, host.getLeds());  // user's Scroll Lock is restored
+		}
+		else {
+			CHECK(host.getLostCount() > 0);
+		}
+	}
+
+	void checkPassthrough()
+	{
+		const char* TYPED = "typed before the user's keys";
+		const size_t USER_KEYS_COUNT = 100;
+
+		HostReports::Ring ring;
+		PackageFactory factory(&ring);
+		HostReports::HostKeyboard host(ring, HostReports::HostOptions());
+
+		factory.processData(TYPED, std::strlen(TYPED));
+		CHECK(host.run(60 * 1000));
+		size_t startCount = host.getReports().size();
+
+		// User presses a key each two polls, every report is sent at once
+		std::string text = TYPED;
+		for (size_t i = 0; i < USER_KEYS_COUNT; ++i) {
+			char symbol = 'a' + i % 26;
+			UsbPackage package = ZERO_PACKAGE;
+			package.key[0] = Key((AsciiCodeType)symbol).getUsbKey();
+			text += symbol;
+
+			factory.generatePackage(package.data());
+			factory.generateEmptyPackage();
+
+			for (uint32_t ms = 0; ms < 2 * CURRENT_TYPING_PROFILE.pollInterval; ++ms) {
+				host.step();
+			}
+			CHECK(host.isDone());
+		}
+
+		const HostReports::Reports& reports = host.getReports();
+		CHECK(host.getText() == text);
+		CHECK_EQUAL(startCount + 2 * USER_KEYS_COUNT, reports.size());
+
+		for (size_t i = startCount; i < reports.size(); ++i) {
+			CHECK(reports[i].key[0] != UsbKey::KEY_SCROLL_LOCK);
+		}
+	}
+
+	// Typed reports and ms of typing after the text already typed,
+	// pacer's probes and their releases aren't counted
+	size_t typeMore(HostReports::HostKeyboard& host, uint32_t* ms)
+	{
+		const HostReports::Reports& reports = host.getReports();
+		size_t startCount = reports.size();
+		uint32_t startMs = host.getNowMs();
+		CHECK(host.run(60 * 1000));
+		*ms = host.getNowMs() - startMs;
+
+		size_t count = 0;
+		for (size_t i = startCount; i < reports.size(); ++i) {
+			bool isProbe = (reports[i].key[0] == UsbKey::KEY_SCROLL_LOCK) ||
+				(i > 0 && reports[i - 1].key[0] == UsbKey::KEY_SCROLL_LOCK);
+			count += isProbe ? 0 : 1;
+		}
+		return (count);
+	}
+
+	void checkReplace()
+	{
+		const std::string OLD_NAME = "Work/GitLab admin";
+		const std::string NEW_NAME = "Work/GitLab deploy";
+		const size_t ERASED_COUNT = 5;  // "admin"
+		const std::string TAIL = "deploy";
+
+		auto view = [](const std::string& text) {
+			return (basic_string_view<uint8_t>((const uint8_t*)text.data(), text.size()));
+		};
+
+		// Erased tail and the new tail, each typed alone
+		uint32_t ms = 0;
+		size_t separateCount = 0;
+		{
+			HostReports::Ring ring;
+			PackageFactory factory(&ring);
+			HostReports::HostKeyboard host(ring, HostReports::HostOptions());
+			factory.generateClearSequence(ERASED_COUNT);
+			separateCount += typeMore(host, &ms);
+			factory.processData(TAIL.data(), TAIL.size());
+			separateCount += typeMore(host, &ms);
+		}
+
+		HostReports::Ring ring;
+		PackageFactory factory(&ring);
+		HostReports::HostKeyboard host(ring, HostReports::HostOptions());
+
+		factory.processData(OLD_NAME.data(), OLD_NAME.size());
+		uint32_t oldMs = 0;
+		size_t oldCount = typeMore(host, &oldMs);
+
+		factory.replaceData(view(OLD_NAME), view(NEW_NAME));
+		size_t replaceCount = typeMore(host, &ms);
+
+		CHECK(host.getText() == OLD_NAME + std::string(ERASED_COUNT, '\b') + TAIL);
+		CHECK(HostReports::isReleased(host.getReports()));
+		CHECK_EQUAL(separateCount, replaceCount);
+		CHECK(replaceCount < oldCount + separateCount);
+		if (CURRENT_TYPING_PROFILE.keysPerReport == 1 && !CURRENT_TYPING_PROFILE.isPaced) {
+			// Each of two jobs starts by the empty report,
+			// then a press and a release of every key
+			CHECK_EQUAL(2 + 2 * (ERASED_COUNT + TAIL.size()), replaceCount);
+		}
+
+		// The same name again changes nothing
+		factory.replaceData(view(NEW_NAME), view(NEW_NAME));
+		uint32_t sameMs = 0;
+		CHECK_EQUAL(0u, typeMore(host, &sameMs));
+
+		std::printf("%-12s replace:         %6zu reports, %7u ms per step "
+					"(%u ms to type the name)\n",
+					PROFILE_NAMES[TYPING_PROFILE], replaceCount, ms, oldMs);
+	}
+}
+
+int main()
+{
+	checkProfile();
+	checkSlowHost();
+	checkPassthrough();
+	checkReplace();
+
+	return HostTest::exit();
+}
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <usb_ring.h>
+
+#include "host_test.h"
+
+using namespace UsbPackages;
+
+// Producer and consumer of the typing ring in two threads: groups of
+// jobs are seen whole and in order, a group that doesn't fit is
+// dropped whole and counted as an overflow.
+namespace {
+	const uint32_t GROUPS_COUNT = 1000000;
+	const uint32_t MAX_GROUP_SIZE = 9;
+
+	using Ring = UsbRingStandart;
+
+	struct Mark {
+		uint32_t group;
+		uint8_t index;
+		uint8_t size;
+	};
+
+	UsbPackage makePackage(const Mark& mark)
+	{
+		UsbPackage package = ZERO_PACKAGE;
+		std::memcpy(package.key, &mark, sizeof(Mark::group) + 2);
+		return package;
+	}
+
+	Mark readPackage(const UsbPackage& package)
+	{
+		Mark mark;
+		std::memcpy(&mark, package.key, sizeof(Mark::group) + 2);
+		return mark;
+	}
+
+	struct Consumed {
+		uint32_t groupsCount;
+		uint32_t errorsCount;
+	};
+
+	void consume(Ring& ring, std::atomic<bool>& isProduced, Consumed& consumed)
+	{
+		uint32_t lastGroup = UINT32_MAX;
+		uint32_t nextIndex = 0;
+		uint32_t size = 0;
+
+		for (;;) {
+			if (ring.empty()) {
+				if (isProduced.load(std::memory_order_acquire) && ring.empty()) {
+					break;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+
+			Mark mark = readPackage(ring.front().getPackage());
+			ring.pop_front();
+
+			if (nextIndex == 0) {
+				// New group starts from its first job after the last group
+				if (mark.index != 0 || (lastGroup != UINT32_MAX && mark.group <= lastGroup)) {
+					consumed.errorsCount++;
+				}
+				lastGroup = mark.group;
+				size = mark.size;
+			}
+			else if (mark.group != lastGroup || mark.index != nextIndex) {
+				consumed.errorsCount++;
+			}
+
+			nextIndex = (mark.index + 1u == size) ? 0 : mark.index + 1u;
+			if (nextIndex == 0) {
+				consumed.groupsCount++;
+			}
+		}
+
+		if (nextIndex != 0) {
+			consumed.errorsCount++;
+		}
+	}
+
+	void checkStress()
+	{
+		static Ring ring;
+		std::atomic<bool> isProduced(false);
+		Consumed consumed = {0, 0};
+
+		std::thread consumer(consume, std::ref(ring), std::ref(isProduced), std::ref(consumed));
+
+		HostTest::Stopwatch stopwatch;
+		for (uint32_t group = 0; group < GROUPS_COUNT; ++group) {
+			// Most groups wait for room as the main loop does. Every 16th
+			// is about the ring size and is pushed while the consumer still
+			// has the previous ones, or when it's idle. Those longer than
+			// the ring never fit.
+			bool isBurst = (group % 16 == 0);
+			uint8_t size = isBurst ?
+					Ring::SIZE - 4 + (group / 16) % MAX_GROUP_SIZE :
+					1 + group % MAX_GROUP_SIZE;
+
+			while (isBurst ? ((group / 16) % 2 == 0 && !ring.isIdle()) :
+							 (ring.getFreeCount() < size))
+			{
+				std::this_thread::yield();
+			}
+			for (uint8_t index = 0; index < size; ++index) {
+				ring.push_back().setPackage(makePackage({group, index, size}));
+			}
+			ring.commit();
+		}
+		isProduced.store(true, std::memory_order_release);
+		consumer.join();
+		double seconds = stopwatch.seconds();
+
+		CHECK_EQUAL(0u, consumed.errorsCount);
+		CHECK_EQUAL(GROUPS_COUNT, consumed.groupsCount + ring.getOverflowsCount());
+		CHECK(ring.isIdle());
+		CHECK(ring.getHighWaterMark() <= Ring::SIZE);
+
+		std::printf("%u groups in %.2f s: %zu dropped, high water mark %zu of %zu\n",
+					GROUPS_COUNT, seconds, ring.getOverflowsCount(),
+					ring.getHighWaterMark(), Ring::SIZE);
+	}
+}
+
+int main()
+{
+	checkStress();
+
+	return HostTest::exit();
+}
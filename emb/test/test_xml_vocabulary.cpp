@@ -0,0 +1,108 @@
+/*
+ * This file is part of the pastilda project.
+ * hosted at http://github.com/thirdpin/pastilda
+ *
+ * Copyright (C) 2016  Third Pin LLC
+ *
+ * Written by:
+ *  Anastasiia Lazareva <a.lazareva@thirdpin.ru>
+ *	Dmitrii Lisin <mrlisdim@ya.ru>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include <database/xmlindex/XmlVocabulary.h>
+
+#include "host_test.h"
+
+using DB::XmlVocabulary;
+using DB::XmlWord;
+
+// Every KeePass word of the index hashes to a slot of its own and is
+// found; other names of the KeePass xml, case variants, prefixes and
+// names falling into a used slot are not.
+namespace {
+	struct Word {
+		const char* text;
+		XmlWord word;
+	};
+
+	const Word WORDS[] = {
+		{"Group", XmlWord::GROUP},
+		{"Entry", XmlWord::ENTRY},
+		{"String", XmlWord::STRING},
+		{"Key", XmlWord::KEY},
+		{"Value", XmlWord::VALUE},
+		{"Name", XmlWord::NAME},
+		{"AutoType", XmlWord::AUTO_TYPE},
+		{"DefaultSequence", XmlWord::DEFAULT_SEQUENCE},
+		{"DefaultAutoTypeSequence", XmlWord::DEFAULT_AUTO_TYPE_SEQUENCE},
+		{"Title", XmlWord::TITLE},
+		{"UserName", XmlWord::USER_NAME},
+		{"Password", XmlWord::PASSWORD},
+		{"Type", XmlWord::TYPE}
+	};
+
+	void checkWords()
+	{
+		bool isSlotUsed[XmlVocabulary::SLOTS_COUNT] = {false};
+
+		for (const Word& word : WORDS) {
+			size_t slot = XmlVocabulary::hash(word.text, std::strlen(word.text));
+			CHECK(slot < XmlVocabulary::SLOTS_COUNT);
+			CHECK(isSlotUsed[slot] == false);
+			isSlotUsed[slot] = true;
+
+			CHECK(XmlVocabulary::find(word.text) == word.word);
+		}
+	}
+
+	void checkUnknownNames()
+	{
+		const char* const NAMES[] = {
+			// Other elements and keys of KeePass files
+			"KeePassFile", "Meta", "Root", "UUID", "IconID", "Notes", "URL",
+			"Times", "LastModificationTime", "IsExpanded", "EnableAutoType",
+			"Enabled", "DataTransferObfuscation", "Association", "Window",
+			"KeystrokeSequence", "History", "Binary", "Tags", "DeletedObjects",
+			// Case variants, prefixes and extensions of the words
+			"group", "ENTRY", "title", "Username", "Grou", "Groups", "Ke", "Keys",
+			"Typ", "Types", "Passwor", "DefaultAutoTypeSequenc",
+			// Same slot and length as a word
+			"Tame", "Tyre", "Gloup", "Kay",
+			""
+		};
+
+		for (const char* name : NAMES) {
+			if (!CHECK(XmlVocabulary::find(name) == XmlWord::UNKNOWN)) {
+				std::printf("  \"%s\" is found\n", name);
+			}
+		}
+
+		// Names that collide are really in a used slot
+		CHECK_EQUAL(XmlVocabulary::hash("Type", 4), XmlVocabulary::hash("Tame", 4));
+		CHECK_EQUAL(XmlVocabulary::hash("Group", 5), XmlVocabulary::hash("Gloup", 5));
+		CHECK_EQUAL(XmlVocabulary::hash("Key", 3), XmlVocabulary::hash("Kay", 3));
+	}
+}
+
+int main()
+{
+	checkWords();
+	checkUnknownNames();
+
+	return HostTest::exit();
+}